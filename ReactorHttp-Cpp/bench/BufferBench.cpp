@@ -0,0 +1,127 @@
+// Buffer 收发大块数据的吞吐量测试: 模拟客户端上传一个很大的 POST 请求体, 以及服务器发送大文件
+// 用法: ./buffer_bench [请求体大小(MB)]
+#include "Buffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+static double elapsedSeconds(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// 客户端: 发送请求头和 bodySize 字节的请求体
+static void uploadClient(int fd, size_t bodySize)
+{
+    char header[256];
+    int len = snprintf(header, sizeof(header),
+        "POST /upload HTTP/1.1\r\nHost: localhost\r\nContent-Length: %zu\r\n\r\n", bodySize);
+    send(fd, header, len, MSG_NOSIGNAL);
+    vector<char> chunk(64 * 1024, 'x');
+    size_t left = bodySize;
+    while (left > 0)
+    {
+        ssize_t n = send(fd, chunk.data(), min(left, chunk.size()), MSG_NOSIGNAL);
+        if (n <= 0)
+        {
+            break;
+        }
+        left -= n;
+    }
+}
+
+// 服务器接收请求体, 每次只消费完整的 4k 块, 剩下的不完整的部分留在缓冲区中等待后续的数据
+static bool benchUpload(size_t bodySize)
+{
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    thread client(uploadClient, fds[1], bodySize);
+
+    Buffer* readBuf = new Buffer(10240);
+    auto start = chrono::steady_clock::now();
+    bool headerDone = false;
+    size_t received = 0;
+    while (received < bodySize)
+    {
+        if (readBuf->socketRead(fds[0]) <= 0)
+        {
+            break;
+        }
+        if (!headerDone)
+        {
+            char* end = (char*)memmem(readBuf->data(), readBuf->readableSize(), "\r\n\r\n", 4);
+            if (end == nullptr)
+            {
+                continue;
+            }
+            readBuf->readPosIncrease(end + 4 - readBuf->data());
+            headerDone = true;
+        }
+        size_t readable = readBuf->readableSize();
+        size_t consume = received + readable == bodySize ? readable : readable - readable % 4096;
+        received += consume;
+        readBuf->readPosIncrease(consume);
+    }
+    double seconds = elapsedSeconds(start);
+    client.join();
+    printf("upload   %8zu MB  %8.1f MB/s\n", bodySize >> 20, (bodySize >> 20) / seconds);
+    delete readBuf;
+    close(fds[0]);
+    close(fds[1]);
+    return received == bodySize;
+}
+
+// 服务器发送 fileSize 字节的响应, 每次向缓冲区中追加 4000 字节之后发送一次, 和 sendFile 的用法一样
+static bool benchDownload(size_t fileSize)
+{
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    size_t received = 0;
+    thread client([&]() {
+        vector<char> buf(64 * 1024);
+        ssize_t n = 0;
+        while (received < fileSize && (n = recv(fds[1], buf.data(), buf.size(), 0)) > 0)
+        {
+            received += n;
+        }
+    });
+
+    Buffer* sendBuf = new Buffer(10240);
+    vector<char> block(4000, 'y');
+    auto start = chrono::steady_clock::now();
+    size_t left = fileSize;
+    while (left > 0)
+    {
+        size_t len = min(left, block.size());
+        sendBuf->appendString(block.data(), len);
+        left -= len;
+        sendBuf->sendData(fds[0]);
+    }
+    while (sendBuf->readableSize() > 0)
+    {
+        sendBuf->sendData(fds[0]);
+    }
+    client.join();
+    double seconds = elapsedSeconds(start);
+    printf("download %8zu MB  %8.1f MB/s\n", fileSize >> 20, (fileSize >> 20) / seconds);
+    delete sendBuf;
+    close(fds[0]);
+    close(fds[1]);
+    return received == fileSize;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t size = (argc > 1 ? strtoull(argv[1], nullptr, 10) : 1024) << 20;
+    if (!benchUpload(size) || !benchDownload(size))
+    {
+        printf("data lost\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+// 反应堆事件分发的测试: 大量空闲连接 + 一部分活跃连接, 统计反应堆线程处理每个事件的平均 CPU 时间
+// (epoll_wait + 查找 channel + 回调中的 read), 不包括发送数据的线程
+// 用法: ./dispatch_bench                                   四种 IO 多路复用模型在不同连接数下的对比
+//       ./dispatch_bench 空闲连接数 活跃连接数 轮数 [epoll|poll|select|uring]
+// 每个连接是一对 socketpair, 需要 2 个文件描述符, select 只能检测小于 1024 的 fd, poll 最多检测 1024 个 fd
+#include "EventLoop.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static atomic<long> g_events(0);
+
+static int onRead(void* arg)
+{
+    int fd = (int)(long)arg;
+    char buf[64];
+    read(fd, buf, sizeof(buf));
+    g_events.fetch_add(1, memory_order_relaxed);
+    return 0;
+}
+
+static const char* g_names[] = { "epoll", "poll", "select", "uring" };
+
+// 每种模型最多能够检测的连接数, 反应堆自己还有一个用于唤醒的 socketpair
+static int maxConnections(DispatcherType type)
+{
+    if (type == DispatcherType::Select)
+    {
+        return (1024 - 16) / 2;
+    }
+    if (type == DispatcherType::Poll)
+    {
+        return 1024 - 16;
+    }
+    return 1 << 30;
+}
+
+// 测试一种组合, 反应堆没有退出的接口, 测试完直接结束进程
+static int runBench(DispatcherType type, int idle, int active, int rounds)
+{
+    int total = idle + active;
+    if (total > maxConnections(type))
+    {
+        printf("%-6s  connections %6d  active %5d  不支持\n", g_names[(int)type], total, active);
+        return 1;
+    }
+
+    // 尽量提高文件描述符的上限
+    struct rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    if ((long)limit.rlim_cur < total * 2L + 64)
+    {
+        printf("文件描述符的上限 %ld 不够, 需要 %ld, 请减少连接数\n", (long)limit.rlim_cur, total * 2L + 64);
+        return 1;
+    }
+
+    // 反应堆运行在子线程中
+    EventLoop* evLoop = nullptr;
+    mutex m;
+    condition_variable cond;
+    thread loopThread([&]() {
+        EventLoop* loop = new EventLoop("BenchLoop", type);
+        {
+            lock_guard<mutex> locker(m);
+            evLoop = loop;
+        }
+        cond.notify_one();
+        loop->run();
+    });
+    {
+        unique_lock<mutex> locker(m);
+        cond.wait(locker, [&]() { return evLoop != nullptr; });
+    }
+
+    // 先创建空闲连接, 活跃连接的 fd 比较大, 分散在整个 fd 的范围中
+    vector<int> peers;
+    peers.reserve(total);
+    for (int i = 0; i < total; ++i)
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1)
+        {
+            perror("socketpair");
+            _exit(1);
+        }
+        Channel* channel = new Channel(fds[0], FDEvent::ReadEvent, onRead, nullptr, nullptr, (void*)(long)fds[0]);
+        evLoop->addTask(channel, ElemType::ADD);
+        peers.push_back(fds[1]);
+    }
+
+    // 等待所有的连接都添加到反应堆中
+    this_thread::sleep_for(chrono::milliseconds(500));
+    clockid_t loopClock;
+    pthread_getcpuclockid(loopThread.native_handle(), &loopClock);
+    auto cpuTime = [&]() {
+        struct timespec ts;
+        clock_gettime(loopClock, &ts);
+        return ts.tv_sec * 1e9 + ts.tv_nsec;
+    };
+
+    // 每一轮给所有的活跃连接各发送一个字节, 等待反应堆处理完
+    auto start = chrono::steady_clock::now();
+    double cpuStart = cpuTime();
+    long expected = 0;
+    for (int r = 0; r < rounds; ++r)
+    {
+        for (int i = idle; i < total; ++i)
+        {
+            write(peers[i], "x", 1);
+        }
+        expected += active;
+        while (g_events.load(memory_order_relaxed) < expected)
+        {
+            this_thread::yield();
+        }
+    }
+    double cpu = cpuTime() - cpuStart;
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    printf("%-6s  connections %6d  active %5d  events %8ld  loop cpu %7.1f ns/event  wall %7.1f ns/event\n",
+        g_names[(int)type], total, active, expected, cpu / expected, ns / expected);
+    fflush(stdout);
+    _exit(0);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 3)
+    {
+        DispatcherType type = DispatcherType::Epoll;
+        if (argc > 4 && !EventLoop::parseDispatcherType(argv[4], type))
+        {
+            printf("未知的 IO 多路复用模型: %s\n", argv[4]);
+            return 1;
+        }
+        return runBench(type, atoi(argv[1]), atoi(argv[2]), atoi(argv[3]));
+    }
+
+    // 每种组合在单独的子进程中运行, 互不影响; 活跃连接占 10%, 每种组合处理的事件数差不多
+    const int connections[] = { 100, 500, 1000, 4000, 9000 };
+    const DispatcherType types[] = { DispatcherType::Epoll, DispatcherType::Poll,
+        DispatcherType::Select, DispatcherType::IoUring };
+    for (int total : connections)
+    {
+        int active = total / 10;
+        int rounds = min(max(100000 / active, 50), 5000);
+        for (DispatcherType type : types)
+        {
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                return runBench(type, total - active, active, rounds);
+            }
+            waitpid(pid, NULL, 0);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+// http 请求解析的微基准测试: 统计每个请求的内存分配次数和解析耗时
+// 用法: ./parser_bench [请求个数]
+#include "Buffer.h"
+#include "HttpRequest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <new>
+
+// 替换全局的 operator new, 统计分配次数
+static unsigned long long g_allocCount = 0;
+
+void* operator new(size_t size)
+{
+    ++g_allocCount;
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr)
+    {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+struct Sample
+{
+    const char* name;
+    const char* request;
+};
+
+// 真实浏览器和命令行工具发出的请求头
+static const Sample samples[] = {
+    { "curl",
+      "GET /index.html HTTP/1.1\r\n"
+      "Host: localhost:10000\r\n"
+      "User-Agent: curl/8.5.0\r\n"
+      "Accept: */*\r\n"
+      "\r\n" },
+    { "chrome",
+      "GET /static/js/app.3f2c9a1b.js HTTP/1.1\r\n"
+      "Host: www.example.com\r\n"
+      "Connection: keep-alive\r\n"
+      "sec-ch-ua: \"Chromium\";v=\"124\", \"Google Chrome\";v=\"124\", \"Not-A.Brand\";v=\"99\"\r\n"
+      "sec-ch-ua-mobile: ?0\r\n"
+      "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/124.0.0.0 Safari/537.36\r\n"
+      "sec-ch-ua-platform: \"Linux\"\r\n"
+      "Accept: */*\r\n"
+      "Sec-Fetch-Site: same-origin\r\n"
+      "Sec-Fetch-Mode: no-cors\r\n"
+      "Sec-Fetch-Dest: script\r\n"
+      "Referer: https://www.example.com/\r\n"
+      "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+      "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+      "Cookie: sessionid=8c1f0e4a7b2d4e6f9a3c5b7d1e0f2a4c; theme=dark; _ga=GA1.1.123456789.1700000000\r\n"
+      "If-None-Match: \"65f1c2a0-1d4c\"\r\n"
+      "\r\n" },
+    { "firefox",
+      "GET /%E6%96%87%E6%A1%A3/readme.txt HTTP/1.1\r\n"
+      "Host: www.example.com\r\n"
+      "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:125.0) Gecko/20100101 Firefox/125.0\r\n"
+      "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+      "Accept-Language: zh-CN,zh;q=0.8,zh-TW;q=0.7,en-US;q=0.5,en;q=0.3\r\n"
+      "Accept-Encoding: gzip, deflate, br\r\n"
+      "Connection: keep-alive\r\n"
+      "Upgrade-Insecure-Requests: 1\r\n"
+      "Sec-Fetch-Dest: document\r\n"
+      "Sec-Fetch-Mode: navigate\r\n"
+      "Sec-Fetch-Site: none\r\n"
+      "Sec-Fetch-User: ?1\r\n"
+      "\r\n" },
+};
+
+int main(int argc, char* argv[])
+{
+    int count = argc > 1 ? atoi(argv[1]) : 200000;
+    Buffer* readBuf = new Buffer(10240);
+    HttpRequest* request = new HttpRequest;
+    size_t checksum = 0;
+
+    for (auto& sample : samples)
+    {
+        // 预热: 让缓冲区和请求对象内部的内存都分配好
+        readBuf->appendString(sample.request);
+        request->parseHttpRequest(readBuf);
+        request->reset();
+
+        unsigned long long allocBefore = g_allocCount;
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            readBuf->appendString(sample.request);
+            if (!request->parseHttpRequest(readBuf) || request->getState() != PrecessState::ParseReqDone)
+            {
+                printf("%s: parse failed\n", sample.name);
+                return 1;
+            }
+            // 模拟 TcpConnection 对请求头的访问
+            checksum += request->getHeader("Host").size();
+            checksum += request->getHeader("Accept-Encoding").size();
+            checksum += request->keepAlive();
+            request->reset();
+        }
+        auto cost = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        unsigned long long allocs = g_allocCount - allocBefore;
+        printf("%-8s %8d requests  %6.2f allocs/request  %8.1f ns/request\n",
+            sample.name, count, static_cast<double>(allocs) / count, static_cast<double>(cost) / count);
+    }
+    printf("checksum: %zu\n", checksum);
+
+    delete request;
+    delete readBuf;
+    return 0;
+}
@@ -2,47 +2,61 @@
 #include <string>
 using namespace std;
 
+// 环形缓冲区: 容量是 2 的整数次幂, 读写位置只增不减, 和 m_mask 按位与得到在内存中的下标
+// 可读的数据最多分成两段, 接收和发送数据时通过 readv/writev 直接读写这两段内存
 class Buffer
 {
 public:
-    Buffer(int size);
+    Buffer(size_t size);
     ~Buffer();
 
-    // 扩容
-    void extendRoom(int size);
+    // 扩容: 保证至少有 size 字节可写的内存
+    void extendRoom(size_t size);
     // 得到剩余的可写的内存容量
-    inline int writeableSize()
+    inline size_t writeableSize()
     {
-        return m_capacity - m_writePos;
+        return m_capacity - readableSize();
     }
     // 得到剩余的可读的内存容量
-    inline int readableSize()
+    inline size_t readableSize()
     {
         return m_writePos - m_readPos;
     }
     // 写内存 1. 直接写 2. 接收套接字数据
-    int appendString(const char* data, int size);
+    int appendString(const char* data, size_t size);
     int appendString(const char* data);
     int appendString(const string data);
-    int socketRead(int fd);
+    // 返回读到的字节数, 出错(包括扩容失败)返回 -1
+    ssize_t socketRead(int fd);
     // 根据\r\n取出一行, 找到其在数据块中的位置, 返回该位置
     char* findCRLF();
     // 发送数据
-    int sendData(int socket);    // 指向内存的指针
-    // 得到读数据的起始位置
-    inline char* data()
-    {
-        return m_data + m_readPos;
-    }
-    inline int readPosIncrease(int count)
+    ssize_t sendData(int socket);
+    // 得到读数据的起始位置, 可读的数据绕回到了内存的开头时, 先把数据整理成连续的一块
+    char* data();
+    inline size_t readPosIncrease(size_t count)
     {
         m_readPos += count;
+        // 数据读完了, 从头开始写, 尽量避免数据绕回
+        if (m_readPos == m_writePos)
+        {
+            m_readPos = m_writePos = 0;
+        }
         return m_readPos;
     }
+private:
+    // 下标 pos 在内存中的位置
+    inline char* at(size_t pos)
+    {
+        return m_data + (pos & m_mask);
+    }
+    // 把可读的数据整理成从内存开头开始的一整块, 新的容量为 capacity
+    void linearize(size_t capacity);
+
 private:
     char* m_data;
-    int m_capacity;
-    int m_readPos = 0;
-    int m_writePos = 0;
+    size_t m_capacity;
+    size_t m_mask;
+    size_t m_readPos = 0;
+    size_t m_writePos = 0;
 };
-
@@ -16,7 +16,7 @@ public:
     // 修改
     virtual int modify();
     // 事件监测
-    virtual int dispatch(int timeout = 2); // 单位: s
+    virtual int dispatch(int timeout = 2000); // 单位: ms
     inline void setChannel(Channel* channel)
     {
         m_channel = channel;
@@ -1,20 +1,23 @@
 #pragma once
 #include "Dispatcher.h"
 #include "Channel.h"
+#include "TimerQueue.h"
 #include <thread>
-#include <queue>
-#include <map>
+#include <vector>
 #include <mutex>
+#include <atomic>
 using namespace std;
 
 // 处理该节点中的channel的方式
 enum class ElemType:char{ADD, DELETE, MODIFY};
-// 定义任务队列的节点
+// 定义任务队列的节点, 直接存储在任务队列的数组中
 struct ChannelElement
 {
     ElemType type;   // 如何处理该节点中的channel
     Channel* channel;
 };
+// 反应堆使用的 IO 多路复用模型
+enum class DispatcherType:char{Epoll, Poll, Select, IoUring};
 class Dispatcher;
 
 class EventLoop
@@ -22,6 +25,7 @@ class EventLoop
 public:
     EventLoop();
     EventLoop(const string threadName);
+    EventLoop(const string threadName, DispatcherType type);
     ~EventLoop();
     // 启动反应堆模型
     int run();
@@ -37,7 +41,12 @@ public:
     int modify(Channel* channel);
     // 释放channel
     int freeChannel(Channel* channel);
+    // 把 channel 从反应堆中摘下来, 不关闭 fd, 用于把连接迁移到其他反应堆, 只能在反应堆线程中调用
+    int detach(Channel* channel);
     int readMessage();
+    // 定时器: delay 毫秒之后在当前反应堆线程中执行 callback, 可以在任意线程调用
+    uint64_t addTimer(int delay, function<void()> callback);
+    void cancelTimer(uint64_t timerId);
     // 返回线程ID
     inline thread::id getThreadID()
     {
@@ -47,24 +56,57 @@ public:
     {
         return m_threadName;
     }
+    // 统计信息: 当前的连接数, 累计处理的事件数, 可以在任意线程读取
+    inline void connectionOpened()
+    {
+        m_connectionCount.fetch_add(1, memory_order_relaxed);
+    }
+    inline void connectionClosed()
+    {
+        m_connectionCount.fetch_sub(1, memory_order_relaxed);
+    }
+    inline int connectionCount()
+    {
+        return m_connectionCount.load(memory_order_relaxed);
+    }
+    inline uint64_t eventCount()
+    {
+        return m_eventCount.load(memory_order_relaxed);
+    }
     static int readLocalMessage(void* arg);
+    // 设置之后创建的反应堆默认使用的 IO 多路复用模型, 在启动服务器之前调用
+    static void setDefaultDispatcher(DispatcherType type);
+    // 根据名字(epoll, poll, select, uring)得到 IO 多路复用模型, 名字无效返回 false
+    static bool parseDispatcherType(const string& name, DispatcherType& type);
 
 private:
     void taskWakeup();
+    void processTask(const ChannelElement& task);
+    // 根据fd取出channel, 不存在返回 nullptr
+    inline Channel* getChannel(int fd)
+    {
+        return fd >= 0 && fd < (int)m_channels.size() ? m_channels[fd] : nullptr;
+    }
 
 private:
     bool m_isQuit;
-    // 该指针指向子类的实例 epoll, poll, select
+    // 该指针指向子类的实例 epoll, poll, select, io_uring
     Dispatcher* m_dispatcher;
-    // 任务队列
-    queue<ChannelElement*> m_taskQ;
-    // map
-    map<int, Channel*> m_channelMap;
+    // 任务队列: 其他线程添加的任务, 反应堆线程一次全部取出处理
+    vector<ChannelElement> m_taskQ;
+    // 以fd为下标的channel数组, fd是从小到大分配的, 数组是紧凑的
+    vector<Channel*> m_channels;
     // 线程id, name, mutex
     thread::id m_threadID;
     string m_threadName;
     mutex m_mutex;
     int m_socketPair[2];  // 存储本地通信的fd 通过socketpair 初始化
+    // 定时器, 决定 dispatch 的超时时长
+    TimerQueue* m_timerQueue;
+    // 没有定时器时 dispatch 的超时时长, 单位: ms
+    const int m_dispatchTimeout = 2000;
+    atomic<int> m_connectionCount{ 0 };
+    atomic<uint64_t> m_eventCount{ 0 };
 };
 
 
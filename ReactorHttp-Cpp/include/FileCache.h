@@ -0,0 +1,55 @@
+#pragma once
+#include <sys/stat.h>
+#include <string>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// 缓存的静态资源: 文件保存打开的文件描述符, 目录保存生成好的 html 列表
+struct FileEntry
+{
+    ~FileEntry();
+    struct stat st;
+    int fd = -1;
+    string listing;
+    string etag;
+    string lastModified;
+};
+
+// 静态资源缓存: 每个线程一个, 不需要加锁, 按最近最少使用的顺序淘汰
+// 缓存的文件和目录都通过 inotify 监视, 被修改、删除之后在下一次查询时从缓存中删除
+class FileCache
+{
+public:
+    FileCache(size_t maxEntries = 256);
+    ~FileCache();
+    // 得到当前线程的缓存
+    static FileCache* threadCache();
+    // 查找文件或目录, 不在缓存中的打开文件(生成目录列表)并添加到缓存, 不存在返回 nullptr
+    // 返回的对象在发送完数据之前一直有效, 即使已经被淘汰
+    shared_ptr<FileEntry> lookup(const string& path);
+
+private:
+    struct Node
+    {
+        shared_ptr<FileEntry> entry;
+        list<string>::iterator pos;
+        int wd;
+    };
+    // 读取所有的 inotify 事件, 删除失效的缓存
+    void processEvents();
+    void remove(const string& path);
+    shared_ptr<FileEntry> load(const string& path);
+    static void renderDir(const string& dirName, string& html);
+
+private:
+    size_t m_maxEntries;
+    int m_inotifyFd;
+    // 最近使用的在前面
+    list<string> m_lru;
+    unordered_map<string, Node> m_entries;
+    // 一个监视描述符可能对应多个路径(硬链接, "." 和 "./")
+    unordered_map<int, vector<string>> m_watches;
+};
@@ -0,0 +1,69 @@
+#pragma once
+#include "Buffer.h"
+#include "FileCache.h"
+#include <zlib.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+using namespace std;
+
+// 流式 gzip 压缩: 每次从文件中读取一块数据压缩, 压缩结果按照 chunked 编码的格式追加到缓冲区
+// 使用较小的滑动窗口和内部状态, 每个连接压缩时占用的内存约 64KB, 不随文件大小变化
+class GzipStream
+{
+public:
+    GzipStream(shared_ptr<FileEntry> file);
+    ~GzipStream();
+    inline bool isValid()
+    {
+        return m_valid;
+    }
+    // 压缩下一块数据并追加到 out, 压缩完整个文件之后追加 chunked 的结束标记, 读取文件失败返回 false
+    bool compressChunk(Buffer* out);
+    // 整个文件是否已经压缩完了
+    inline bool finished()
+    {
+        return m_finished;
+    }
+
+private:
+    z_stream m_stream;
+    shared_ptr<FileEntry> m_file;
+    off_t m_offset;
+    bool m_valid;
+    bool m_finished;
+    static const size_t m_chunkSize = 16 * 1024;
+};
+
+// 压缩结果缓存: 所有线程共用, 按照路径索引, etag(修改时间和大小)变化之后重新压缩
+// 热点的小文件只压缩一次, 总大小超过上限时按最近最少使用的顺序淘汰
+class GzipCache
+{
+public:
+    GzipCache(size_t maxBytes = 32 * 1024 * 1024);
+    // 得到进程中唯一的缓存
+    static GzipCache* instance();
+    // 得到 path 压缩之后的数据: 文件从 entry.fd 中读取, 目录压缩 entry.listing, 失败返回 nullptr
+    shared_ptr<const string> lookup(const string& path, const FileEntry& entry);
+    // 一次压缩一整块数据, 使用默认的窗口大小, 压缩率比流式压缩高
+    static bool compress(const string& data, string& out);
+
+private:
+    struct Node
+    {
+        string etag;
+        shared_ptr<const string> data;
+        list<string>::iterator pos;
+    };
+    void remove(const string& path);
+
+private:
+    mutex m_mutex;
+    size_t m_maxBytes;
+    size_t m_bytes;
+    // 最近使用的在前面
+    list<string> m_lru;
+    unordered_map<string, Node> m_entries;
+};
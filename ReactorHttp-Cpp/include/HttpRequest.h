@@ -2,7 +2,9 @@
 #include "Buffer.h"
 #include <stdbool.h>
 #include "HttpResponse.h"
-#include <map>
+#include "FileCache.h"
+#include <string_view>
+#include <vector>
 using namespace std;
 
 // 当前的解析状态
@@ -13,42 +15,68 @@ enum class PrecessState:char
     ParseReqBody,
     ParseReqDone
 };
+// 请求头: 键值都是指向 readBuf 中数据的视图
+struct HttpHeader
+{
+    string_view key;
+    string_view value;
+};
+
 // 定义http请求结构体
+// 请求行和请求头都不拷贝, 保存为指向 readBuf 的视图, 在下一次向 readBuf 写入数据之前有效
 class HttpRequest
 {
 public:
+    // 请求行和请求头的最大长度, 收到这么多数据还没有找到请求头的结尾就当作错误的请求
+    static constexpr size_t kMaxHeaderSize = 16 * 1024;
+
     HttpRequest();
     ~HttpRequest();
     // 重置
     void reset();
     // 添加请求头
-    void addHeader(const string key, const string value);
-    // 根据key得到请求头的value
-    string getHeader(const string key);
+    void addHeader(string_view key, string_view value);
+    // 根据key得到请求头的value, key 不区分大小写
+    string_view getHeader(string_view key);
     // 解析请求行
     bool parseRequestLine(Buffer* readBuf);
     // 解析请求头
     bool parseRequestHeader(Buffer* readBuf);
-    // 解析http请求协议
-    bool parseHttpRequest(Buffer* readBuf, HttpResponse* response, Buffer* sendBuf, int socket);
+    // 解析http请求协议: 解析出完整的请求之后状态为 ParseReqDone, 数据不完整时状态保持不变, 等待后续的数据
+    // 请求格式错误或者请求行加请求头超过 kMaxHeaderSize 返回 false
+    bool parseHttpRequest(Buffer* readBuf);
     // 处理http请求协议
     bool processHttpRequest(HttpResponse* response);
-    // 解码字符串
-    string decodeMsg(string from);
+    // 客户端是否要求保持连接: HTTP/1.1 默认保持, HTTP/1.0 需要 Connection: keep-alive
+    bool keepAlive();
+    // 请求是否带有请求体: Content-Length 不为 0 或者有 Transfer-Encoding
+    // 请求体不会被解析, 处理完这种请求之后只能断开连接, 否则请求体会被当成下一个请求
+    bool hasBody();
+    // 解码字符串, 结果写入 to
+    void decodeMsg(string_view from, string& to);
     const string getFileType(const string name);
-    static void sendDir(string dirName, Buffer* sendBuf, int cfd);
-    static void sendFile(string dirName, Buffer* sendBuf, int cfd);
-    inline void setMethod(string method)
+    // 客户端缓存的内容是否还是最新的: If-None-Match / If-Modified-Since
+    bool notModified(const string& etag, const string& lastModified);
+    // 客户端是否接受这种内容编码(gzip, br): Accept-Encoding 中列出了并且 q 不为 0
+    bool acceptsEncoding(string_view coding);
+    // 解析 Range 请求头: 0 - 没有 Range 或者忽略 Range, 发送完整的文件
+    // 1 - 发送 [start, end] 之间的数据, -1 - 请求的范围超出了文件的大小
+    int parseRange(const FileEntry& entry, off_t& start, off_t& end);
+    inline string_view getMethod()
+    {
+        return m_method;
+    }
+    inline string_view getUrl()
     {
-        m_method = method;
+        return m_url;
     }
-    inline void seturl(string url)
+    inline string_view getVersion()
     {
-        m_url = url;
+        return m_version;
     }
-    inline void setVersion(string version)
+    inline const vector<HttpHeader>& getHeaders()
     {
-        m_version = version;
+        return m_reqHeaders;
     }
     // 获取处理状态
     inline PrecessState getState()
@@ -61,15 +89,24 @@ public:
     }
 
 private:
-    char* splitRequestLine(const char* start, const char* end,
-        const char* sub, function<void(string)> callback);
+    const char* splitRequestLine(const char* start, const char* end,
+        const char* sub, string_view& token);
     int hexToDec(char c);
+    // 这种类型的数据压缩之后是否能明显变小
+    static bool isCompressible(const string& type);
+    // 查找普通文件, 不存在或者是目录返回 nullptr
+    static shared_ptr<FileEntry> lookupRegularFile(const string& path);
 
 private:
-    string m_method;
-    string m_url;
-    string m_version;
-    map<string, string> m_reqHeaders;
+    string_view m_method;
+    string_view m_url;
+    string_view m_version;
+    // 请求头表: 顺序存放, 按 key 线性查找, reset 时只清空不释放内存
+    vector<HttpHeader> m_reqHeaders;
+    // 解码之后的请求路径, 在请求之间复用内存
+    string m_path;
     PrecessState m_curState;
+    // 在 readBuf 中已经查找过请求头结尾的字节数, 收到新数据之后从这里继续查找
+    size_t m_scanned;
 };
 
@@ -1,7 +1,10 @@
 #pragma once
 #include "Buffer.h"
+#include "FileCache.h"
+#include "Gzip.h"
 #include <map>
-#include <functional>
+#include <memory>
+#include <sys/types.h>
 using namespace std;
 
 // 定义状态码枚举
@@ -9,10 +12,13 @@ enum class StatusCode
 {
     Unknown,
     OK = 200,
+    PartialContent = 206,
     MovedPermanently = 301,
     MovedTemporarily = 302,
+    NotModified = 304,
     BadRequest = 400,
-    NotFound = 404
+    NotFound = 404,
+    RangeNotSatisfiable = 416
 };
 
 // 定义结构体
@@ -21,32 +27,69 @@ class HttpResponse
 public:
     HttpResponse();
     ~HttpResponse();
-    function<void(const string, struct Buffer*, int)> sendDataFunc;
+    // 重置, 同一个连接上的每个请求都使用一个干净的响应
+    void reset();
     // 添加响应头
     void addHeader(const string key, const string value);
-    // 组织http响应数据
-    void prepareMsg(Buffer* sendBuf, int socket);
-    inline void setFileName(string name)
+    // 组织http响应数据: 状态行、响应头和内存中的响应体写入 sendBuf, 文件响应体之后通过 sendBody 发送
+    void prepareMsg(Buffer* sendBuf);
+    // 响应体: 内存中的数据(目录列表)
+    inline void setBody(const string& body)
     {
-        m_fileName = name;
+        m_body = body;
     }
+    // 响应体: 多个响应共用的内存中的数据(压缩缓存), 不拷贝到 sendBuf 中
+    void setSharedBody(shared_ptr<const string> body);
+    // 响应体: 文件中 [offset, offset + length) 的数据, 发送的时候直接从文件描述符拷贝到套接字
+    void setFileBody(shared_ptr<FileEntry> file, off_t offset, size_t length);
+    // 响应体: 边读取文件边 gzip 压缩, 使用 chunked 编码发送, 失败返回 false
+    bool setGzipBody(shared_ptr<FileEntry> file);
+    // 是否还有没有发送完的响应体(文件、共用的内存或者压缩流)
+    inline bool bodyPending()
+    {
+        return m_bodyRemaining > 0 || m_gzip != nullptr;
+    }
+    // 发送响应体, 最多发送 budget 字节, 返回值和 send 相同
+    ssize_t sendBody(int socket, size_t budget);
     inline void setStatusCode(StatusCode code)
     {
         m_statusCode = code;
     }
+    // 响应头中是否有 Content-length 或者使用了 chunked 编码, 没有的话客户端只能通过断开连接判断响应结束
+    // 304 没有响应体
+    inline bool hasContentLength()
+    {
+        return m_statusCode == StatusCode::NotModified
+            || m_headers.find("Content-length") != m_headers.end()
+            || m_headers.find("Transfer-Encoding") != m_headers.end();
+    }
+private:
+    // 发送压缩流中的数据, 压缩好的数据都发送出去之后再压缩下一块
+    ssize_t sendGzipBody(int socket);
+
 private:
     // 状态行: 状态码, 状态描述
     StatusCode m_statusCode;
-    string m_fileName;
+    string m_body;
+    shared_ptr<const string> m_sharedBody;
+    shared_ptr<FileEntry> m_file;
+    // 流式压缩和压缩好还没有发送的数据, 缓冲区在第一次压缩时创建
+    unique_ptr<GzipStream> m_gzip;
+    Buffer* m_gzipBuf;
+    off_t m_bodyOffset;
+    size_t m_bodyRemaining;
     // 响应头 - 键值对
     map<string, string> m_headers;
     // 定义状态码和描述的对应关系
     const map<int, string> m_info = {
         {200, "OK"},
+        {206, "PartialContent"},
         {301, "MovedPermanently"},
         {302, "MovedTemporarily"},
+        {304, "NotModified"},
         {400, "BadRequest"},
         {404, "NotFound"},
+        {416, "RangeNotSatisfiable"},
     };
 };
 
@@ -0,0 +1,90 @@
+#pragma once
+#include "Channel.h"
+#include "EventLoop.h"
+#include "Dispatcher.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+// 基于 io_uring 的事件分发: 每个 fd 提交一个单次的 IORING_OP_POLL_ADD, 完成之后在下一轮 dispatch 开始时重新提交
+// 提交和等待合并成一次 io_uring_enter 系统调用, 修改和删除事件不需要额外的系统调用
+// 内核不支持(或者编译时没有 io_uring 的头文件)时 isValid() 返回 false, 由 EventLoop 换成 epoll
+class IoUringDispatcher : public Dispatcher
+{
+public:
+    IoUringDispatcher(EventLoop* evloop);
+    ~IoUringDispatcher();
+    // io_uring 是否初始化成功
+    inline bool isValid()
+    {
+        return m_ringfd != -1;
+    }
+    // 添加
+    int add() override;
+    // 删除
+    int remove() override;
+    // 修改
+    int modify() override;
+    // 事件监测
+    int dispatch(int timeout = 2000) override; // 单位: ms
+
+private:
+    // 每个 fd 的注册状态, 以 fd 为下标
+    struct Registration
+    {
+        bool registered = false; // channel 是否在反应堆中
+        bool armed = false;      // 是否有还没有完成的 poll 请求
+        int events = 0;          // 检测的事件 POLLIN | POLLOUT
+        uint32_t generation = 0; // 每次提交和取消都加一, 用来丢弃过期的完成事件
+    };
+    bool setupRing();
+    void teardownRing();
+    Registration& registration(int fd);
+    // 提交 poll 请求 / 取消还没有完成的 poll 请求
+    // 提交队列满了 arm 返回 false, fd 放进 m_fired 在下一轮 dispatch 开始时重新提交
+    bool arm(int fd);
+    void disarm(int fd);
+    bool submitCancel(uint64_t token);
+    // 提交队列满了并且提交不出去的时候返回 nullptr
+    struct io_uring_sqe* getSqe();
+    // 完成事件中的 user_data: 高 32 位是 generation, 低 32 位是 fd
+    static inline uint64_t makeToken(int fd, uint32_t generation)
+    {
+        return ((uint64_t)generation << 32) | (uint32_t)fd;
+    }
+
+private:
+    int m_ringfd = -1;
+    // 提交队列
+    void* m_sqRing = nullptr;
+    size_t m_sqRingSize = 0;
+    unsigned* m_sqHead = nullptr;
+    unsigned* m_sqTail = nullptr;
+    unsigned* m_sqArray = nullptr;
+    unsigned m_sqMask = 0;
+    unsigned m_sqEntries = 0;
+    struct io_uring_sqe* m_sqes = nullptr;
+    size_t m_sqesSize = 0;
+    unsigned m_toSubmit = 0;
+    // 完成队列
+    void* m_cqRing = nullptr;
+    size_t m_cqRingSize = 0;
+    unsigned* m_cqHead = nullptr;
+    unsigned* m_cqTail = nullptr;
+    unsigned m_cqMask = 0;
+    struct io_uring_cqe* m_cqes = nullptr;
+
+    vector<Registration> m_registrations;
+    // 上一轮完成了的 fd 和提交队列满了没有提交成功的 fd, 在下一轮 dispatch 开始时重新提交
+    vector<int> m_fired;
+    // dispatch 重新提交时和 m_fired 交换, 两个数组的内存都可以复用
+    vector<int> m_rearming;
+    // 提交队列满了没有提交成功的 POLL_REMOVE, 在下一轮 dispatch 开始时重新提交
+    vector<uint64_t> m_cancels;
+    const unsigned m_sqSize = 1024;
+    const unsigned m_cqSize = 8192;
+};
@@ -5,18 +5,41 @@
 #include "HttpRequest.h"
 #include "HttpResponse.h"
 
-//#define MSG_SEND_AUTO
+class ThreadPool;
 
 class TcpConnection
 {
 public:
-    TcpConnection(int fd, EventLoop* evloop);
+    // idleTimeout: 连接空闲多久之后断开, 单位: ms
+    // maxRequests: 一个连接上最多处理的请求数, 达到之后回复 Connection: close 并断开
+    // threadPool: 不为空时, 繁忙的子线程可以把这个连接迁移到空闲的子线程
+    TcpConnection(int fd, EventLoop* evloop, int idleTimeout = 5000, int maxRequests = 100,
+        ThreadPool* threadPool = nullptr);
     ~TcpConnection();
 
     static int processRead(void* arg);
     static int processWrite(void* arg);
     static int destroy(void* arg);
 private:
+    // 处理 readBuf 中所有完整的请求, 遇到需要发送文件的响应就停下来, 返回是否产生了新的响应
+    bool processRequests();
+    // 处理一个解析完成的请求, 组织响应数据写入 writeBuf
+    void processRequest();
+    // 发送 writeBuf 和文件响应体, 每次最多发送 kWriteBudget 字节, 没发完的等待写事件继续发送
+    // 需要断开连接时删除 channel, 之后不能再访问 this
+    void sendPending();
+    // 空闲定时器到期: 空闲时间超过 m_idleTimeout, 或者一个不完整的请求等待了 m_idleTimeout 还没有收完,
+    // 就断开连接, 否则重新设置定时器
+    void checkIdle();
+    // 两个请求之间, 处理了很多请求的长连接所在的子线程太忙时, 把连接迁移到最空闲的子线程
+    // 迁移之后连接属于目标反应堆, 返回 true 之后当前线程不能再访问 this
+    bool migrate();
+
+private:
+    // 每次读写事件最多发送的字节数
+    static const size_t kWriteBudget = 1024 * 1024;
+    // 连接(上一次迁移之后)处理了这么多请求才算作长时间活跃的连接, 可以迁移
+    static const int kHotRequests = 8;
     string m_name;
     EventLoop* m_evLoop;
     Channel* m_channel;
@@ -25,4 +48,15 @@ private:
     // http 协议
     HttpRequest* m_request;
     HttpResponse* m_response;
-};
\ No newline at end of file
+    // keep-alive
+    int m_idleTimeout;
+    int m_maxRequests;
+    int m_requestCount;
+    bool m_keepAlive;       // 最近一个响应之后是否保持连接
+    bool m_responding;      // 最近一个响应是否还没有发送完
+    int64_t m_lastActive;   // 最近一次收到数据的时间, 单位: ms
+    int64_t m_requestStart; // readBuf 中不完整的请求开始等待的时间, 没有不完整的请求时为 0, 单位: ms
+    uint64_t m_idleTimerId;
+    ThreadPool* m_threadPool;
+    int m_migratedAt;       // 上一次迁移时已经处理的请求数
+};
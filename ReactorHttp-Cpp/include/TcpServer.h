@@ -10,13 +10,53 @@ public:
     void setListen();
     // 启动服务器
     void run();
+    // keep-alive: 连接空闲 idleTimeout 毫秒之后断开, 一个连接上最多处理 maxRequests 个请求
+    inline void setKeepAlive(int idleTimeout, int maxRequests)
+    {
+        m_idleTimeout = idleTimeout;
+        m_maxRequests = maxRequests;
+    }
+    // SO_REUSEPORT: 每个子线程有自己的监听套接字, 内核把新连接分配给各个子线程, 子线程自己 accept
+    // 主线程不再处理新连接, 在 run 之前调用
+    void setReusePort(bool flag);
+    // 子线程绑定 CPU, 在 run 之前调用
+    inline void setAffinity(bool flag)
+    {
+        m_affinity = flag;
+    }
+    // 繁忙的子线程把长时间活跃的连接迁移到空闲的子线程, 在 run 之前调用
+    inline void setMigration(bool flag)
+    {
+        m_migration = flag;
+    }
+    // 每隔 interval 毫秒输出一次每个子线程的连接数和每秒处理的事件数, 0 表示不输出, 在 run 之前调用
+    inline void setStatsInterval(int interval)
+    {
+        m_statsInterval = interval;
+    }
     static int acceptConnection(void* arg);
 
+private:
+    // 创建监听的套接字, 失败返回 -1
+    int listenSocket();
+    // 在 evLoop 中处理新连接
+    void newConnection(int cfd, EventLoop* evLoop);
+    // 统计定时器: 更新子线程的负载, 输出统计信息
+    void updateStats();
+
 private:
     int m_threadNum;
     EventLoop* m_mainLoop;
     ThreadPool* m_threadPool;
     int m_lfd;
     unsigned short m_port;
+    int m_idleTimeout = 5000;   // 单位: ms
+    int m_maxRequests = 100;
+    bool m_reusePort = false;
+    bool m_affinity = false;
+    bool m_migration = false;
+    int m_statsInterval = 0;    // 单位: ms
+    // 开启连接迁移但是不输出统计信息时, 更新负载的周期, 单位: ms
+    const int m_loadInterval = 1000;
 };
 
@@ -13,8 +13,23 @@ public:
     ~ThreadPool();
     // 启动线程池
     void run();
-    // 取出线程池中的某个子线程的反应堆实例
+    // 取出线程池中的某个子线程的反应堆实例: 连接数最少的子线程, 连接数相同时轮流选择
     EventLoop* takeWorkerEventLoop();
+    // 第 index 个子线程的反应堆实例
+    inline EventLoop* getWorkerEventLoop(int index)
+    {
+        return m_workerThreads[index]->getEventLoop();
+    }
+    // 子线程绑定 CPU: 按顺序绑定到进程可以使用的 CPU 上, 在 run 之前调用
+    inline void setAffinity(bool flag)
+    {
+        m_affinity = flag;
+    }
+    // 更新每个子线程的事件处理速率, 由主线程每隔 interval 毫秒调用一次, print 为 true 时输出统计信息
+    void updateStats(int interval, bool print);
+    // 连接迁移: from 的负载明显高于最空闲的子线程时返回最空闲的子线程的反应堆, 否则返回 nullptr
+    // 在 from 所在的子线程中调用
+    EventLoop* takeMigrationTarget(EventLoop* from);
 private:
     // 主线程的反应堆模型
     EventLoop* m_mainLoop;
@@ -22,5 +37,6 @@ private:
     int m_threadNum;
     vector<WorkerThread*> m_workerThreads;
     int m_index;
+    bool m_affinity;
 };
 
@@ -0,0 +1,43 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <stdint.h>
+using namespace std;
+
+// 定时器队列: 每个 EventLoop 一个, 按到期时间组织成最小堆
+// 堆顶定时器的剩余时间就是 dispatch 的超时时长, 没有定时器时 dispatch 使用默认的超时时长
+class TimerQueue
+{
+public:
+    using TimerCallback = function<void()>;
+    TimerQueue();
+    ~TimerQueue();
+    // 添加定时器: delay 毫秒之后执行 callback, 返回定时器ID, 可以在任意线程调用
+    uint64_t addTimer(int delay, TimerCallback callback);
+    // 取消定时器: 只删除回调, 堆中的节点到期时再丢弃
+    void cancel(uint64_t timerId);
+    // 距离最近的定时器到期还有多少毫秒, 最多 maxTimeout
+    int nextTimeout(int maxTimeout);
+    // 执行所有已经到期的定时器, 返回执行的个数
+    int processExpired();
+    // 单调时钟, 单位: ms
+    static int64_t nowMs();
+
+private:
+    struct TimerNode
+    {
+        int64_t expire;
+        uint64_t id;
+    };
+    // 最小堆的比较函数: 到期时间相同按添加顺序执行
+    static bool later(const TimerNode& a, const TimerNode& b);
+
+private:
+    vector<TimerNode> m_heap;
+    // 还没有到期也没有被取消的定时器
+    unordered_map<uint64_t, TimerCallback> m_callbacks;
+    uint64_t m_nextId;
+    mutex m_mutex;
+};
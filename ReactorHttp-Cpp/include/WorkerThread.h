@@ -2,6 +2,7 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
 #include "EventLoop.h"
 using namespace std;
 
@@ -11,12 +12,31 @@ class WorkerThread
 public:
     WorkerThread(int index);
     ~WorkerThread();
-    // 启动线程
-    void run();
+    // 启动线程, cpu 不小于 0 时把线程绑定到这个 CPU 上
+    void run(int cpu = -1);
     inline EventLoop* getEventLoop()
     {
         return m_evLoop;
     }
+    inline string getName()
+    {
+        return m_name;
+    }
+    inline int getCpu()
+    {
+        return m_cpu;
+    }
+    // 负载统计: 根据反应堆累计处理的事件数计算最近 interval 毫秒中每秒处理的事件数, 由主线程定期调用
+    void updateEventRate(int interval);
+    inline uint64_t eventRate()
+    {
+        return m_eventRate.load(memory_order_relaxed);
+    }
+    // 每个统计周期中最多迁移出去 maxCount 个连接, 返回这一次是否还可以迁移
+    inline bool takeMigration(int maxCount)
+    {
+        return m_migrations.fetch_add(1, memory_order_relaxed) < maxCount;
+    }
 
 private:
     void running();
@@ -28,5 +48,9 @@ private:
     mutex m_mutex;  // 互斥锁
     condition_variable m_cond;    // 条件变量
     EventLoop* m_evLoop;   // 反应堆模型
+    int m_cpu;          // 绑定的 CPU, -1 表示不绑定
+    uint64_t m_lastEvents;
+    atomic<uint64_t> m_eventRate;
+    atomic<int> m_migrations;
 };
 
@@ -7,11 +7,25 @@
 #include <unistd.h>
 #include <strings.h>
 #include <sys/socket.h>
+#include <errno.h>
+#include <algorithm>
 
-Buffer::Buffer(int size):m_capacity(size)
+// 不小于 size 的最小的 2 的整数次幂
+static size_t roundUpPowerOfTwo(size_t size)
 {
-    m_data = (char*)malloc(size);
-    bzero(m_data, size);
+    size_t capacity = 1;
+    while (capacity < size)
+    {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+Buffer::Buffer(size_t size)
+{
+    m_capacity = roundUpPowerOfTwo(size);
+    m_mask = m_capacity - 1;
+    m_data = (char*)malloc(m_capacity);
 }
 
 Buffer::~Buffer()
@@ -22,116 +36,166 @@ Buffer::~Buffer()
     }
 }
 
-void Buffer::extendRoom(int size)
+void Buffer::linearize(size_t capacity)
 {
-    // 1. 内存够用 - 不需要扩容
-    if (writeableSize() >= size)
-    {
-        return;
-    }
-    // 2. 内存需要合并才够用 - 不需要扩容
-    // 剩余的可写的内存 + 已读的内存 > size
-    else if (m_readPos + writeableSize() >= size)
+    size_t readable = readableSize();
+    size_t start = m_readPos & m_mask;
+    if (capacity == m_capacity)
     {
-        // 得到未读的内存大小
-        int readable = readableSize();
-        // 移动内存
-        memcpy(m_data, m_data + m_readPos, readable);
-        // 更新位置
-        m_readPos = 0;
-        m_writePos = readable;
+        // 容量不变, 原地旋转, 可读数据的第一个字节转到内存的开头
+        rotate(m_data, m_data + start, m_data + m_capacity);
     }
-    // 3. 内存不够用 - 扩容
     else
     {
-        void* temp = realloc(m_data, m_capacity + size);
+        char* temp = (char*)malloc(capacity);
         if (temp == NULL)
         {
             return; // 失败了
         }
-        memset((char*)temp + m_capacity, 0, size);
-        // 更新数据
-        m_data = static_cast<char*>(temp);
-        m_capacity += size;
+        // 可读数据的两段依次拷贝到新内存的开头
+        size_t first = min(readable, m_capacity - start);
+        memcpy(temp, m_data + start, first);
+        memcpy(temp + first, m_data, readable - first);
+        free(m_data);
+        m_data = temp;
+        m_capacity = capacity;
+        m_mask = capacity - 1;
+    }
+    m_readPos = 0;
+    m_writePos = readable;
+}
+
+void Buffer::extendRoom(size_t size)
+{
+    // 内存够用 - 不需要扩容, 环形缓冲区不需要移动数据
+    if (writeableSize() >= size)
+    {
+        return;
     }
+    // 内存不够用 - 扩容到 2 的整数次幂
+    linearize(roundUpPowerOfTwo(readableSize() + size));
 }
 
-int Buffer::appendString(const char* data, int size)
+int Buffer::appendString(const char* data, size_t size)
 {
-    if (data == nullptr || size <= 0)
+    if (data == nullptr || size == 0)
     {
         return -1;
     }
     // 扩容
     extendRoom(size);
-    // 数据拷贝
-    memcpy(m_data + m_writePos, data, size);
+    if (writeableSize() < size)
+    {
+        return -1;
+    }
+    // 数据拷贝, 写到内存的末尾之后绕回开头
+    size_t start = m_writePos & m_mask;
+    size_t first = min(size, m_capacity - start);
+    memcpy(m_data + start, data, first);
+    memcpy(m_data, data + first, size - first);
     m_writePos += size;
     return 0;
 }
 
 int Buffer::appendString(const char* data)
 {
-    int size = strlen(data);
-    int ret = appendString(data, size);
+    int ret = appendString(data, strlen(data));
     return ret;
 }
 
 int Buffer::appendString(const string data)
 {
-    int ret = appendString(data.data());
+    int ret = appendString(data.data(), data.size());
     return ret;
 }
 
-int Buffer::socketRead(int fd)
+ssize_t Buffer::socketRead(int fd)
 {
-    // read/recv/readv
-    struct iovec vec[2];
-    // 初始化数组元素
-    int writeable = writeableSize();
-    vec[0].iov_base = m_data + m_writePos;
-    vec[0].iov_len = writeable;
-    char* tmpbuf = (char*)malloc(40960);
-    vec[1].iov_base = m_data + m_writePos;
-    vec[1].iov_len = 40960;
-    int result = readv(fd, vec, 2);
+    // 前两块是缓冲区中空闲的内存(可能绕回了开头), 最后一块是栈上的临时内存
+    // 一次读取的数据比空闲的内存多的时候, 再扩容拷贝到缓冲区中
+    char extrabuf[65536];
+    struct iovec vec[3];
+    int count = 0;
+    size_t writeable = writeableSize();
+    size_t start = m_writePos & m_mask;
+    size_t first = min(writeable, m_capacity - start);
+    if (first > 0)
+    {
+        vec[count].iov_base = m_data + start;
+        vec[count].iov_len = first;
+        ++count;
+    }
+    if (writeable > first)
+    {
+        vec[count].iov_base = m_data;
+        vec[count].iov_len = writeable - first;
+        ++count;
+    }
+    vec[count].iov_base = extrabuf;
+    vec[count].iov_len = sizeof(extrabuf);
+    ++count;
+    ssize_t result = readv(fd, vec, count);
     if (result == -1)
     {
         return -1;
     }
-    else if (result <= writeable)
+    else if ((size_t)result <= writeable)
     {
         m_writePos += result;
     }
     else
     {
-        m_writePos = m_capacity;
-        appendString(tmpbuf, result - writeable);
+        m_writePos += writeable;
+        // 数据已经从 socket 中读走了, 放不进缓冲区的话请求流就不完整了, 只能当作出错断开连接
+        if (appendString(extrabuf, result - writeable) == -1)
+        {
+            errno = ENOMEM;
+            return -1;
+        }
     }
-    free(tmpbuf);
     return result;
 }
 
+char* Buffer::data()
+{
+    // 可读的数据绕回到了内存的开头
+    if ((m_readPos & m_mask) + readableSize() > m_capacity)
+    {
+        linearize(m_capacity);
+    }
+    return at(m_readPos);
+}
+
 char* Buffer::findCRLF()
 {
-    char* ptr = (char*)memmem(m_data + m_readPos, readableSize(), "\r\n", 2);
+    char* ptr = (char*)memmem(data(), readableSize(), "\r\n", 2);
     return ptr;
 }
 
-int Buffer::sendData(int socket)
+ssize_t Buffer::sendData(int socket)
 {
     // 判断有无数据
-    int readable = readableSize();
+    size_t readable = readableSize();
     if (readable > 0)
     {
-        int count = send(socket, m_data + m_readPos, readable, MSG_NOSIGNAL);
+        // 可读的数据最多两段, 通过一次 sendmsg(相当于 writev) 发送出去
+        struct iovec vec[2];
+        size_t start = m_readPos & m_mask;
+        size_t first = min(readable, m_capacity - start);
+        vec[0].iov_base = m_data + start;
+        vec[0].iov_len = first;
+        vec[1].iov_base = m_data;
+        vec[1].iov_len = readable - first;
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = vec;
+        msg.msg_iovlen = readable > first ? 2 : 1;
+        ssize_t count = sendmsg(socket, &msg, MSG_NOSIGNAL);
         if (count > 0)
         {
-            m_readPos += count;
-            usleep(1);
+            readPosIncrease(count);
         }
         return count;
     }
     return 0;
 }
-
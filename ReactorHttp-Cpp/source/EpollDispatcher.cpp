@@ -42,9 +42,6 @@ int EpollDispatcher::remove()
         perror("epoll_crl delete");
         exit(0);
     }
-    // 通过 channel 释放对应的 TcpConnection 资源
-    m_channel->destroyCallback(const_cast<void*>(m_channel->getArg()));
-
     return ret;
 }
 
@@ -61,25 +58,22 @@ int EpollDispatcher::modify()
 
 int EpollDispatcher::dispatch(int timeout)
 {
-    int count = epoll_wait(m_epfd, m_events, m_maxNode, timeout * 1000);
+    int count = epoll_wait(m_epfd, m_events, m_maxNode, timeout);
     for (int i = 0; i < count; ++i)
     {
         int events = m_events[i].events;
         int fd = m_events[i].data.fd;
-        if (events & EPOLLERR || events & EPOLLHUP)
-        {
-            // 对方断开了连接, 删除 fd
-            // epollRemove(Channel, evLoop);
-            continue;
-        }
-        if (events & EPOLLIN)
+        // 对方断开了连接或者出错了, 当作读事件处理, 读数据的时候失败会删除 fd
+        int active = 0;
+        if (events & (EPOLLIN | EPOLLERR | EPOLLHUP))
         {
-            m_evLoop->eventActive(fd, (int)FDEvent::ReadEvent);
+            active |= (int)FDEvent::ReadEvent;
         }
         if (events & EPOLLOUT)
         {
-            m_evLoop->eventActive(fd, (int)FDEvent::WriteEvent);
+            active |= (int)FDEvent::WriteEvent;
         }
+        m_evLoop->eventActive(fd, active);
     }
     return 0;
 }
@@ -8,19 +8,50 @@
 #include "SelectDispatcher.h"
 #include "PollDispatcher.h"
 #include "EpollDispatcher.h"
+#include "IoUringDispatcher.h"
+#include <algorithm>
+
+// 所有反应堆默认使用的 IO 多路复用模型, 启动服务器之前通过启动参数设置
+static DispatcherType g_defaultDispatcher = DispatcherType::Epoll;
 
 EventLoop::EventLoop() : EventLoop(string())
 {
 }
 
-EventLoop::EventLoop(const string threadName)
+EventLoop::EventLoop(const string threadName) : EventLoop(threadName, g_defaultDispatcher)
+{
+}
+
+EventLoop::EventLoop(const string threadName, DispatcherType type)
 {
     m_isQuit = true;    // 默认没有启动
     m_threadID = this_thread::get_id();
     m_threadName = threadName == string() ? "MainThread" : threadName;
-    m_dispatcher = new SelectDispatcher(this);
-    // map
-    m_channelMap.clear();
+    if (type == DispatcherType::IoUring)
+    {
+        IoUringDispatcher* dispatcher = new IoUringDispatcher(this);
+        m_dispatcher = dispatcher;
+        // 内核不支持 io_uring 时使用 epoll
+        if (!dispatcher->isValid())
+        {
+            printf("%s: io_uring 初始化失败, 使用 epoll\n", m_threadName.data());
+            delete dispatcher;
+            type = DispatcherType::Epoll;
+        }
+    }
+    if (type == DispatcherType::Epoll)
+    {
+        m_dispatcher = new EpollDispatcher(this);
+    }
+    else if (type == DispatcherType::Poll)
+    {
+        m_dispatcher = new PollDispatcher(this);
+    }
+    else if (type == DispatcherType::Select)
+    {
+        m_dispatcher = new SelectDispatcher(this);
+    }
+    m_timerQueue = new TimerQueue;
     int ret = socketpair(AF_UNIX, SOCK_STREAM, 0, m_socketPair);
     if (ret == -1)
     {
@@ -43,6 +74,7 @@ EventLoop::EventLoop(const string threadName)
 
 EventLoop::~EventLoop()
 {
+    delete m_timerQueue;
 }
 
 int EventLoop::run()
@@ -56,7 +88,9 @@ int EventLoop::run()
     // 循环进行事件处理
     while (!m_isQuit)
     {
-        m_dispatcher->dispatch();    // 超时时长 2s
+        // 超时时长: 最近一个定时器到期的时间, 没有定时器时为 2s
+        m_dispatcher->dispatch(m_timerQueue->nextTimeout(m_dispatchTimeout));
+        m_timerQueue->processExpired();
         processTaskQ();
     }
     return 0;
@@ -68,12 +102,23 @@ int EventLoop::eventActive(int fd, int event)
     {
         return -1;
     }
-    // 取出channel
-    Channel* channel = m_channelMap[fd];
+    // 取出channel, 同一轮 dispatch 中前面的事件回调可能已经断开连接, 释放了 channel
+    Channel* channel = getChannel(fd);
+    if (channel == nullptr)
+    {
+        return -1;
+    }
     assert(channel->getSocket() == fd);
+    // 只有反应堆线程修改, 其他线程读取统计信息
+    m_eventCount.store(m_eventCount.load(memory_order_relaxed) + 1, memory_order_relaxed);
     if (event & (int)FDEvent::ReadEvent && channel->readCallback)
     {
         channel->readCallback(const_cast<void*>(channel->getArg()));
+        // 读事件的回调中可能已经断开连接
+        if (getChannel(fd) != channel)
+        {
+            return 0;
+        }
     }
     if (event & (int)FDEvent::WriteEvent && channel->writeCallback)
     {
@@ -84,73 +129,83 @@ int EventLoop::eventActive(int fd, int event)
 
 int EventLoop::addTask(Channel* channel, ElemType type)
 {
-    // 加锁, 保护共享资源
-    m_mutex.lock();
-    // 创建新节点
-    ChannelElement* node = new ChannelElement;
-    node->channel = channel;
-    node->type = type;
-    m_taskQ.push(node);
-    m_mutex.unlock();
-    // 处理节点
     /*
     * 细节:
-    *   1. 对于链表节点的添加: 可能是当前线程也可能是其他线程(主线程)
+    *   1. 对于任务的添加: 可能是当前线程也可能是其他线程(主线程)
     *       1). 修改fd的事件, 当前子线程发起, 当前子线程处理
     *       2). 添加新的fd, 添加任务节点的操作是由主线程发起的
     *   2. 不能让主线程处理任务队列, 需要由当前的子线程取处理
     */
     if (m_threadID == this_thread::get_id())
     {
-        // 当前子线程(基于子线程的角度分析)
+        // 当前子线程(基于子线程的角度分析): 先处理其他线程添加的任务, 保证处理的顺序, 再直接处理这个任务
         processTaskQ();
+        processTask(ChannelElement{ type, channel });
+        return 0;
     }
-    else
-    {
-        // 主线程 -- 告诉子线程处理任务队列中的任务
-        // 1. 子线程在工作 2. 子线程被阻塞了:select, poll, epoll
-        taskWakeup();
-    }
+    // 主线程 -- 加锁, 保护共享资源
+    m_mutex.lock();
+    m_taskQ.push_back(ChannelElement{ type, channel });
+    m_mutex.unlock();
+    // 告诉子线程处理任务队列中的任务
+    // 1. 子线程在工作 2. 子线程被阻塞了:select, poll, epoll
+    taskWakeup();
     return 0;
 }
 
 int EventLoop::processTaskQ()
 {
-    // 取出头结点
-    while (!m_taskQ.empty())
+    // 一次取出所有的任务, 处理的时候不需要持有锁
+    // 任务处理的过程中可能会添加新的任务(递归调用), 所以每次调用使用自己的数组
+    vector<ChannelElement> tasks;
+    m_mutex.lock();
+    tasks.swap(m_taskQ);
+    m_mutex.unlock();
+    for (auto& task : tasks)
     {
-        m_mutex.lock();
-        ChannelElement* node = m_taskQ.front();
-        m_taskQ.pop();  // 删除节点
-        m_mutex.unlock();
-        Channel* channel = node->channel;
-        if (node->type == ElemType::ADD)
-        {
-            // 添加
-            add(channel);
-        }
-        else if (node->type == ElemType::DELETE)
-        {
-            // 删除
-            remove(channel);
-        }
-        else if (node->type == ElemType::MODIFY)
-        {
-            // 修改
-            modify(channel);
-        }
-        delete node;
+        processTask(task);
+    }
+    // 把数组的内存还给任务队列, 下一次添加任务不需要重新分配内存
+    tasks.clear();
+    m_mutex.lock();
+    if (m_taskQ.empty())
+    {
+        m_taskQ.swap(tasks);
     }
+    m_mutex.unlock();
     return 0;
 }
 
+void EventLoop::processTask(const ChannelElement& task)
+{
+    if (task.type == ElemType::ADD)
+    {
+        // 添加
+        add(task.channel);
+    }
+    else if (task.type == ElemType::DELETE)
+    {
+        // 删除
+        remove(task.channel);
+    }
+    else if (task.type == ElemType::MODIFY)
+    {
+        // 修改
+        modify(task.channel);
+    }
+}
+
 int EventLoop::add(Channel* channel)
 {
     int fd = channel->getSocket();
-    // 找到fd对应的数组元素位置, 并存储
-    if (m_channelMap.find(fd) == m_channelMap.end())
+    // 以fd作为下标存储, 空间不够的时候扩容
+    if (fd >= (int)m_channels.size())
+    {
+        m_channels.resize(max(fd + 1, (int)m_channels.size() * 2), nullptr);
+    }
+    if (m_channels[fd] == nullptr)
     {
-        m_channelMap.insert(make_pair(fd, channel));
+        m_channels[fd] = channel;
         m_dispatcher->setChannel(channel);
         int ret = m_dispatcher->add();
         return ret;
@@ -160,20 +215,35 @@ int EventLoop::add(Channel* channel)
 
 int EventLoop::remove(Channel* channel)
 {
+    if (getChannel(channel->getSocket()) == nullptr)
+    {
+        return -1;
+    }
+    m_dispatcher->setChannel(channel);
+    int ret = m_dispatcher->remove();
+    // 通过 channel 释放对应的 TcpConnection 资源
+    channel->destroyCallback(const_cast<void*>(channel->getArg()));
+    return ret;
+}
+
+int EventLoop::detach(Channel* channel)
+{
+    assert(m_threadID == this_thread::get_id());
     int fd = channel->getSocket();
-    if (m_channelMap.find(fd) == m_channelMap.end())
+    if (getChannel(fd) != channel)
     {
         return -1;
     }
+    // 只从反应堆中删除, 不关闭 fd, 不释放连接
     m_dispatcher->setChannel(channel);
     int ret = m_dispatcher->remove();
+    m_channels[fd] = nullptr;
     return ret;
 }
 
 int EventLoop::modify(Channel* channel)
 {
-    int fd = channel->getSocket();
-    if (m_channelMap.find(fd) == m_channelMap.end())
+    if (getChannel(channel->getSocket()) == nullptr)
     {
         return -1;
     }
@@ -190,6 +260,36 @@ int EventLoop::readLocalMessage(void* arg)
     return 0;
 }
 
+void EventLoop::setDefaultDispatcher(DispatcherType type)
+{
+    g_defaultDispatcher = type;
+}
+
+bool EventLoop::parseDispatcherType(const string& name, DispatcherType& type)
+{
+    if (name == "epoll")
+    {
+        type = DispatcherType::Epoll;
+    }
+    else if (name == "poll")
+    {
+        type = DispatcherType::Poll;
+    }
+    else if (name == "select")
+    {
+        type = DispatcherType::Select;
+    }
+    else if (name == "uring" || name == "io_uring")
+    {
+        type = DispatcherType::IoUring;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
 void EventLoop::taskWakeup()
 {
     const char* msg = "我是要成为海贼王的男人!!!";
@@ -199,16 +299,32 @@ void EventLoop::taskWakeup()
 int EventLoop::freeChannel(Channel* channel)
 {
     // 删除 channel 和 fd 的对应关系
-    auto it = m_channelMap.find(channel->getSocket());
-    if (it != m_channelMap.end())
+    int fd = channel->getSocket();
+    if (getChannel(fd) == channel)
     {
-        m_channelMap.erase(it);
-        close(channel->getSocket());
+        m_channels[fd] = nullptr;
+        close(fd);
         delete channel;
     }
     return 0;
 }
 
+uint64_t EventLoop::addTimer(int delay, function<void()> callback)
+{
+    uint64_t timerId = m_timerQueue->addTimer(delay, std::move(callback));
+    if (m_threadID != this_thread::get_id())
+    {
+        // 反应堆线程可能正阻塞在 dispatch 中, 唤醒它重新计算超时时长
+        taskWakeup();
+    }
+    return timerId;
+}
+
+void EventLoop::cancelTimer(uint64_t timerId)
+{
+    m_timerQueue->cancel(timerId);
+}
+
 int EventLoop::readMessage()
 {
     char buf[256];
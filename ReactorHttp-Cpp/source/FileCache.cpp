@@ -0,0 +1,210 @@
+#include "FileCache.h"
+#include <sys/inotify.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <functional>
+
+// 文件内容、属性被修改, 目录中的文件被添加、删除、修改, 或者自己被删除、移动
+static const uint32_t kWatchMask = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE
+    | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+FileEntry::~FileEntry()
+{
+    if (fd != -1)
+    {
+        close(fd);
+    }
+}
+
+FileCache::FileCache(size_t maxEntries) : m_maxEntries(maxEntries)
+{
+    // 创建失败时不缓存, 每次都直接访问磁盘
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd == -1)
+    {
+        perror("inotify_init1");
+    }
+}
+
+FileCache::~FileCache()
+{
+    if (m_inotifyFd != -1)
+    {
+        close(m_inotifyFd);
+    }
+}
+
+FileCache* FileCache::threadCache()
+{
+    static thread_local FileCache cache;
+    return &cache;
+}
+
+shared_ptr<FileEntry> FileCache::lookup(const string& path)
+{
+    processEvents();
+    auto it = m_entries.find(path);
+    if (it != m_entries.end())
+    {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.pos);
+        return it->second.entry;
+    }
+
+    // 先添加监视再读取文件, 读取过程中的修改也能收到通知
+    int wd = -1;
+    if (m_inotifyFd != -1)
+    {
+        wd = inotify_add_watch(m_inotifyFd, path.data(), kWatchMask);
+    }
+    shared_ptr<FileEntry> entry = load(path);
+    if (wd == -1)
+    {
+        return entry;
+    }
+    if (entry == nullptr)
+    {
+        if (m_watches.find(wd) == m_watches.end())
+        {
+            inotify_rm_watch(m_inotifyFd, wd);
+        }
+        return entry;
+    }
+    m_lru.push_front(path);
+    m_entries.insert(make_pair(path, Node{ entry, m_lru.begin(), wd }));
+    m_watches[wd].push_back(path);
+    if (m_entries.size() > m_maxEntries)
+    {
+        remove(m_lru.back());
+    }
+    return entry;
+}
+
+void FileCache::processEvents()
+{
+    if (m_inotifyFd == -1)
+    {
+        return;
+    }
+    alignas(struct inotify_event) char buf[4096];
+    while (1)
+    {
+        ssize_t len = read(m_inotifyFd, buf, sizeof(buf));
+        if (len <= 0)
+        {
+            break;
+        }
+        for (char* ptr = buf; ptr < buf + len; )
+        {
+            struct inotify_event* event = (struct inotify_event*)ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+            auto it = m_watches.find(event->wd);
+            if (it == m_watches.end())
+            {
+                continue;
+            }
+            // remove 会修改 m_watches, 先拷贝一份
+            vector<string> paths = it->second;
+            for (auto& path : paths)
+            {
+                remove(path);
+            }
+        }
+    }
+}
+
+void FileCache::remove(const string& path)
+{
+    auto it = m_entries.find(path);
+    if (it == m_entries.end())
+    {
+        return;
+    }
+    int wd = it->second.wd;
+    vector<string>& paths = m_watches[wd];
+    for (auto pos = paths.begin(); pos != paths.end(); ++pos)
+    {
+        if (*pos == path)
+        {
+            paths.erase(pos);
+            break;
+        }
+    }
+    if (paths.empty())
+    {
+        m_watches.erase(wd);
+        inotify_rm_watch(m_inotifyFd, wd);
+    }
+    m_lru.erase(it->second.pos);
+    // 正在发送的请求还持有 entry, 文件描述符在发送完之后关闭
+    m_entries.erase(it);
+}
+
+shared_ptr<FileEntry> FileCache::load(const string& path)
+{
+    int fd = open(path.data(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        return nullptr;
+    }
+    shared_ptr<FileEntry> entry = make_shared<FileEntry>();
+    entry->fd = fd;
+    if (fstat(fd, &entry->st) == -1)
+    {
+        return nullptr;
+    }
+    char etag[64] = { 0 };
+    if (S_ISDIR(entry->st.st_mode))
+    {
+        // 目录只缓存生成好的列表, 不占用文件描述符
+        close(entry->fd);
+        entry->fd = -1;
+        renderDir(path, entry->listing);
+        // 目录中文件的大小变化不会修改目录的时间, etag 使用列表内容的哈希值
+        sprintf(etag, "\"%lx-%zx\"", (long)entry->st.st_mtime, hash<string>()(entry->listing));
+    }
+    else
+    {
+        sprintf(etag, "\"%lx-%lx\"", (long)entry->st.st_mtime, (long)entry->st.st_size);
+    }
+    entry->etag = etag;
+    // Last-Modified: Wed, 21 Oct 2015 07:28:00 GMT
+    char date[64] = { 0 };
+    struct tm tm;
+    gmtime_r(&entry->st.st_mtime, &tm);
+    strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    entry->lastModified = date;
+    return entry;
+}
+
+void FileCache::renderDir(const string& dirName, string& html)
+{
+    char buf[4096] = { 0 };
+    sprintf(buf, "<html><head><title>%s</title></head><body><table>", dirName.data());
+    html = buf;
+    struct dirent** namelist;
+    int num = scandir(dirName.data(), &namelist, NULL, alphasort);
+    for (int i = 0; i < num; ++i)
+    {
+        // 取出文件名 namelist 指向的是一个指针数组 struct dirent* tmp[]
+        char* name = namelist[i]->d_name;
+        struct stat st = {};
+        char subPath[1024] = { 0 };
+        snprintf(subPath, sizeof(subPath), "%s/%s", dirName.data(), name);
+        stat(subPath, &st);
+        // a标签 <a href="">name</a>, 目录的链接以 / 结尾
+        snprintf(buf, sizeof(buf),
+            "<tr><td><a href=\"%s%s\">%s</a></td><td>%ld</td></tr>",
+            name, S_ISDIR(st.st_mode) ? "/" : "", name, (long)st.st_size);
+        html += buf;
+        free(namelist[i]);
+    }
+    html += "</table></body></html>";
+    if (num != -1)
+    {
+        free(namelist);
+    }
+}
@@ -0,0 +1,167 @@
+#include "Gzip.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// 流式压缩的参数: 窗口 2^13 = 8KB, 压缩占用的内存为 2^(13+2) + 2^(6+9) = 64KB
+// windowBits 加 16 表示输出 gzip 格式(带 gzip 头和 crc32 校验)
+static const int kStreamWindowBits = 13;
+static const int kStreamMemLevel = 6;
+
+GzipStream::GzipStream(shared_ptr<FileEntry> file) : m_file(file)
+{
+    m_offset = 0;
+    m_finished = false;
+    memset(&m_stream, 0, sizeof(m_stream));
+    m_valid = deflateInit2(&m_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+        16 + kStreamWindowBits, kStreamMemLevel, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+GzipStream::~GzipStream()
+{
+    if (m_valid)
+    {
+        deflateEnd(&m_stream);
+    }
+}
+
+bool GzipStream::compressChunk(Buffer* out)
+{
+    if (!m_valid || m_finished)
+    {
+        return false;
+    }
+    // 只读取打开文件时的大小, 文件被截断了就提前结束
+    char in[m_chunkSize];
+    size_t want = min((off_t)m_chunkSize, m_file->st.st_size - m_offset);
+    ssize_t len = want > 0 ? pread(m_file->fd, in, want, m_offset) : 0;
+    if (len < 0)
+    {
+        return false;
+    }
+    m_offset += len;
+    int flush = len == 0 || m_offset >= m_file->st.st_size ? Z_FINISH : Z_NO_FLUSH;
+    m_stream.next_in = (Bytef*)in;
+    m_stream.avail_in = len;
+    // 压缩之后的数据一般比输入少, 输出满了就分成多个 chunk
+    char zout[m_chunkSize];
+    do
+    {
+        m_stream.next_out = (Bytef*)zout;
+        m_stream.avail_out = sizeof(zout);
+        if (deflate(&m_stream, flush) == Z_STREAM_ERROR)
+        {
+            return false;
+        }
+        size_t have = sizeof(zout) - m_stream.avail_out;
+        if (have > 0)
+        {
+            // chunk: 十六进制的长度\r\n数据\r\n
+            char head[32];
+            int headLen = sprintf(head, "%zx\r\n", have);
+            out->appendString(head, headLen);
+            out->appendString(zout, have);
+            out->appendString("\r\n", 2);
+        }
+    } while (m_stream.avail_out == 0);
+    if (flush == Z_FINISH)
+    {
+        // 最后一个长度为 0 的 chunk 表示响应体结束
+        out->appendString("0\r\n\r\n", 5);
+        m_finished = true;
+    }
+    return true;
+}
+
+GzipCache::GzipCache(size_t maxBytes) : m_maxBytes(maxBytes)
+{
+    m_bytes = 0;
+}
+
+GzipCache* GzipCache::instance()
+{
+    static GzipCache cache;
+    return &cache;
+}
+
+shared_ptr<const string> GzipCache::lookup(const string& path, const FileEntry& entry)
+{
+    {
+        lock_guard<mutex> locker(m_mutex);
+        auto it = m_entries.find(path);
+        if (it != m_entries.end() && it->second.etag == entry.etag)
+        {
+            m_lru.splice(m_lru.begin(), m_lru, it->second.pos);
+            return it->second.data;
+        }
+    }
+
+    // 压缩的时候不持有锁, 多个线程同时压缩同一个文件时只保留最后一个结果
+    string raw;
+    if (S_ISDIR(entry.st.st_mode))
+    {
+        raw = entry.listing;
+    }
+    else
+    {
+        raw.resize(entry.st.st_size);
+        size_t done = 0;
+        while (done < raw.size())
+        {
+            ssize_t len = pread(entry.fd, &raw[done], raw.size() - done, done);
+            if (len <= 0)
+            {
+                return nullptr;
+            }
+            done += len;
+        }
+    }
+    shared_ptr<string> data = make_shared<string>();
+    if (!compress(raw, *data))
+    {
+        return nullptr;
+    }
+
+    lock_guard<mutex> locker(m_mutex);
+    remove(path);
+    m_lru.push_front(path);
+    m_entries.insert(make_pair(path, Node{ entry.etag, data, m_lru.begin() }));
+    m_bytes += data->size();
+    while (m_bytes > m_maxBytes && m_lru.size() > 1)
+    {
+        remove(m_lru.back());
+    }
+    return data;
+}
+
+bool GzipCache::compress(const string& data, string& out)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return false;
+    }
+    out.resize(deflateBound(&stream, data.size()));
+    stream.next_in = (Bytef*)data.data();
+    stream.avail_in = data.size();
+    stream.next_out = (Bytef*)&out[0];
+    stream.avail_out = out.size();
+    int ret = deflate(&stream, Z_FINISH);
+    out.resize(out.size() - stream.avail_out);
+    deflateEnd(&stream);
+    return ret == Z_STREAM_END;
+}
+
+void GzipCache::remove(const string& path)
+{
+    auto it = m_entries.find(path);
+    if (it == m_entries.end())
+    {
+        return;
+    }
+    m_bytes -= it->second.data->size();
+    m_lru.erase(it->second.pos);
+    m_entries.erase(it);
+}
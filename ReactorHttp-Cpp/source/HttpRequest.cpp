@@ -11,17 +11,44 @@
 #include "TcpConnection.h"
 #include <assert.h>
 #include <ctype.h>
+#include <algorithm>
 
-char* HttpRequest::splitRequestLine(const char* start, const char* end, const char* sub, function<void(string)> callback)
+// 小于这个大小的数据压缩之后节省不了多少, 直接发送
+static const off_t kMinGzipSize = 256;
+// 不超过这个大小的文件压缩之后缓存起来, 更大的文件边读边压缩
+static const off_t kMaxCachedGzipSize = 1024 * 1024;
+
+// 大小写无关的比较, 视图不以 '\0' 结尾, 不能直接使用 strcasecmp
+static bool equalsIgnoreCase(string_view a, string_view b)
+{
+    return a.size() == b.size() && strncasecmp(a.data(), b.data(), a.size()) == 0;
+}
+
+// 大小写无关地查找子串, 用于 Connection 这种逗号分隔的多值请求头
+static bool containsIgnoreCase(string_view str, string_view sub)
+{
+    for (size_t i = 0; i + sub.size() <= str.size(); ++i)
+    {
+        if (strncasecmp(str.data() + i, sub.data(), sub.size()) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* HttpRequest::splitRequestLine(const char* start, const char* end, const char* sub, string_view& token)
 {
-    char* space = const_cast<char*>(end);
+    const char* space = end;
     if (sub != nullptr)
     {
-        space = static_cast<char*>(memmem(start, end - start, sub, strlen(sub)));
-        assert(space != nullptr);
+        space = static_cast<const char*>(memmem(start, end - start, sub, strlen(sub)));
+        if (space == nullptr)
+        {
+            return nullptr;
+        }
     }
-    int length = space - start;
-    callback(string(start, length));
+    token = string_view(start, space - start);
     return space + 1;
 }
 
@@ -41,6 +68,8 @@ int HttpRequest::hexToDec(char c)
 
 HttpRequest::HttpRequest()
 {
+    // 常见浏览器请求的请求头在 16 个以内, 预留之后解析请求时不需要再分配内存
+    m_reqHeaders.reserve(16);
     reset();
 }
 
@@ -51,27 +80,30 @@ HttpRequest::~HttpRequest()
 void HttpRequest::reset()
 {
     m_curState = PrecessState::ParseReqLine;
-    m_method = m_url = m_version = string(); // ""
+    m_method = m_url = m_version = string_view();
     m_reqHeaders.clear();
+    m_scanned = 0;
 }
 
-void HttpRequest::addHeader(const string key, const string value)
+void HttpRequest::addHeader(string_view key, string_view value)
 {
     if (key.empty() || value.empty())
     {
         return;
     }
-    m_reqHeaders.insert(make_pair(key, value));
+    m_reqHeaders.push_back(HttpHeader{ key, value });
 }
 
-string HttpRequest::getHeader(const string key)
+string_view HttpRequest::getHeader(string_view key)
 {
-    auto item = m_reqHeaders.find(key);
-    if (item == m_reqHeaders.end())
+    for (auto& item : m_reqHeaders)
     {
-        return string();
+        if (equalsIgnoreCase(item.key, key))
+        {
+            return item.value;
+        }
     }
-    return item->second;
+    return string_view();
 }
 
 bool HttpRequest::parseRequestLine(Buffer* readBuf)
@@ -79,18 +111,23 @@ bool HttpRequest::parseRequestLine(Buffer* readBuf)
     // 读出请求行, 保存字符串结束地址
     char* end = readBuf->findCRLF();
     // 保存字符串起始地址
-    char* start = readBuf->data();
+    const char* start = readBuf->data();
     // 请求行总长度
     int lineSize = end - start;
 
     if (lineSize > 0)
     {
-        auto methodFunc = bind(&HttpRequest::setMethod, this, placeholders::_1);
-        start = splitRequestLine(start, end, " ", methodFunc);
-        auto urlFunc = bind(&HttpRequest::seturl, this, placeholders::_1);
-        start = splitRequestLine(start, end, " ", urlFunc);
-        auto versionFunc = bind(&HttpRequest::setVersion, this, placeholders::_1);
-        splitRequestLine(start, end, nullptr, versionFunc);
+        start = splitRequestLine(start, end, " ", m_method);
+        if (start == nullptr)
+        {
+            return false;
+        }
+        start = splitRequestLine(start, end, " ", m_url);
+        if (start == nullptr)
+        {
+            return false;
+        }
+        splitRequestLine(start, end, nullptr, m_version);
         // 为解析请求头做准备
         readBuf->readPosIncrease(lineSize + 2);
         // 修改状态
@@ -115,9 +152,7 @@ bool HttpRequest::parseRequestHeader(Buffer* readBuf)
             int valueLen = end - middle - 2;
             if (keyLen > 0 && valueLen > 0)
             {
-                string key(start, keyLen);
-                string value(middle + 2, valueLen);
-                addHeader(key, value);
+                addHeader(string_view(start, keyLen), string_view(middle + 2, valueLen));
             }
             // 移动读数据的位置
             readBuf->readPosIncrease(lineSize + 2);
@@ -127,7 +162,7 @@ bool HttpRequest::parseRequestHeader(Buffer* readBuf)
             // 请求头被解析完了, 跳过空行
             readBuf->readPosIncrease(2);
             // 修改解析状态
-            // 忽略 post 请求, 按照 get 请求处理
+            // 不解析请求体, 带请求体的请求处理完之后断开连接, 见 hasBody
             setState(PrecessState::ParseReqDone);
         }
         return true;
@@ -135,11 +170,30 @@ bool HttpRequest::parseRequestHeader(Buffer* readBuf)
     return false;
 }
 
-bool HttpRequest::parseHttpRequest(Buffer* readBuf, HttpResponse* response, Buffer* sendBuf, int socket)
+bool HttpRequest::parseHttpRequest(Buffer* readBuf)
 {
+    // 请求行和请求头全部到齐之后一次解析完, 解析出来的视图指向 readBuf 中的数据,
+    // 如果分多次解析, 中间的 socketRead 可能会移动 readBuf 中的数据, 之前的视图就失效了
+    // 每次只查找新收到的数据(往前多看 3 个字节, 结尾的 \r\n\r\n 可能被分在两次读取中)
+    if (m_curState == PrecessState::ParseReqLine)
+    {
+        size_t limit = min(readBuf->readableSize(), kMaxHeaderSize);
+        size_t from = m_scanned > 3 ? m_scanned - 3 : 0;
+        if (memmem(readBuf->data() + from, limit - from, "\r\n\r\n", 4) == nullptr)
+        {
+            m_scanned = limit;
+            // 请求头太大
+            return limit < kMaxHeaderSize;
+        }
+    }
     bool flag = true;
     while (m_curState != PrecessState::ParseReqDone)
     {
+        // 没有完整的一行, 等待后续的数据
+        if (readBuf->findCRLF() == nullptr)
+        {
+            return true;
+        }
         switch (m_curState)
         {
         case PrecessState::ParseReqLine:
@@ -157,104 +211,374 @@ bool HttpRequest::parseHttpRequest(Buffer* readBuf, HttpResponse* response, Buff
         {
             return flag;
         }
-        // 判断是否解析完毕了, 如果完毕了, 需要准备回复的数据
-        if (m_curState == PrecessState::ParseReqDone)
-        {
-            // 1. 根据解析出的原始数据, 对客户端的请求做出处理
-            processHttpRequest(response);
-            // 2. 组织响应数据并发送给客户端
-            response->prepareMsg(sendBuf, socket);
-        }
     }
-    m_curState = PrecessState::ParseReqLine;   // 状态还原, 保证还能继续处理第二条及以后的请求
     return flag;
 }
 
 bool HttpRequest::processHttpRequest(HttpResponse* response)
 {
-    if (strcasecmp(m_method.data(), "get") != 0)
+    if (!equalsIgnoreCase(m_method, "get"))
     {
-        return -1;
+        response->setStatusCode(StatusCode::BadRequest);
+        response->addHeader("Content-length", "0");
+        return false;
     }
-    m_url = decodeMsg(m_url);
+    decodeMsg(m_url, m_path);
     // 处理客户端请求的静态资源(目录或者文件)
     const char* file = NULL;
-    if (strcmp(m_url.data(), "/") == 0)
+    if (m_path == "/")
     {
         file = "./";
     }
     else
     {
-        file = m_url.data() + 1;
+        file = m_path.c_str() + 1;
     }
-    // 获取文件属性
-    struct stat st;
-    int ret = stat(file, &st);
-    if (ret == -1)
+    // 获取文件属性: 缓存中的文件在被修改之前不需要再访问磁盘
+    shared_ptr<FileEntry> entry = FileCache::threadCache()->lookup(file);
+    if (entry == nullptr)
     {
         // 文件不存在 -- 回复404
         //sendHeadMsg(cfd, 404, "Not Found", getFileType(".html"), -1);
         //sendFile("404.html", cfd);
-        response->setFileName("404.html");
         response->setStatusCode(StatusCode::NotFound);
         // 响应头
         response->addHeader("Content-type", getFileType(".html"));
-        response->sendDataFunc = sendFile;
+        entry = FileCache::threadCache()->lookup("404.html");
+        if (entry != nullptr && S_ISREG(entry->st.st_mode))
+        {
+            response->addHeader("Content-length", to_string(entry->st.st_size));
+            response->setFileBody(entry, 0, entry->st.st_size);
+        }
+        else
+        {
+            response->addHeader("Content-length", "0");
+        }
         return 0;
     }
 
-    response->setFileName(file);
+    bool isDir = S_ISDIR(entry->st.st_mode);
+    string type = isDir ? getFileType(".html") : getFileType(file);
+    off_t size = isDir ? entry->listing.size() : entry->st.st_size;
+    bool compressible = isCompressible(type);
+    // 内容协商: 优先发送预先压缩好的 .br / .gz 文件, 其次是 gzip 压缩之后的数据, 最后是原始数据
+    string encoding;
+    shared_ptr<FileEntry> precompressed;
+    if (!isDir)
+    {
+        if (acceptsEncoding("br"))
+        {
+            precompressed = lookupRegularFile(string(file) + ".br");
+            encoding = precompressed != nullptr ? "br" : "";
+        }
+        if (precompressed == nullptr && acceptsEncoding("gzip"))
+        {
+            precompressed = lookupRegularFile(string(file) + ".gz");
+            encoding = precompressed != nullptr ? "gzip" : "";
+        }
+    }
+    // 实时压缩: 小文件和目录列表压缩之后缓存起来, 大文件边读边压缩, chunked 编码只有 HTTP/1.1 支持
+    shared_ptr<const string> gzipData;
+    bool gzipStream = false;
+    if (precompressed == nullptr && compressible && size >= kMinGzipSize && acceptsEncoding("gzip"))
+    {
+        if (isDir || size <= kMaxCachedGzipSize)
+        {
+            gzipData = GzipCache::instance()->lookup(file, *entry);
+        }
+        else
+        {
+            gzipStream = equalsIgnoreCase(m_version, "HTTP/1.1");
+        }
+        encoding = gzipData != nullptr || gzipStream ? "gzip" : "";
+    }
+    if (compressible || precompressed != nullptr)
+    {
+        response->addHeader("Vary", "Accept-Encoding");
+    }
+
+    // 压缩之后是不同的内容, 需要不同的 etag
+    shared_ptr<FileEntry> body = precompressed != nullptr ? precompressed : entry;
+    string etag = body->etag;
+    if (precompressed == nullptr && !encoding.empty())
+    {
+        etag.insert(etag.size() - 1, "-gzip");
+    }
+    response->addHeader("ETag", etag);
+    response->addHeader("Last-Modified", entry->lastModified);
+    if (notModified(etag, entry->lastModified))
+    {
+        // 客户端缓存的内容还是最新的, 不需要发送数据
+        response->setStatusCode(StatusCode::NotModified);
+        return false;
+    }
     response->setStatusCode(StatusCode::OK);
-    // 判断文件类型
-    if (S_ISDIR(st.st_mode))
+    response->addHeader("Content-type", type);
+    if (gzipStream && !response->setGzipBody(entry))
+    {
+        // 压缩流创建失败(内存不足), 发送原始数据
+        gzipStream = false;
+        encoding.clear();
+    }
+    response->addHeader("Content-Encoding", encoding);
+    if (gzipData != nullptr)
+    {
+        response->addHeader("Content-length", to_string(gzipData->size()));
+        response->setSharedBody(gzipData);
+    }
+    else if (gzipStream)
+    {
+        // 压缩之后的大小事先不知道, 使用 chunked 编码
+        response->addHeader("Transfer-Encoding", "chunked");
+    }
+    else if (isDir)
     {
         // 把这个目录中的内容发送给客户端
         //sendHeadMsg(cfd, 200, "OK", getFileType(".html"), -1);
         //sendDir(file, cfd);
-        // 响应头
-        response->addHeader("Content-type", getFileType(".html"));
-        response->sendDataFunc = sendDir;
+        response->addHeader("Content-length", to_string(entry->listing.size()));
+        response->setBody(entry->listing);
     }
     else
     {
-        // 把文件的内容发送给客户端
+        // 把文件(或者压缩好的文件)的内容发送给客户端
         //sendHeadMsg(cfd, 200, "OK", getFileType(file), st.st_size);
         //sendFile(file, cfd);
-        // 响应头
-        response->addHeader("Content-type", getFileType(file));
-        response->addHeader("Content-length", to_string(st.st_size));
-        response->sendDataFunc = sendFile;
+        response->addHeader("Accept-Ranges", "bytes");
+        size = body->st.st_size;
+        off_t start = 0;
+        off_t end = size - 1;
+        int ret = parseRange(*body, start, end);
+        if (ret < 0)
+        {
+            // 请求的范围超出了文件的大小
+            response->setStatusCode(StatusCode::RangeNotSatisfiable);
+            response->addHeader("Content-Range", "bytes */" + to_string(size));
+            response->addHeader("Content-length", "0");
+            return false;
+        }
+        if (ret > 0)
+        {
+            // 断点续传, 多线程下载: 只发送请求的部分
+            response->setStatusCode(StatusCode::PartialContent);
+            response->addHeader("Content-Range", "bytes " + to_string(start) + "-"
+                + to_string(end) + "/" + to_string(size));
+        }
+        response->addHeader("Content-length", to_string(end - start + 1));
+        response->setFileBody(body, start, end - start + 1);
+    }
+
+    return false;
+}
+
+bool HttpRequest::notModified(const string& etag, const string& lastModified)
+{
+    // If-None-Match 可能是 "*" 或者以逗号分隔的多个 etag, 优先于 If-Modified-Since
+    string_view etags = getHeader("If-None-Match");
+    if (!etags.empty())
+    {
+        return etags == "*" || etags.find(etag) != string_view::npos;
+    }
+    // 客户端回传的是之前响应中的 Last-Modified, 直接比较字符串
+    string_view since = getHeader("If-Modified-Since");
+    return !since.empty() && since == lastModified;
+}
+
+bool HttpRequest::acceptsEncoding(string_view coding)
+{
+    // Accept-Encoding: gzip, deflate;q=0.5, br;q=0, *;q=0.1
+    // 明确列出的编码优先于 *, q=0 表示不接受
+    string_view accept = getHeader("Accept-Encoding");
+    int matched = -1;
+    int wildcard = -1;
+    while (!accept.empty())
+    {
+        size_t comma = accept.find(',');
+        string_view item = accept.substr(0, comma);
+        accept.remove_prefix(comma == string_view::npos ? accept.size() : comma + 1);
+        size_t semicolon = item.find(';');
+        string_view name = item.substr(0, semicolon);
+        string_view params = semicolon == string_view::npos ? string_view() : item.substr(semicolon + 1);
+        while (!name.empty() && isspace(name.front()))
+        {
+            name.remove_prefix(1);
+        }
+        while (!name.empty() && isspace(name.back()))
+        {
+            name.remove_suffix(1);
+        }
+        // q 的取值是 0 到 1 之间的小数, 有一个不是 0 的数字就是接受
+        int accepted = 1;
+        size_t q = params.find("q=");
+        if (q != string_view::npos)
+        {
+            accepted = 0;
+            for (size_t i = q + 2; i < params.size() && (isdigit(params[i]) || params[i] == '.'); ++i)
+            {
+                if (params[i] >= '1' && params[i] <= '9')
+                {
+                    accepted = 1;
+                }
+            }
+        }
+        if (equalsIgnoreCase(name, coding))
+        {
+            matched = accepted;
+        }
+        else if (name == "*")
+        {
+            wildcard = accepted;
+        }
     }
+    return matched != -1 ? matched == 1 : wildcard == 1;
+}
+
+bool HttpRequest::isCompressible(const string& type)
+{
+    // 图片、音视频这些格式本身已经压缩过了
+    return type.compare(0, 5, "text/") == 0 || type.find("javascript") != string::npos
+        || type.find("json") != string::npos || type.find("xml") != string::npos;
+}
+
+shared_ptr<FileEntry> HttpRequest::lookupRegularFile(const string& path)
+{
+    shared_ptr<FileEntry> entry = FileCache::threadCache()->lookup(path);
+    return entry != nullptr && S_ISREG(entry->st.st_mode) ? entry : nullptr;
+}
 
+int HttpRequest::parseRange(const FileEntry& entry, off_t& start, off_t& end)
+{
+    string_view range = getHeader("Range");
+    if (range.size() <= 6 || strncasecmp(range.data(), "bytes=", 6) != 0)
+    {
+        return 0;
+    }
+    // If-Range: 客户端保存的部分内容已经过期了, 发送完整的文件
+    string_view ifRange = getHeader("If-Range");
+    if (!ifRange.empty() && ifRange != entry.etag && ifRange != entry.lastModified)
+    {
+        return 0;
+    }
+    range.remove_prefix(6);
+    // 多个范围需要使用 multipart/byteranges 格式, 不支持, 发送完整的文件
+    if (range.find(',') != string_view::npos)
+    {
+        return 0;
+    }
+    size_t dash = range.find('-');
+    if (dash == string_view::npos)
+    {
+        return 0;
+    }
+    // 范围内只能是数字, 格式不对忽略 Range
+    auto toNumber = [](string_view str, off_t& number) {
+        if (str.empty() || str.size() > 18)
+        {
+            return false;
+        }
+        number = 0;
+        for (char c : str)
+        {
+            if (!isdigit(c))
+            {
+                return false;
+            }
+            number = number * 10 + (c - '0');
+        }
+        return true;
+    };
+    off_t size = entry.st.st_size;
+    off_t first = 0;
+    off_t last = 0;
+    string_view firstStr = range.substr(0, dash);
+    string_view lastStr = range.substr(dash + 1);
+    if (firstStr.empty())
+    {
+        // bytes=-500: 最后 500 个字节
+        if (!toNumber(lastStr, last))
+        {
+            return 0;
+        }
+        if (last == 0 || size == 0)
+        {
+            return -1;
+        }
+        start = last < size ? size - last : 0;
+        end = size - 1;
+        return 1;
+    }
+    if (!toNumber(firstStr, first))
+    {
+        return 0;
+    }
+    if (lastStr.empty())
+    {
+        // bytes=500-: 从 500 开始到文件结束
+        last = size - 1;
+    }
+    else if (!toNumber(lastStr, last) || last < first)
+    {
+        return 0;
+    }
+    if (first >= size)
+    {
+        return -1;
+    }
+    start = first;
+    end = last < size ? last : size - 1;
+    return 1;
+}
+
+bool HttpRequest::keepAlive()
+{
+    string_view connection = getHeader("Connection");
+    if (equalsIgnoreCase(m_version, "HTTP/1.1"))
+    {
+        return !containsIgnoreCase(connection, "close");
+    }
+    return containsIgnoreCase(connection, "keep-alive");
+}
+
+bool HttpRequest::hasBody()
+{
+    if (!getHeader("Transfer-Encoding").empty())
+    {
+        return true;
+    }
+    string_view length = getHeader("Content-Length");
+    for (char c : length)
+    {
+        if (c != '0' && c != ' ')
+        {
+            return true;
+        }
+    }
     return false;
 }
 
-string HttpRequest::decodeMsg(string msg)
+void HttpRequest::decodeMsg(string_view from, string& to)
 {
-    string str = string();
-    const char* from = msg.data();
-    for (; *from != '\0'; ++from)
+    to.clear();
+    for (size_t i = 0; i < from.size(); ++i)
     {
         // isxdigit -> 判断字符是不是16进制格式, 取值在 0-f
         // Linux%E5%86%85%E6%A0%B8.jpg
-        if (from[0] == '%' && isxdigit(from[1]) && isxdigit(from[2]))
+        if (from[i] == '%' && i + 2 < from.size() && isxdigit(from[i + 1]) && isxdigit(from[i + 2]))
         {
             // 将16进制的数 -> 十进制 将这个数值赋值给了字符 int -> char
             // B2 == 178
             // 将3个字符, 变成了一个字符, 这个字符就是原始数据
-            str.append(1, hexToDec(from[1]) * 16 + hexToDec(from[2]));
+            to.push_back(hexToDec(from[i + 1]) * 16 + hexToDec(from[i + 2]));
 
-            // 跳过 from[1] 和 from[2] 因此在当前循环中已经处理过了
-            from += 2;
+            // 跳过 from[i + 1] 和 from[i + 2] 因此在当前循环中已经处理过了
+            i += 2;
         }
         else
         {
             // 字符拷贝, 赋值
-            str.append(1, *from);
+            to.push_back(from[i]);
         }
     }
-    str.append(1, '\0');
-    return str;
 }
 
 const string HttpRequest::getFileType(const string name)
@@ -274,6 +598,14 @@ const string HttpRequest::getFileType(const string name)
         return "image/png";
     if (strcmp(dot, ".css") == 0)
         return "text/css";
+    if (strcmp(dot, ".js") == 0)
+        return "application/javascript";
+    if (strcmp(dot, ".json") == 0)
+        return "application/json";
+    if (strcmp(dot, ".xml") == 0)
+        return "text/xml";
+    if (strcmp(dot, ".svg") == 0)
+        return "image/svg+xml";
     if (strcmp(dot, ".au") == 0)
         return "audio/basic";
     if (strcmp(dot, ".wav") == 0)
@@ -297,92 +629,3 @@ const string HttpRequest::getFileType(const string name)
 
     return "text/plain; charset=utf-8";
 }
-
-void HttpRequest::sendDir(string dirName, Buffer* sendBuf, int cfd)
-{
-    char buf[4096] = { 0 };
-    sprintf(buf, "<html><head><title>%s</title></head><body><table>", dirName.data());
-    struct dirent** namelist;
-    int num = scandir(dirName.data(), &namelist, NULL, alphasort);
-    for (int i = 0; i < num; ++i)
-    {
-        // 取出文件名 namelist 指向的是一个指针数组 struct dirent* tmp[]
-        char* name = namelist[i]->d_name;
-        struct stat st;
-        char subPath[1024] = { 0 };
-        sprintf(subPath, "%s/%s", dirName.data(), name);
-        stat(subPath, &st);
-        if (S_ISDIR(st.st_mode))
-        {
-            // a标签 <a href="">name</a>
-            sprintf(buf + strlen(buf),
-                "<tr><td><a href=\"%s/\">%s</a></td><td>%ld</td></tr>",
-                name, name, st.st_size);
-        }
-        else
-        {
-            sprintf(buf + strlen(buf),
-                "<tr><td><a href=\"%s\">%s</a></td><td>%ld</td></tr>",
-                name, name, st.st_size);
-        }
-        // send(cfd, buf, strlen(buf), 0);
-        sendBuf->appendString(buf);
-#ifndef MSG_SEND_AUTO
-        sendBuf->sendData(cfd);
-#endif
-        memset(buf, 0, sizeof(buf));
-        free(namelist[i]);
-    }
-    sprintf(buf, "</table></body></html>");
-    // send(cfd, buf, strlen(buf), 0);
-    sendBuf->appendString(buf);
-#ifndef MSG_SEND_AUTO
-    sendBuf->sendData(cfd);
-#endif
-    free(namelist);
-}
-
-void HttpRequest::sendFile(string fileName, Buffer* sendBuf, int cfd)
-{
-    // 1. 打开文件
-    int fd = open(fileName.data(), O_RDONLY);
-    assert(fd > 0);
-#if 1
-    while (1)
-    {
-        char buf[1024];
-        int len = read(fd, buf, sizeof buf);
-        if (len > 0)
-        {
-            // send(cfd, buf, len, 0);
-            sendBuf->appendString(buf, len);
-#ifndef MSG_SEND_AUTO
-            sendBuf->sendData(cfd);
-#endif
-        }
-        else if (len == 0)
-        {
-            break;
-        }
-        else
-        {
-            close(fd);
-            perror("read");
-        }
-    }
-#else
-    off_t offset = 0;
-    int size = lseek(fd, 0, SEEK_END);
-    lseek(fd, 0, SEEK_SET);
-    while (offset < size)
-    {
-        int ret = sendfile(cfd, fd, &offset, size - offset);
-        printf("ret value: %d\n", ret);
-        if (ret == -1 && errno == EAGAIN)
-        {
-            printf("没数据...\n");
-        }
-    }
-#endif
-    close(fd);
-}
@@ -3,17 +3,36 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <algorithm>
 
 HttpResponse::HttpResponse()
+{
+    m_gzipBuf = nullptr;
+    reset();
+}
+
+void HttpResponse::reset()
 {
     m_statusCode = StatusCode::Unknown;
     m_headers.clear();
-    m_fileName = string();
-    sendDataFunc = nullptr;
+    m_body.clear();
+    m_sharedBody.reset();
+    m_file.reset();
+    m_gzip.reset();
+    if (m_gzipBuf != nullptr)
+    {
+        m_gzipBuf->readPosIncrease(m_gzipBuf->readableSize());
+    }
+    m_bodyOffset = 0;
+    m_bodyRemaining = 0;
 }
 
 HttpResponse::~HttpResponse()
 {
+    delete m_gzipBuf;
 }
 
 void HttpResponse::addHeader(const string key, const string value)
@@ -25,7 +44,36 @@ void HttpResponse::addHeader(const string key, const string value)
     m_headers.insert(make_pair(key, value));
 }
 
-void HttpResponse::prepareMsg(Buffer* sendBuf, int socket)
+void HttpResponse::setSharedBody(shared_ptr<const string> body)
+{
+    m_sharedBody = body;
+    m_bodyOffset = 0;
+    m_bodyRemaining = body->size();
+}
+
+bool HttpResponse::setGzipBody(shared_ptr<FileEntry> file)
+{
+    m_gzip = make_unique<GzipStream>(file);
+    if (!m_gzip->isValid())
+    {
+        m_gzip.reset();
+        return false;
+    }
+    if (m_gzipBuf == nullptr)
+    {
+        m_gzipBuf = new Buffer(32 * 1024);
+    }
+    return true;
+}
+
+void HttpResponse::setFileBody(shared_ptr<FileEntry> file, off_t offset, size_t length)
+{
+    m_file = file;
+    m_bodyOffset = offset;
+    m_bodyRemaining = length;
+}
+
+void HttpResponse::prepareMsg(Buffer* sendBuf)
 {
     // 状态行
     char tmp[1024] = { 0 };
@@ -40,10 +88,61 @@ void HttpResponse::prepareMsg(Buffer* sendBuf, int socket)
     }
     // 空行
     sendBuf->appendString("\r\n");
-#ifndef MSG_SEND_AUTO
-    sendBuf->sendData(socket);
-#endif
-
     // 回复的数据
-    sendDataFunc(m_fileName, sendBuf, socket);
+    if (!m_body.empty())
+    {
+        sendBuf->appendString(m_body);
+    }
+}
+
+ssize_t HttpResponse::sendBody(int socket, size_t budget)
+{
+    if (m_gzip != nullptr)
+    {
+        return sendGzipBody(socket);
+    }
+    ssize_t count = 0;
+    if (m_sharedBody != nullptr)
+    {
+        count = send(socket, m_sharedBody->data() + m_bodyOffset, min(m_bodyRemaining, budget), MSG_NOSIGNAL);
+        if (count > 0)
+        {
+            m_bodyOffset += count;
+        }
+    }
+    else
+    {
+        // 文件描述符被多个请求共用, sendfile 使用自己的偏移量, 不修改文件的读写位置
+        count = sendfile(socket, m_file->fd, &m_bodyOffset, min(m_bodyRemaining, budget));
+    }
+    if (count > 0)
+    {
+        m_bodyRemaining -= count;
+        if (m_bodyRemaining == 0)
+        {
+            m_sharedBody.reset();
+            m_file.reset();
+        }
+    }
+    return count;
+}
+
+ssize_t HttpResponse::sendGzipBody(int socket)
+{
+    // 压缩好的数据发送完了才继续压缩, 发送不出去的时候最多积压一块压缩数据
+    while (m_gzipBuf->readableSize() == 0)
+    {
+        if (!m_gzip->compressChunk(m_gzipBuf))
+        {
+            // 读取文件失败, 响应只能发送一半, 断开连接
+            errno = EIO;
+            return -1;
+        }
+    }
+    ssize_t count = m_gzipBuf->sendData(socket);
+    if (m_gzipBuf->readableSize() == 0 && m_gzip->finished())
+    {
+        m_gzip.reset();
+    }
+    return count;
 }
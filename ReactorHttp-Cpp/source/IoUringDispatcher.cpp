@@ -0,0 +1,399 @@
+#include "Dispatcher.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include "IoUringDispatcher.h"
+
+#ifdef REACTOR_HAVE_URING
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <algorithm>
+
+// 取消 poll 请求(POLL_REMOVE)自己的完成事件, 直接丢弃
+static const uint64_t kIgnoreToken = UINT64_MAX;
+
+static int ioUringSetup(unsigned entries, struct io_uring_params* p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags, const void* arg, size_t argsz)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argsz);
+}
+
+IoUringDispatcher::IoUringDispatcher(EventLoop* evloop) : Dispatcher(evloop)
+{
+    m_name = "IoUring";
+    if (!setupRing())
+    {
+        teardownRing();
+    }
+}
+
+IoUringDispatcher::~IoUringDispatcher()
+{
+    teardownRing();
+}
+
+bool IoUringDispatcher::setupRing()
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = m_cqSize;
+    m_ringfd = ioUringSetup(m_sqSize, &params);
+    if (m_ringfd == -1)
+    {
+        perror("io_uring_setup");
+        return false;
+    }
+    // dispatch 的超时依赖 IORING_ENTER_EXT_ARG(5.11), 完成队列满了不丢事件依赖 IORING_FEAT_NODROP
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP))
+    {
+        printf("io_uring features 0x%x not supported\n", params.features);
+        return false;
+    }
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap)
+    {
+        m_sqRingSize = m_cqRingSize = max(m_sqRingSize, m_cqRingSize);
+    }
+    m_sqRing = mmap(NULL, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringfd, IORING_OFF_SQ_RING);
+    if (m_sqRing == MAP_FAILED)
+    {
+        m_sqRing = nullptr;
+        perror("mmap sq ring");
+        return false;
+    }
+    if (singleMmap)
+    {
+        m_cqRing = m_sqRing;
+    }
+    else
+    {
+        m_cqRing = mmap(NULL, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringfd, IORING_OFF_CQ_RING);
+        if (m_cqRing == MAP_FAILED)
+        {
+            m_cqRing = nullptr;
+            perror("mmap cq ring");
+            return false;
+        }
+    }
+    m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(NULL, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringfd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        perror("mmap sqes");
+        return false;
+    }
+    m_sqes = (struct io_uring_sqe*)sqes;
+
+    char* sq = (char*)m_sqRing;
+    m_sqHead = (unsigned*)(sq + params.sq_off.head);
+    m_sqTail = (unsigned*)(sq + params.sq_off.tail);
+    m_sqMask = *(unsigned*)(sq + params.sq_off.ring_mask);
+    m_sqEntries = *(unsigned*)(sq + params.sq_off.ring_entries);
+    m_sqArray = (unsigned*)(sq + params.sq_off.array);
+    char* cq = (char*)m_cqRing;
+    m_cqHead = (unsigned*)(cq + params.cq_off.head);
+    m_cqTail = (unsigned*)(cq + params.cq_off.tail);
+    m_cqMask = *(unsigned*)(cq + params.cq_off.ring_mask);
+    m_cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return true;
+}
+
+void IoUringDispatcher::teardownRing()
+{
+    if (m_sqes != nullptr)
+    {
+        munmap(m_sqes, m_sqesSize);
+        m_sqes = nullptr;
+    }
+    if (m_cqRing != nullptr && m_cqRing != m_sqRing)
+    {
+        munmap(m_cqRing, m_cqRingSize);
+    }
+    m_cqRing = nullptr;
+    if (m_sqRing != nullptr)
+    {
+        munmap(m_sqRing, m_sqRingSize);
+        m_sqRing = nullptr;
+    }
+    if (m_ringfd != -1)
+    {
+        close(m_ringfd);
+        m_ringfd = -1;
+    }
+}
+
+int IoUringDispatcher::add()
+{
+    int fd = m_channel->getSocket();
+    Registration& reg = registration(fd);
+    reg.registered = true;
+    reg.events = 0;
+    if (m_channel->getEvent() & (int)FDEvent::ReadEvent)
+    {
+        reg.events |= POLLIN;
+    }
+    if (m_channel->getEvent() & (int)FDEvent::WriteEvent)
+    {
+        reg.events |= POLLOUT;
+    }
+    arm(fd);
+    return 0;
+}
+
+int IoUringDispatcher::remove()
+{
+    int fd = m_channel->getSocket();
+    Registration& reg = registration(fd);
+    disarm(fd);
+    reg.registered = false;
+    return 0;
+}
+
+int IoUringDispatcher::modify()
+{
+    int fd = m_channel->getSocket();
+    Registration& reg = registration(fd);
+    // 取消原来的 poll 请求, 按照新的事件重新提交
+    disarm(fd);
+    reg.events = 0;
+    if (m_channel->getEvent() & (int)FDEvent::ReadEvent)
+    {
+        reg.events |= POLLIN;
+    }
+    if (m_channel->getEvent() & (int)FDEvent::WriteEvent)
+    {
+        reg.events |= POLLOUT;
+    }
+    arm(fd);
+    return 0;
+}
+
+int IoUringDispatcher::dispatch(int timeout)
+{
+    // 提交队列满了没有提交出去的取消请求, 先重新提交
+    size_t pendingCancels = 0;
+    for (uint64_t token : m_cancels)
+    {
+        if (!submitCancel(token))
+        {
+            m_cancels[pendingCancels++] = token;
+        }
+    }
+    m_cancels.resize(pendingCancels);
+
+    // 上一轮完成的 poll 请求是单次的, 事件已经处理过了, 重新提交
+    // 提交队列满了没有提交成功的会被 arm 放回 m_fired, 这一轮不等待, 尽快回来重试
+    m_rearming.swap(m_fired);
+    for (int fd : m_rearming)
+    {
+        Registration& reg = m_registrations[fd];
+        if (reg.registered && !reg.armed)
+        {
+            arm(fd);
+        }
+    }
+    m_rearming.clear();
+    if (!m_fired.empty() || !m_cancels.empty())
+    {
+        timeout = 0;
+    }
+
+    // 提交所有的请求并等待至少一个完成事件, 超时时长通过 IORING_ENTER_EXT_ARG 传递
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    if (timeout >= 0)
+    {
+        ts.tv_sec = timeout / 1000;
+        ts.tv_nsec = (timeout % 1000) * 1000000LL;
+        arg.ts = (uint64_t)&ts;
+    }
+    int ret = ioUringEnter(m_ringfd, m_toSubmit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    if (ret >= 0)
+    {
+        m_toSubmit -= ret;
+    }
+    else if (errno != ETIME && errno != EINTR && errno != EBUSY)
+    {
+        perror("io_uring_enter");
+    }
+
+    unsigned head = *m_cqHead;
+    unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head)
+    {
+        struct io_uring_cqe* cqe = &m_cqes[head & m_cqMask];
+        if (cqe->user_data == kIgnoreToken)
+        {
+            continue;
+        }
+        int fd = (int)(cqe->user_data & 0xffffffff);
+        uint32_t generation = (uint32_t)(cqe->user_data >> 32);
+        // 前面的事件回调中可能已经删除或者修改了这个 fd, 完成事件已经过期
+        if (fd >= (int)m_registrations.size())
+        {
+            continue;
+        }
+        Registration& reg = m_registrations[fd];
+        if (!reg.registered || !reg.armed || reg.generation != generation)
+        {
+            continue;
+        }
+        reg.armed = false;
+        m_fired.push_back(fd);
+        // 对方断开了连接或者出错了, 当作读事件处理, 读数据的时候失败会删除 fd
+        int events = cqe->res < 0 ? POLLERR : cqe->res;
+        int active = 0;
+        if (events & (POLLIN | POLLERR | POLLHUP))
+        {
+            active |= (int)FDEvent::ReadEvent;
+        }
+        if (events & POLLOUT)
+        {
+            active |= (int)FDEvent::WriteEvent;
+        }
+        if (active != 0)
+        {
+            m_evLoop->eventActive(fd, active);
+        }
+    }
+    __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+    return 0;
+}
+
+IoUringDispatcher::Registration& IoUringDispatcher::registration(int fd)
+{
+    if (fd >= (int)m_registrations.size())
+    {
+        m_registrations.resize(max(fd + 1, (int)m_registrations.size() * 2));
+    }
+    return m_registrations[fd];
+}
+
+bool IoUringDispatcher::arm(int fd)
+{
+    Registration& reg = registration(fd);
+    struct io_uring_sqe* sqe = getSqe();
+    if (sqe == nullptr)
+    {
+        // 在下一轮 dispatch 开始时重新提交
+        reg.armed = false;
+        m_fired.push_back(fd);
+        return false;
+    }
+    ++reg.generation;
+    reg.armed = true;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = reg.events;
+    sqe->user_data = makeToken(fd, reg.generation);
+    return true;
+}
+
+void IoUringDispatcher::disarm(int fd)
+{
+    Registration& reg = registration(fd);
+    if (!reg.armed)
+    {
+        return;
+    }
+    // 提交不出去的取消请求下一轮 dispatch 开始时重新提交, poll 请求持有文件的引用, 不取消的话 fd 关闭之后连接也不会断开
+    uint64_t token = makeToken(fd, reg.generation);
+    if (!submitCancel(token))
+    {
+        m_cancels.push_back(token);
+    }
+    // 被取消的 poll 请求还会产生一个 -ECANCELED 的完成事件, generation 变了就会被丢弃
+    ++reg.generation;
+    reg.armed = false;
+}
+
+bool IoUringDispatcher::submitCancel(uint64_t token)
+{
+    struct io_uring_sqe* sqe = getSqe();
+    if (sqe == nullptr)
+    {
+        return false;
+    }
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = token;
+    sqe->user_data = kIgnoreToken;
+    return true;
+}
+
+struct io_uring_sqe* IoUringDispatcher::getSqe()
+{
+    unsigned tail = *m_sqTail;
+    unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+    if (tail - head >= m_sqEntries)
+    {
+        // 提交队列满了, 先提交, 不等待
+        int ret = ioUringEnter(m_ringfd, m_toSubmit, 0, 0, NULL, 0);
+        if (ret > 0)
+        {
+            m_toSubmit -= ret;
+        }
+        head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+        if (tail - head >= m_sqEntries)
+        {
+            // 完成队列积压太多的时候内核拒绝提交(EBUSY), 需要先在 dispatch 中处理完成事件
+            return nullptr;
+        }
+    }
+    unsigned index = tail & m_sqMask;
+    struct io_uring_sqe* sqe = &m_sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    m_sqArray[index] = index;
+    __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+    ++m_toSubmit;
+    return sqe;
+}
+
+#else // REACTOR_HAVE_URING
+
+// 编译环境没有 io_uring, isValid() 返回 false
+IoUringDispatcher::IoUringDispatcher(EventLoop* evloop) : Dispatcher(evloop)
+{
+    m_name = "IoUring";
+    printf("io_uring is not supported by this build\n");
+}
+
+IoUringDispatcher::~IoUringDispatcher()
+{
+}
+
+int IoUringDispatcher::add()
+{
+    return -1;
+}
+
+int IoUringDispatcher::remove()
+{
+    return -1;
+}
+
+int IoUringDispatcher::modify()
+{
+    return -1;
+}
+
+int IoUringDispatcher::dispatch(int)
+{
+    return -1;
+}
+
+#endif // REACTOR_HAVE_URING
@@ -64,8 +64,6 @@ int PollDispatcher::remove()
             break;
         }
     }
-    // 通过 channel 释放对应的 TcpConnection 资源
-    m_channel->destroyCallback(const_cast<void*>(m_channel->getArg()));
     if (i >= m_maxNode)
     {
         return -1;
@@ -102,7 +100,7 @@ int PollDispatcher::modify()
 
 int PollDispatcher::dispatch(int timeout)
 {
-    int count = poll(m_fds, m_maxfd + 1, timeout * 1000);
+    int count = poll(m_fds, m_maxfd + 1, timeout);
     if (count == -1)
     {
         perror("poll");
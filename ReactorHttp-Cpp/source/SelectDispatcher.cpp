@@ -28,24 +28,23 @@ int SelectDispatcher::add()
 int SelectDispatcher::remove()
 {
     clearFdSet();
-    // 通过 channel 释放对应的 TcpConnection 资源
-    m_channel->destroyCallback(const_cast<void*>(m_channel->getArg()));
-
     return 0;
 }
 
 int SelectDispatcher::modify()
 {
+    // 先从两个集合中都删除, 再按照 channel 现在的事件重新添加
+    FD_CLR(m_channel->getSocket(), &m_readSet);
+    FD_CLR(m_channel->getSocket(), &m_writeSet);
     setFdSet();
-    clearFdSet();
     return 0;
 }
 
 int SelectDispatcher::dispatch(int timeout)
 {
     struct timeval val;
-    val.tv_sec = timeout;
-    val.tv_usec = 0;
+    val.tv_sec = timeout / 1000;
+    val.tv_usec = (timeout % 1000) * 1000;
     fd_set rdtmp = m_readSet;
     fd_set wrtmp = m_writeSet;
     int count = select(m_maxSize, &rdtmp, &wrtmp, NULL, &val);
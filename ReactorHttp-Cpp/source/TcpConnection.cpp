@@ -1,7 +1,13 @@
 #include "TcpConnection.h"
 #include "HttpRequest.h"
+#include "ThreadPool.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <algorithm>
 #include "Log.h"
 
 int TcpConnection::processRead(void* arg)
@@ -11,36 +17,16 @@ int TcpConnection::processRead(void* arg)
     int socket = conn->m_channel->getSocket();
     int count = conn->m_readBuf->socketRead(socket);
 
-    Debug("接收到的http请求数据: %s", conn->m_readBuf->data());
+    Debug("接收到的http请求数据: %.*s", (int)conn->m_readBuf->readableSize(), conn->m_readBuf->data());
     if (count > 0)
     {
-        // 接收到了 http 请求, 解析http请求
-#ifdef MSG_SEND_AUTO
-        conn->m_channel->writeEventEnable(true);
-        conn->m_evLoop->addTask(conn->m_channel, ElemType::MODIFY);
-#endif
-        bool flag = conn->m_request->parseHttpRequest(
-            conn->m_readBuf, conn->m_response,
-            conn->m_writeBuf, socket);
-        if (!flag)
-        {
-            // 解析失败, 回复一个简单的html
-            string errMsg = "Http/1.1 400 Bad Request\r\n\r\n";
-            conn->m_writeBuf->appendString(errMsg);
-        }
+        conn->m_lastActive = TimerQueue::nowMs();
+        // 正在发送上一个响应的时候收到的请求(pipeline)先留在 readBuf 中, 发送完之后再处理
+        conn->sendPending();
+        return 0;
     }
-    else
-    {
-#ifdef MSG_SEND_AUTO
-        // 断开连接
-        conn->m_evLoop->addTask(conn->m_channel, ElemType::DELETE);
-#endif
-
-    }
-#ifndef MSG_SEND_AUTO
     // 断开连接
     conn->m_evLoop->addTask(conn->m_channel, ElemType::DELETE);
-#endif
     return 0;
 }
 
@@ -48,21 +34,7 @@ int TcpConnection::processWrite(void* arg)
 {
     Debug("开始发送数据了(基于写事件发送)....");
     TcpConnection* conn = static_cast<TcpConnection*>(arg);
-    // 发送数据
-    int count = conn->m_writeBuf->sendData(conn->m_channel->getSocket());
-    if (count > 0)
-    {
-        // 判断数据是否被全部发送出去了
-        if (conn->m_writeBuf->readableSize() == 0)
-        {
-            // 1. 不再检测写事件 -- 修改channel中保存的事件
-            conn->m_channel->writeEventEnable(false);
-            // 2. 修改dispatcher检测的集合 -- 添加任务节点
-            conn->m_evLoop->addTask(conn->m_channel, ElemType::MODIFY);
-            // 3. 删除这个节点
-            conn->m_evLoop->addTask(conn->m_channel, ElemType::DELETE);
-        }
-    }
+    conn->sendPending();
     return 0;
 }
 
@@ -76,7 +48,192 @@ int TcpConnection::destroy(void* arg)
     return 0;
 }
 
-TcpConnection::TcpConnection(int fd, EventLoop* evloop)
+bool TcpConnection::processRequests()
+{
+    // 接收到了 http 请求, 解析http请求, 一次可能收到多个请求(pipeline)
+    bool processed = false;
+    while (m_readBuf->readableSize() > 0)
+    {
+        bool flag = m_request->parseHttpRequest(m_readBuf);
+        if (!flag)
+        {
+            // 解析失败, 回复一个简单的html
+            string errMsg = "Http/1.1 400 Bad Request\r\n\r\n";
+            m_writeBuf->appendString(errMsg);
+            m_keepAlive = false;
+            return true;
+        }
+        if (m_request->getState() != PrecessState::ParseReqDone)
+        {
+            // 请求不完整, 等待后续的数据, 从第一次收到这个请求的数据开始计时
+            if (m_requestStart == 0)
+            {
+                m_requestStart = TimerQueue::nowMs();
+            }
+            break;
+        }
+        m_requestStart = 0;
+        processRequest();
+        processed = true;
+        // 响应体发送完之前不能处理下一个请求, 否则响应的顺序就乱了
+        if (!m_keepAlive || m_response->bodyPending())
+        {
+            break;
+        }
+    }
+    return processed;
+}
+
+void TcpConnection::sendPending()
+{
+    int socket = m_channel->getSocket();
+    size_t budget = kWriteBudget;
+    while (budget > 0)
+    {
+        ssize_t count = 0;
+        if (m_writeBuf->readableSize() > 0)
+        {
+            // 先发送状态行、响应头和内存中的响应体
+            count = m_writeBuf->sendData(socket);
+        }
+        else if (m_response->bodyPending())
+        {
+            // 再发送文件(或者压缩流)中的数据, 文件在发送过程中被截断了就只能断开连接
+            count = m_response->sendBody(socket, budget);
+            if (count == 0)
+            {
+                break;
+            }
+        }
+        else
+        {
+            // 当前的响应发送完了, 处理已经收到的下一个请求
+            if (m_responding && !m_keepAlive)
+            {
+                break;
+            }
+            m_responding = processRequests();
+            if (!m_responding)
+            {
+                // 没有需要发送的数据了, 不再检测写事件
+                if (m_channel->isWriteEventEnable())
+                {
+                    m_channel->writeEventEnable(false);
+                    m_evLoop->addTask(m_channel, ElemType::MODIFY);
+                }
+                migrate();
+                return;
+            }
+            continue;
+        }
+        if (count < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                break;
+            }
+            // 发送缓冲区满了, 等待写事件
+            if (!m_channel->isWriteEventEnable())
+            {
+                m_channel->writeEventEnable(true);
+                m_evLoop->addTask(m_channel, ElemType::MODIFY);
+            }
+            return;
+        }
+        // 发送大文件的过程中客户端不会发送数据, 发送数据也算作活跃
+        m_lastActive = TimerQueue::nowMs();
+        budget -= min(budget, (size_t)count);
+    }
+    if (budget == 0)
+    {
+        // 这一轮发送的数据够多了, 让同一个反应堆上的其他连接也有机会发送, 通过写事件继续发送
+        if (!m_channel->isWriteEventEnable())
+        {
+            m_channel->writeEventEnable(true);
+            m_evLoop->addTask(m_channel, ElemType::MODIFY);
+        }
+        return;
+    }
+    // 断开连接
+    m_evLoop->addTask(m_channel, ElemType::DELETE);
+}
+
+void TcpConnection::processRequest()
+{
+    m_response->reset();
+    m_request->processHttpRequest(m_response);
+    ++m_requestCount;
+    // 没有 Content-length 的响应只能通过断开连接告诉客户端响应结束
+    // 请求体没有被读走, 保持连接的话会被当成下一个请求解析
+    m_keepAlive = m_request->keepAlive() && !m_request->hasBody() && m_response->hasContentLength()
+        && m_requestCount < m_maxRequests;
+    if (m_keepAlive)
+    {
+        m_response->addHeader("Connection", "keep-alive");
+        m_response->addHeader("Keep-Alive", "timeout=" + to_string(m_idleTimeout / 1000)
+            + ", max=" + to_string(m_maxRequests - m_requestCount));
+    }
+    else
+    {
+        m_response->addHeader("Connection", "close");
+    }
+    m_response->prepareMsg(m_writeBuf);
+    // 为下一个请求做准备
+    m_request->reset();
+}
+
+void TcpConnection::checkIdle()
+{
+    // 期间收到过数据, 从最近一次收到数据的时间开始重新计时
+    // 但是不完整的请求从开始接收算起, 客户端一个字节一个字节地发送也不能一直占着连接
+    int64_t now = TimerQueue::nowMs();
+    int64_t deadline = m_lastActive + m_idleTimeout;
+    if (m_requestStart != 0)
+    {
+        deadline = min(deadline, m_requestStart + m_idleTimeout);
+    }
+    if (now >= deadline)
+    {
+        Debug("连接空闲或者请求超时, 断开连接, connName: %s", m_name.c_str());
+        m_idleTimerId = 0;
+        m_evLoop->addTask(m_channel, ElemType::DELETE);
+    }
+    else
+    {
+        m_idleTimerId = m_evLoop->addTimer(deadline - now, bind(&TcpConnection::checkIdle, this));
+    }
+}
+
+bool TcpConnection::migrate()
+{
+    if (m_threadPool == nullptr || m_requestCount - m_migratedAt < kHotRequests)
+    {
+        return false;
+    }
+    EventLoop* target = m_threadPool->takeMigrationTarget(m_evLoop);
+    if (target == nullptr)
+    {
+        return false;
+    }
+    Debug("连接迁移, connName: %s, %s -> %s", m_name.c_str(), m_evLoop->getThreadName().c_str(),
+        target->getThreadName().c_str());
+    // 空闲定时器属于原来的反应堆, 取消之后在目标反应堆中重新设置
+    if (m_idleTimerId != 0)
+    {
+        m_evLoop->cancelTimer(m_idleTimerId);
+    }
+    m_evLoop->detach(m_channel);
+    m_evLoop->connectionClosed();
+    m_migratedAt = m_requestCount;
+    m_evLoop = target;
+    target->connectionOpened();
+    // 先设置定时器再添加 channel, 添加之后目标反应堆就可能开始处理这个连接
+    m_idleTimerId = target->addTimer(m_idleTimeout, bind(&TcpConnection::checkIdle, this));
+    target->addTask(m_channel, ElemType::ADD);
+    return true;
+}
+
+TcpConnection::TcpConnection(int fd, EventLoop* evloop, int idleTimeout, int maxRequests, ThreadPool* threadPool)
 {
     m_evLoop = evloop;
     m_readBuf = new Buffer(10240);
@@ -85,20 +242,40 @@ TcpConnection::TcpConnection(int fd, EventLoop* evloop)
     m_request = new HttpRequest;
     m_response = new HttpResponse;
     m_name = "Connection-" + to_string(fd);
+    // 所有的数据都通过写事件发送, 不能阻塞反应堆线程
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    // 响应头和文件内容分两次发送, 关闭 Nagle 算法, 否则文件内容要等响应头的 ACK(延迟确认 40ms)
+    int opt = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    // keep-alive
+    m_idleTimeout = idleTimeout;
+    m_maxRequests = maxRequests;
+    m_requestCount = 0;
+    m_keepAlive = false;
+    m_responding = false;
+    m_lastActive = TimerQueue::nowMs();
+    m_requestStart = 0;
+    m_threadPool = threadPool;
+    m_migratedAt = 0;
+    evloop->connectionOpened();
     m_channel = new Channel(fd, FDEvent::ReadEvent, processRead, processWrite, destroy, this);
+    // 空闲定时器不随每个请求刷新, 到期时再检查最近一次收到数据的时间
+    m_idleTimerId = evloop->addTimer(m_idleTimeout, bind(&TcpConnection::checkIdle, this));
     evloop->addTask(m_channel, ElemType::ADD);
 }
 
 TcpConnection::~TcpConnection()
 {
-    if (m_readBuf && m_readBuf->readableSize() == 0 &&
-        m_writeBuf && m_writeBuf->readableSize() == 0)
+    if (m_idleTimerId != 0)
     {
-        delete m_readBuf;
-        delete m_writeBuf;
-        delete m_request;
-        delete m_response;
-        m_evLoop->freeChannel(m_channel);
+        m_evLoop->cancelTimer(m_idleTimerId);
     }
+    // 保持连接时缓冲区中可能还有下一个请求的数据, 同样需要释放
+    delete m_readBuf;
+    delete m_writeBuf;
+    delete m_request;
+    delete m_response;
+    m_evLoop->connectionClosed();
+    m_evLoop->freeChannel(m_channel);
     Debug("连接断开, 释放资源, gameover, connName: %s", m_name.c_str());
 }
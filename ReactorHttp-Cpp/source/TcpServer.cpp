@@ -3,6 +3,8 @@
 #include "TcpConnection.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
 #include "Log.h"
 
 int TcpServer::acceptConnection(void* arg)
@@ -10,13 +12,23 @@ int TcpServer::acceptConnection(void* arg)
     TcpServer* server = static_cast<TcpServer*>(arg);
     // 和客户端建立连接
     int cfd = accept(server->m_lfd, NULL, NULL);
+    if (cfd == -1)
+    {
+        perror("accept");
+        return -1;
+    }
     // 从线程池中取出一个子线程的反应堆实例, 去处理这个cfd
     EventLoop* evLoop = server->m_threadPool->takeWorkerEventLoop();
-    // 将cfd放到 TcpConnection中处理
-    new TcpConnection(cfd, evLoop);
+    server->newConnection(cfd, evLoop);
     return 0;
 }
 
+void TcpServer::newConnection(int cfd, EventLoop* evLoop)
+{
+    // 将cfd放到 TcpConnection中处理
+    new TcpConnection(cfd, evLoop, m_idleTimeout, m_maxRequests, m_migration ? m_threadPool : nullptr);
+}
+
 TcpServer::TcpServer(unsigned short port, int threadNum)
 {
     m_port = port;
@@ -27,51 +39,129 @@ TcpServer::TcpServer(unsigned short port, int threadNum)
 }
 
 void TcpServer::setListen()
+{
+    m_lfd = listenSocket();
+}
+
+void TcpServer::setReusePort(bool flag)
+{
+    if (flag == m_reusePort)
+    {
+        return;
+    }
+    // 同一个端口上的所有套接字都要设置 SO_REUSEPORT, 重新创建监听的套接字
+    m_reusePort = flag;
+    if (m_lfd != -1)
+    {
+        close(m_lfd);
+    }
+    setListen();
+}
+
+int TcpServer::listenSocket()
 {
     // 1. 创建监听的fd
-    m_lfd = socket(AF_INET, SOCK_STREAM, 0);
-    if (m_lfd == -1)
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (lfd == -1)
     {
         perror("socket");
-        return;
+        return -1;
     }
     // 2. 设置端口复用
     int opt = 1;
-    int ret = setsockopt(m_lfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof opt);
+    int ret = setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof opt);
     if (ret == -1)
     {
         perror("setsockopt");
-        return;
+        close(lfd);
+        return -1;
+    }
+    if (m_reusePort)
+    {
+        ret = setsockopt(lfd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof opt);
+        if (ret == -1)
+        {
+            perror("setsockopt");
+            close(lfd);
+            return -1;
+        }
     }
     // 3. 绑定
     struct sockaddr_in addr;
     addr.sin_family = AF_INET;
     addr.sin_port = htons(m_port);
     addr.sin_addr.s_addr = INADDR_ANY;
-    ret = bind(m_lfd, (struct sockaddr*)&addr, sizeof addr);
+    ret = bind(lfd, (struct sockaddr*)&addr, sizeof addr);
     if (ret == -1)
     {
         perror("bind");
-        return ;
+        close(lfd);
+        return -1;
     }
     // 4. 设置监听
-    ret = listen(m_lfd, 128);
+    ret = listen(lfd, 128);
     if (ret == -1)
     {
         perror("listen");
-        return ;
+        close(lfd);
+        return -1;
     }
+    return lfd;
 }
 
 void TcpServer::run()
 {
     Debug("服务器程序已经启动了...");
+    // 客户端提前断开连接时 sendfile 会触发 SIGPIPE, 忽略这个信号, 通过返回值处理
+    signal(SIGPIPE, SIG_IGN);
     // 启动线程池
+    m_threadPool->setAffinity(m_affinity);
     m_threadPool->run();
-    // 添加检测的任务
-    // 初始化一个channel实例
-    Channel* channel = new Channel(m_lfd, FDEvent::ReadEvent, acceptConnection, nullptr, nullptr, this);
-    m_mainLoop->addTask(channel, ElemType::ADD);
+    if (m_reusePort && m_threadNum > 0)
+    {
+        // 每个子线程监听自己的套接字, 第一个子线程使用已经创建好的 m_lfd
+        for (int i = 0; i < m_threadNum; ++i)
+        {
+            int lfd = i == 0 ? m_lfd : listenSocket();
+            if (lfd == -1)
+            {
+                continue;
+            }
+            EventLoop* evLoop = m_threadPool->getWorkerEventLoop(i);
+            auto obj = [this, lfd, evLoop](void*) {
+                int cfd = accept(lfd, NULL, NULL);
+                if (cfd == -1)
+                {
+                    perror("accept");
+                    return -1;
+                }
+                newConnection(cfd, evLoop);
+                return 0;
+            };
+            Channel* channel = new Channel(lfd, FDEvent::ReadEvent, obj, nullptr, nullptr, this);
+            evLoop->addTask(channel, ElemType::ADD);
+        }
+    }
+    else
+    {
+        // 添加检测的任务
+        // 初始化一个channel实例
+        Channel* channel = new Channel(m_lfd, FDEvent::ReadEvent, acceptConnection, nullptr, nullptr, this);
+        m_mainLoop->addTask(channel, ElemType::ADD);
+    }
+    // 连接迁移需要知道每个子线程的负载
+    if (m_statsInterval > 0 || m_migration)
+    {
+        m_mainLoop->addTimer(m_statsInterval > 0 ? m_statsInterval : m_loadInterval,
+            bind(&TcpServer::updateStats, this));
+    }
     // 启动反应堆模型
     m_mainLoop->run();
 }
+
+void TcpServer::updateStats()
+{
+    int interval = m_statsInterval > 0 ? m_statsInterval : m_loadInterval;
+    m_threadPool->updateStats(interval, m_statsInterval > 0);
+    m_mainLoop->addTimer(interval, bind(&TcpServer::updateStats, this));
+}
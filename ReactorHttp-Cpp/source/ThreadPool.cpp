@@ -1,11 +1,20 @@
 #include "ThreadPool.h"
 #include <assert.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <sched.h>
+
+// 源子线程每秒处理的事件数不少于这个值, 并且是目标子线程的 kMigrationRatio 倍以上才迁移连接
+static const uint64_t kMinMigrationRate = 1000;
+static const uint64_t kMigrationRatio = 2;
+// 每个子线程在一个统计周期中最多迁移出去的连接数, 避免连接来回迁移
+static const int kMaxMigrations = 4;
 
 ThreadPool::ThreadPool(EventLoop* mainLoop, int count)
 {
     m_index = 0;
     m_isStart = false;
+    m_affinity = false;
     m_mainLoop = mainLoop;
     m_threadNum = count;
     m_workerThreads.clear();
@@ -27,12 +36,25 @@ void ThreadPool::run()
         exit(0);
     }
     m_isStart = true;
+    // 进程可以使用的 CPU
+    vector<int> cpus;
+    cpu_set_t cpuset;
+    if (m_affinity && sched_getaffinity(0, sizeof(cpuset), &cpuset) == 0)
+    {
+        for (int i = 0; i < CPU_SETSIZE; ++i)
+        {
+            if (CPU_ISSET(i, &cpuset))
+            {
+                cpus.push_back(i);
+            }
+        }
+    }
     if (m_threadNum > 0)
     {
         for (int i = 0; i < m_threadNum; ++i)
         {
             WorkerThread* subThread = new WorkerThread(i);
-            subThread->run();
+            subThread->run(cpus.empty() ? -1 : cpus[i % cpus.size()]);
             m_workerThreads.push_back(subThread);
         }
     }
@@ -46,11 +68,67 @@ EventLoop* ThreadPool::takeWorkerEventLoop()
         exit(0);
     }
     // 从线程池中找一个子线程, 然后取出里边的反应堆实例
+    // 长连接的存活时间不一样, 严格轮流分配会让一些子线程积压很多连接, 优先选择连接数最少的
     EventLoop* evLoop = m_mainLoop;
     if (m_threadNum > 0)
     {
-        evLoop = m_workerThreads[m_index]->getEventLoop();
-        m_index = ++m_index % m_threadNum;
+        int best = m_index;
+        for (int i = 1; i < m_threadNum; ++i)
+        {
+            int index = (m_index + i) % m_threadNum;
+            if (m_workerThreads[index]->getEventLoop()->connectionCount()
+                < m_workerThreads[best]->getEventLoop()->connectionCount())
+            {
+                best = index;
+            }
+        }
+        evLoop = m_workerThreads[best]->getEventLoop();
+        m_index = (m_index + 1) % m_threadNum;
     }
     return evLoop;
 }
+
+void ThreadPool::updateStats(int interval, bool print)
+{
+    for (auto item : m_workerThreads)
+    {
+        item->updateEventRate(interval);
+        if (print)
+        {
+            printf("[stats] %s cpu %d connections %d events/s %lu\n", item->getName().data(),
+                item->getCpu(), item->getEventLoop()->connectionCount(), (unsigned long)item->eventRate());
+        }
+    }
+    if (print)
+    {
+        fflush(stdout);
+    }
+}
+
+EventLoop* ThreadPool::takeMigrationTarget(EventLoop* from)
+{
+    WorkerThread* source = nullptr;
+    WorkerThread* target = nullptr;
+    for (auto item : m_workerThreads)
+    {
+        if (item->getEventLoop() == from)
+        {
+            source = item;
+        }
+        else if (target == nullptr || item->eventRate() < target->eventRate())
+        {
+            target = item;
+        }
+    }
+    if (source == nullptr || target == nullptr)
+    {
+        return nullptr;
+    }
+    uint64_t rate = source->eventRate();
+    if (rate < kMinMigrationRate || rate < target->eventRate() * kMigrationRatio
+        || !source->takeMigration(kMaxMigrations))
+    {
+        return nullptr;
+    }
+    return target->getEventLoop();
+}
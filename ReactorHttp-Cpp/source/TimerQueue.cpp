@@ -0,0 +1,92 @@
+#include "TimerQueue.h"
+#include <algorithm>
+#include <time.h>
+
+TimerQueue::TimerQueue()
+{
+    m_nextId = 1;
+}
+
+TimerQueue::~TimerQueue()
+{
+}
+
+bool TimerQueue::later(const TimerNode& a, const TimerNode& b)
+{
+    if (a.expire != b.expire)
+    {
+        return a.expire > b.expire;
+    }
+    return a.id > b.id;
+}
+
+uint64_t TimerQueue::addTimer(int delay, TimerCallback callback)
+{
+    lock_guard<mutex> locker(m_mutex);
+    uint64_t id = m_nextId++;
+    m_heap.push_back(TimerNode{ nowMs() + max(delay, 0), id });
+    push_heap(m_heap.begin(), m_heap.end(), later);
+    m_callbacks.insert(make_pair(id, std::move(callback)));
+    return id;
+}
+
+void TimerQueue::cancel(uint64_t timerId)
+{
+    lock_guard<mutex> locker(m_mutex);
+    m_callbacks.erase(timerId);
+}
+
+int TimerQueue::nextTimeout(int maxTimeout)
+{
+    lock_guard<mutex> locker(m_mutex);
+    // 堆顶是已经取消的定时器, 直接丢弃
+    while (!m_heap.empty() && m_callbacks.find(m_heap.front().id) == m_callbacks.end())
+    {
+        pop_heap(m_heap.begin(), m_heap.end(), later);
+        m_heap.pop_back();
+    }
+    if (m_heap.empty())
+    {
+        return maxTimeout;
+    }
+    int64_t timeout = m_heap.front().expire - nowMs();
+    if (timeout < 0)
+    {
+        return 0;
+    }
+    return timeout < maxTimeout ? static_cast<int>(timeout) : maxTimeout;
+}
+
+int TimerQueue::processExpired()
+{
+    // 先取出所有到期的回调再执行, 回调中可以添加或者取消定时器
+    vector<TimerCallback> expired;
+    m_mutex.lock();
+    int64_t now = nowMs();
+    while (!m_heap.empty() && m_heap.front().expire <= now)
+    {
+        uint64_t id = m_heap.front().id;
+        pop_heap(m_heap.begin(), m_heap.end(), later);
+        m_heap.pop_back();
+        auto it = m_callbacks.find(id);
+        if (it != m_callbacks.end())
+        {
+            expired.push_back(std::move(it->second));
+            m_callbacks.erase(it);
+        }
+    }
+    m_mutex.unlock();
+
+    for (auto& callback : expired)
+    {
+        callback();
+    }
+    return static_cast<int>(expired.size());
+}
+
+int64_t TimerQueue::nowMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
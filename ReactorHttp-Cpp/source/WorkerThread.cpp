@@ -1,9 +1,23 @@
 #include "WorkerThread.h"
 #include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
 
 // 子线程的回调函数
 void WorkerThread::running()
 {
+    if (m_cpu >= 0)
+    {
+        // 先绑定 CPU 再创建反应堆, 反应堆的内存分配在这个 CPU 所在的 NUMA 节点上
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(m_cpu, &cpuset);
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+        if (ret != 0)
+        {
+            printf("%s: 绑定 CPU %d 失败: %d\n", m_name.data(), m_cpu, ret);
+        }
+    }
     m_mutex.lock();
     m_evLoop = new EventLoop(m_name);
     m_mutex.unlock();
@@ -17,6 +31,10 @@ WorkerThread::WorkerThread(int index)
     m_thread = nullptr;
     m_threadID = thread::id();
     m_name =  "SubThread-" + to_string(index);
+    m_cpu = -1;
+    m_lastEvents = 0;
+    m_eventRate = 0;
+    m_migrations = 0;
 }
 
 WorkerThread::~WorkerThread()
@@ -27,8 +45,9 @@ WorkerThread::~WorkerThread()
     }
 }
 
-void WorkerThread::run()
+void WorkerThread::run(int cpu)
 {
+    m_cpu = cpu;
     // 创建子线程
     m_thread = new thread(&WorkerThread::running, this);
     // 阻塞主线程, 让当前函数不会直接结束
@@ -38,3 +57,11 @@ void WorkerThread::run()
         m_cond.wait(locker);
     }
 }
+
+void WorkerThread::updateEventRate(int interval)
+{
+    uint64_t events = m_evLoop->eventCount();
+    m_eventRate.store((events - m_lastEvents) * 1000 / interval, memory_order_relaxed);
+    m_lastEvents = events;
+    m_migrations.store(0, memory_order_relaxed);
+}
@@ -5,21 +5,64 @@
 
 int main(int argc, char* argv[])
 {
+    // 启动参数
+    // -d: 反应堆使用的 IO 多路复用模型 epoll(默认), poll, select, uring
+    // -r: SO_REUSEPORT, 每个子线程自己 accept   -a: 子线程绑定 CPU
+    // -m: 繁忙的子线程把长连接迁移到空闲的子线程   -s: 每隔多少秒输出一次子线程的统计信息
+    const char* usage = "./a.out [-d epoll|poll|select|uring] [-r] [-a] [-m] [-s seconds] port path\n";
+    bool reusePort = false;
+    bool affinity = false;
+    bool migration = false;
+    int statsInterval = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:rams:")) != -1)
+    {
+        DispatcherType type;
+        if (opt == 'd' && EventLoop::parseDispatcherType(optarg, type))
+        {
+            EventLoop::setDefaultDispatcher(type);
+        }
+        else if (opt == 'r')
+        {
+            reusePort = true;
+        }
+        else if (opt == 'a')
+        {
+            affinity = true;
+        }
+        else if (opt == 'm')
+        {
+            migration = true;
+        }
+        else if (opt == 's' && atoi(optarg) > 0)
+        {
+            statsInterval = atoi(optarg) * 1000;
+        }
+        else
+        {
+            printf("%s", usage);
+            return -1;
+        }
+    }
 #if 0
-    if (argc < 3)
+    if (argc - optind < 2)
     {
-        printf("./a.out port path\n");
+        printf("%s", usage);
         return -1;
     }
-    unsigned short port = atoi(argv[1]);
+    unsigned short port = atoi(argv[optind]);
     // 切换服务器的工作路径
-    chdir(argv[2]);
+    chdir(argv[optind + 1]);
 #else
     unsigned short port = 10000;
     chdir("/home/kolane/");
 #endif
     // 启动服务器
     TcpServer* server = new TcpServer(port, 4);
+    server->setReusePort(reusePort);
+    server->setAffinity(affinity);
+    server->setMigration(migration);
+    server->setStatsInterval(statsInterval);
     server->run();
 
     return 0;
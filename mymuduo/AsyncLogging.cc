@@ -0,0 +1,299 @@
+#include "AsyncLogging.h"
+#include "LogFile.h"
+#include "Logger.h"
+#include "Timestamp.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+namespace
+{
+
+// 待写的缓冲区超过这个数量(64M)说明后台写不过来了，只保留最早的两块，其余丢弃
+const size_t kMaxPendingBuffers = 1024;
+// 后台回收复用的空闲缓冲区数量上限
+const size_t kMaxEmptyBuffers = 16;
+
+std::atomic<uint64_t> g_nextId(1);
+
+} // namespace
+
+struct AsyncLogging::LogBuffer
+{
+    LogBuffer() : len(0) {}
+
+    size_t avail() const { return sizeof data - len; }
+    void append(const char *buf, size_t n)
+    {
+        ::memcpy(data + len, buf, n);
+        len += n;
+    }
+
+    char data[kBufferSize];
+    size_t len;
+};
+
+// 一个线程的前端缓冲区  mutex只在这个线程写日志和后台线程收集时竞争
+struct AsyncLogging::ThreadBuffer
+{
+    explicit ThreadBuffer(uint64_t ownerId)
+        : owner(ownerId)
+        , current(new LogBuffer)
+        , exited(false)
+    {}
+
+    const uint64_t owner;
+    std::mutex mutex;
+    BufferPtr current;
+    bool exited; // 线程已经退出，后台收集完剩余的日志之后注销
+};
+
+namespace
+{
+
+/**
+ * 线程局部的ThreadBuffer引用  线程退出时标记exited，
+ * ThreadBuffer由shared_ptr管理，AsyncLogging先析构或者线程先退出都是安全的
+ */
+template <typename T>
+struct ThreadBufferHolder
+{
+    ~ThreadBufferHolder()
+    {
+        if (buffer)
+        {
+            std::lock_guard<std::mutex> lock(buffer->mutex);
+            buffer->exited = true;
+        }
+    }
+
+    std::shared_ptr<T> buffer;
+};
+
+} // namespace
+
+AsyncLogging::AsyncLogging(const std::string &basename, off_t rollSize, int flushInterval, int rollInterval)
+    : flushInterval_(flushInterval > 0 ? flushInterval : 3)
+    , basename_(basename)
+    , rollSize_(rollSize)
+    , rollInterval_(rollInterval)
+    , id_(g_nextId.fetch_add(1))
+    , running_(false)
+    , thread_(std::bind(&AsyncLogging::threadFunc, this), "AsyncLogging")
+    , flushRequested_(0)
+    , flushCompleted_(0)
+    , dropped_(0)
+{
+}
+
+AsyncLogging::~AsyncLogging()
+{
+    stop();
+}
+
+void AsyncLogging::start()
+{
+    running_ = true;
+    thread_.start();
+
+    Logger &logger = Logger::instance();
+    logger.setOutput(std::bind(&AsyncLogging::append, this, std::placeholders::_1, std::placeholders::_2));
+    logger.setFlush(std::bind(&AsyncLogging::flush, this));
+}
+
+void AsyncLogging::stop()
+{
+    if (!running_)
+    {
+        return;
+    }
+
+    Logger &logger = Logger::instance();
+    logger.setOutput(nullptr);
+    logger.setFlush(nullptr);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cond_.notify_one();
+    thread_.join();
+}
+
+AsyncLogging::ThreadBuffer* AsyncLogging::threadBuffer()
+{
+    static thread_local ThreadBufferHolder<ThreadBuffer> t_holder;
+    if (!t_holder.buffer || t_holder.buffer->owner != id_)
+    {
+        ThreadBufferPtr tb = std::make_shared<ThreadBuffer>(id_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            threadBuffers_.push_back(tb);
+        }
+        if (t_holder.buffer)
+        {
+            // 之前注册在另一个AsyncLogging上，那边会把它当作已经退出的线程处理
+            std::lock_guard<std::mutex> lock(t_holder.buffer->mutex);
+            t_holder.buffer->exited = true;
+        }
+        t_holder.buffer = tb;
+    }
+    return t_holder.buffer.get();
+}
+
+void AsyncLogging::append(const char *logline, size_t len)
+{
+    ThreadBuffer *tb = threadBuffer();
+    std::lock_guard<std::mutex> lock(tb->mutex);
+    if (tb->current->avail() < len)
+    {
+        tb->current = submitFull(std::move(tb->current));
+    }
+    if (tb->current->avail() >= len)
+    {
+        tb->current->append(logline, len);
+    }
+}
+
+AsyncLogging::BufferPtr AsyncLogging::submitFull(BufferPtr full)
+{
+    BufferPtr next;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        full_.push_back(std::move(full));
+        if (!empty_.empty())
+        {
+            next = std::move(empty_.back());
+            empty_.pop_back();
+        }
+    }
+    cond_.notify_one();
+    if (!next)
+    {
+        next.reset(new LogBuffer);
+    }
+    return next;
+}
+
+void AsyncLogging::flush()
+{
+    if (!running_)
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t seq = ++flushRequested_;
+    cond_.notify_one();
+    // 后台线程出问题的时候不能让调用者(比如LOG_FATAL)一直卡住
+    flushCond_.wait_for(lock, std::chrono::seconds(3), [this, seq] { return flushCompleted_ >= seq; });
+}
+
+// 加锁顺序和前端一致：先ThreadBuffer::mutex再mutex_
+void AsyncLogging::collectThreadBuffers()
+{
+    std::vector<ThreadBufferPtr> buffers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffers = threadBuffers_;
+    }
+
+    std::vector<ThreadBuffer*> exited;
+    for (const ThreadBufferPtr &tb : buffers)
+    {
+        std::lock_guard<std::mutex> lock(tb->mutex);
+        if (tb->current->len > 0)
+        {
+            tb->current = submitFull(std::move(tb->current));
+        }
+        if (tb->exited)
+        {
+            exited.push_back(tb.get());
+        }
+    }
+
+    // 已经退出的线程不会再写日志，上面收集过之后就可以注销了
+    if (!exited.empty())
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (ThreadBuffer *tb : exited)
+        {
+            for (auto it = threadBuffers_.begin(); it != threadBuffers_.end(); ++it)
+            {
+                if (it->get() == tb)
+                {
+                    threadBuffers_.erase(it);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void AsyncLogging::threadFunc()
+{
+    LogFile output(basename_, rollSize_, rollInterval_);
+    std::vector<BufferPtr> buffersToWrite;
+
+    for (;;)
+    {
+        uint64_t flushSeq;
+        bool running;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (full_.empty() && flushRequested_ == flushCompleted_ && running_)
+            {
+                cond_.wait_for(lock, std::chrono::seconds(flushInterval_));
+            }
+            flushSeq = flushRequested_;
+            running = running_;
+        }
+
+        // 记下flush序号之后再收集，保证flush()调用之前写入的日志都在这一轮里面
+        collectThreadBuffers();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffersToWrite.swap(full_);
+        }
+
+        if (buffersToWrite.size() > kMaxPendingBuffers)
+        {
+            char buf[256];
+            int n = snprintf(buf, sizeof buf, "Dropped log messages at %s, %zu larger buffers\n",
+                             Timestamp::now().toString().c_str(),
+                             buffersToWrite.size() - 2);
+            ::fputs(buf, stderr);
+            output.append(buf, n);
+            dropped_.fetch_add(buffersToWrite.size() - 2, std::memory_order_relaxed);
+            buffersToWrite.resize(2);
+        }
+
+        for (const BufferPtr &buffer : buffersToWrite)
+        {
+            output.append(buffer->data, buffer->len);
+        }
+        output.flush();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (BufferPtr &buffer : buffersToWrite)
+            {
+                if (empty_.size() >= kMaxEmptyBuffers)
+                {
+                    break;
+                }
+                buffer->len = 0;
+                empty_.push_back(std::move(buffer));
+            }
+            flushCompleted_ = flushSeq;
+        }
+        buffersToWrite.clear();
+        flushCond_.notify_all();
+
+        if (!running)
+        {
+            break;
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Thread.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <stdint.h>
+#include <sys/types.h>
+
+/**
+ * 异步日志  前端写日志的线程只把格式化好的日志拷贝到自己线程的缓冲区里面，
+ * 后台线程定期(或者有缓冲区写满时)把所有缓冲区收集起来写到滚动的日志文件中
+ *
+ * 前端：每个线程一块kBufferSize大小的当前缓冲区，写日志只和后台线程偶尔竞争这个线程自己的锁；
+ *      缓冲区写满了才加全局锁，把它放进待写队列并换一块空的
+ * 后台：待写队列和后台自己的队列交换(双缓冲)，在锁外写文件，写完的缓冲区回收复用
+ *
+ * 用法：
+ *   AsyncLogging log("/tmp/server", 64 * 1024 * 1024);
+ *   log.start();  // 之后的LOG_XXX都写到文件中
+ * AsyncLogging对象需要比所有写日志的线程活得更久，一般定义在main函数里面
+ */
+class AsyncLogging : noncopyable
+{
+public:
+    static const size_t kBufferSize = 64 * 1024;
+
+    // rollSize: 单个日志文件的最大字节数  flushInterval: 后台刷新间隔，单位秒  rollInterval: 按时间滚动的周期，单位秒
+    AsyncLogging(const std::string &basename, off_t rollSize, int flushInterval = 3,
+                 int rollInterval = 24 * 60 * 60);
+    ~AsyncLogging();
+
+    // 启动后台线程，并把Logger的输出接管过来
+    void start();
+    // 把剩余的日志写完，停止后台线程，Logger恢复输出到stdout
+    void stop();
+
+    // 前端写一条日志，可以在任意线程调用
+    void append(const char *logline, size_t len);
+    // 把调用之前写入的日志同步写到文件中，LOG_FATAL退出之前会调用
+    void flush();
+
+    // 因为后台写不过来而丢弃的缓冲区个数
+    uint64_t droppedBuffers() const { return dropped_.load(std::memory_order_relaxed); }
+private:
+    struct LogBuffer;
+    struct ThreadBuffer;
+    using BufferPtr = std::unique_ptr<LogBuffer>;
+    using ThreadBufferPtr = std::shared_ptr<ThreadBuffer>;
+
+    // 当前线程在这个AsyncLogging上的前端缓冲区，第一次调用时注册
+    ThreadBuffer* threadBuffer();
+    // 把写满的缓冲区放进待写队列，返回一块空的缓冲区，调用者持有tb->mutex
+    BufferPtr submitFull(BufferPtr full);
+    // 把所有线程缓冲区里面没写满的日志也收集到待写队列中
+    void collectThreadBuffers();
+    void threadFunc();
+
+    const int flushInterval_;
+    const std::string basename_;
+    const off_t rollSize_;
+    const int rollInterval_;
+    const uint64_t id_; // 区分不同的AsyncLogging对象，线程局部的缓冲区按它匹配
+
+    std::atomic_bool running_;
+    Thread thread_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;      // 通知后台线程有缓冲区要写或者有flush请求
+    std::condition_variable flushCond_; // 通知flush()的调用者已经写完
+    std::vector<BufferPtr> full_;       // 前端写满等待后台写入的缓冲区
+    std::vector<BufferPtr> empty_;      // 后台写完回收的缓冲区
+    std::vector<ThreadBufferPtr> threadBuffers_;
+    uint64_t flushRequested_;
+    uint64_t flushCompleted_;
+
+    std::atomic<uint64_t> dropped_;
+};
@@ -3,24 +3,119 @@
 #include <errno.h>
 #include <sys/uio.h>
 #include <unistd.h>
+#include <string.h>
+
+namespace
+{
+
+// 每次readFd最多一次性准备的新块数量  4 * 16K = 64K，和连续模式的extrabuf大小一致
+const int kReadChunks = 4;
+// writeFd一次writev最多携带的块数量
+const int kMaxWriteIov = 64;
+// 每个线程的内存池最多缓存的空闲块数量，超过的直接释放
+const size_t kMaxPooledChunks = 256;
+
+// 线程退出时池已经析构，之后再析构的Buffer直接new/delete
+thread_local bool t_chunkPoolDestroyed = false;
+
+/**
+ * 线程局部的定长内存块池  TcpConnection的缓冲区都在所属的subloop线程里面读写，
+ * 所以这里不需要加锁；在其它线程析构的Buffer会把块还给那个线程的池
+ */
+class ChunkPool
+{
+public:
+    ~ChunkPool()
+    {
+        for (char *block : free_)
+        {
+            delete[] block;
+        }
+        t_chunkPoolDestroyed = true;
+    }
+
+    char* get()
+    {
+        if (t_chunkPoolDestroyed || free_.empty())
+        {
+            return new char[Buffer::kChunkSize];
+        }
+        char *block = free_.back();
+        free_.pop_back();
+        return block;
+    }
+
+    void put(char *block)
+    {
+        if (!t_chunkPoolDestroyed && free_.size() < kMaxPooledChunks)
+        {
+            free_.push_back(block);
+        }
+        else
+        {
+            delete[] block;
+        }
+    }
+private:
+    std::vector<char*> free_;
+};
+
+thread_local ChunkPool t_chunkPool;
+
+BufferChunk newChunk()
+{
+    BufferChunk chunk;
+    chunk.data = t_chunkPool.get();
+    chunk.capacity = Buffer::kChunkSize;
+    chunk.readIndex = 0;
+    chunk.writeIndex = 0;
+    return chunk;
+}
+
+void releaseChunk(const BufferChunk &chunk)
+{
+    if (chunk.capacity == Buffer::kChunkSize)
+    {
+        t_chunkPool.put(chunk.data);
+    }
+    else
+    {
+        delete[] chunk.data; // peek()拼接出来的大块
+    }
+}
+
+} // namespace
+
+Buffer::~Buffer()
+{
+    for (const BufferChunk &chunk : chunks_)
+    {
+        releaseChunk(chunk);
+    }
+}
 
 /**
  * 从fd上读取数据  Poller工作在LT模式
  * Buffer缓冲区是有大小的！ 但是从fd上读数据的时候，却不知道tcp数据最终的大小
- */ 
+ */
 ssize_t Buffer::readFd(int fd, int* saveErrno)
 {
+    if (chained_)
+    {
+        return chainReadFd(fd, saveErrno);
+    }
+
     char extrabuf[65536] = {0}; // 栈上的内存空间  64K
-    
+
     struct iovec vec[2];
-    
+
     const size_t writable = writableBytes(); // 这是Buffer底层缓冲区剩余的可写空间大小
     vec[0].iov_base = begin() + writerIndex_;
     vec[0].iov_len = writable;
 
     vec[1].iov_base = extrabuf;
     vec[1].iov_len = sizeof extrabuf;
-    
+
     const int iovcnt = (writable < sizeof extrabuf) ? 2 : 1;
     const ssize_t n = ::readv(fd, vec, iovcnt);
     if (n < 0)
@@ -31,7 +126,7 @@ ssize_t Buffer::readFd(int fd, int* saveErrno)
     {
         writerIndex_ += n;
     }
-    else // extrabuf里面也写入了数据 
+    else // extrabuf里面也写入了数据
     {
         writerIndex_ = buffer_.size();
         append(extrabuf, n - writable);  // writerIndex_开始写 n - writable大小的数据
@@ -40,12 +135,212 @@ ssize_t Buffer::readFd(int fd, int* saveErrno)
     return n;
 }
 
-ssize_t Buffer::writeFd(int fd, int* saveErrno)
+ssize_t Buffer::writeFd(int fd, int* saveErrno, size_t maxBytes)
+{
+    if (chained_)
+    {
+        return chainWriteFd(fd, saveErrno, maxBytes);
+    }
+
+    ssize_t n = ::write(fd, peek(), std::min(readableBytes(), maxBytes));
+    if (n < 0)
+    {
+        *saveErrno = errno;
+    }
+    return n;
+}
+
+// 第一块不够len字节时，把后面的块挪到第一块里面，只挪到够len字节为止
+// 第一块放不下就换成容量翻倍的大块，数据一点点到达、反复peek时拷贝的总量仍然是线性的
+const char* Buffer::chainPeek(size_t len) const
+{
+    if (chunks_.empty())
+    {
+        static const char kEmpty[1] = {0};
+        return kEmpty;
+    }
+
+    len = std::min(len, chainReadable_);
+    BufferChunk &front = chunks_.front();
+    if (front.readableBytes() >= len)
+    {
+        return front.data + front.readIndex;
+    }
+
+    if (front.capacity - front.readIndex < len)
+    {
+        BufferChunk merged;
+        merged.capacity = std::max(len, 2 * front.capacity); // 一定大于kChunkSize，释放时不会进内存池
+        merged.data = new char[merged.capacity];
+        merged.readIndex = 0;
+        merged.writeIndex = front.readableBytes();
+        ::memcpy(merged.data, front.data + front.readIndex, front.readableBytes());
+        releaseChunk(front);
+        front = merged;
+    }
+
+    // 从deque中间erase会让引用失效，每次重新取第一块
+    while (chunks_.front().readableBytes() < len)
+    {
+        BufferChunk &head = chunks_[0];
+        BufferChunk &next = chunks_[1];
+        size_t n = std::min(next.readableBytes(), head.writableBytes());
+        ::memcpy(head.data + head.writeIndex, next.data + next.readIndex, n);
+        head.writeIndex += n;
+        next.readIndex += n;
+        if (next.readableBytes() == 0)
+        {
+            releaseChunk(next);
+            chunks_.erase(chunks_.begin() + 1);
+        }
+    }
+    return chunks_.front().data + chunks_.front().readIndex;
+}
+
+void Buffer::chainRetrieve(size_t len)
+{
+    len = std::min(len, chainReadable_);
+    chainReadable_ -= len;
+    while (len > 0)
+    {
+        BufferChunk &front = chunks_.front();
+        size_t n = std::min(len, front.readableBytes());
+        front.readIndex += n;
+        len -= n;
+        if (front.readableBytes() > 0)
+        {
+            continue;
+        }
+        // 读空的块释放掉；如果它是最后一块并且是普通块，就复位下标留给后续写入，省得马上又从池里取
+        if (chunks_.size() == 1 && front.capacity == kChunkSize)
+        {
+            front.readIndex = front.writeIndex = 0;
+        }
+        else
+        {
+            releaseChunk(front);
+            chunks_.pop_front();
+        }
+    }
+}
+
+std::string Buffer::chainRetrieveAsString(size_t len)
+{
+    len = std::min(len, chainReadable_);
+    std::string result;
+    result.reserve(len);
+    size_t left = len;
+    for (const BufferChunk &chunk : chunks_)
+    {
+        if (left == 0)
+        {
+            break;
+        }
+        size_t n = std::min(left, chunk.readableBytes());
+        result.append(chunk.data + chunk.readIndex, n);
+        left -= n;
+    }
+    chainRetrieve(len);
+    return result;
+}
+
+void Buffer::chainAppend(const char *data, size_t len)
+{
+    chainReadable_ += len;
+    while (len > 0)
+    {
+        if (chunks_.empty() || chunks_.back().writableBytes() == 0)
+        {
+            chunks_.push_back(newChunk());
+        }
+        BufferChunk &back = chunks_.back();
+        size_t n = std::min(len, back.writableBytes());
+        ::memcpy(back.data + back.writeIndex, data, n);
+        back.writeIndex += n;
+        data += n;
+        len -= n;
+    }
+}
+
+// 直接读到块里面：最后一块剩余的空间 + 预先准备的kReadChunks个新块，没用上的新块还给内存池
+ssize_t Buffer::chainReadFd(int fd, int* saveErrno)
+{
+    struct iovec vec[kReadChunks + 1];
+    BufferChunk spare[kReadChunks];
+    int iovcnt = 0;
+
+    size_t tailWritable = 0;
+    if (!chunks_.empty() && chunks_.back().writableBytes() > 0)
+    {
+        BufferChunk &back = chunks_.back();
+        tailWritable = back.writableBytes();
+        vec[iovcnt].iov_base = back.data + back.writeIndex;
+        vec[iovcnt].iov_len = tailWritable;
+        ++iovcnt;
+    }
+    for (int i = 0; i < kReadChunks; ++i)
+    {
+        spare[i] = newChunk();
+        vec[iovcnt].iov_base = spare[i].data;
+        vec[iovcnt].iov_len = spare[i].capacity;
+        ++iovcnt;
+    }
+
+    const ssize_t n = ::readv(fd, vec, iovcnt);
+    if (n < 0)
+    {
+        *saveErrno = errno;
+    }
+
+    size_t left = n > 0 ? static_cast<size_t>(n) : 0;
+    chainReadable_ += left;
+    if (tailWritable > 0)
+    {
+        size_t used = std::min(left, tailWritable);
+        chunks_.back().writeIndex += used;
+        left -= used;
+    }
+    for (int i = 0; i < kReadChunks; ++i)
+    {
+        if (left > 0)
+        {
+            spare[i].writeIndex = std::min(left, spare[i].capacity);
+            left -= spare[i].writeIndex;
+            chunks_.push_back(spare[i]);
+        }
+        else
+        {
+            releaseChunk(spare[i]);
+        }
+    }
+    return n;
+}
+
+// 所有块通过一次writev发送出去，发送成功的部分由调用者retrieve
+ssize_t Buffer::chainWriteFd(int fd, int* saveErrno, size_t maxBytes)
 {
-    ssize_t n = ::write(fd, peek(), readableBytes());
+    struct iovec vec[kMaxWriteIov];
+    int iovcnt = 0;
+    for (const BufferChunk &chunk : chunks_)
+    {
+        if (iovcnt == kMaxWriteIov || maxBytes == 0)
+        {
+            break;
+        }
+        if (chunk.readableBytes() > 0)
+        {
+            size_t n = std::min(chunk.readableBytes(), maxBytes);
+            vec[iovcnt].iov_base = chunk.data + chunk.readIndex;
+            vec[iovcnt].iov_len = n;
+            maxBytes -= n;
+            ++iovcnt;
+        }
+    }
+
+    ssize_t n = ::writev(fd, vec, iovcnt);
     if (n < 0)
     {
         *saveErrno = errno;
     }
     return n;
-}
\ No newline at end of file
+}
@@ -1,27 +1,73 @@
 #pragma once
 
+#include "noncopyable.h"
+
 #include <vector>
+#include <deque>
 #include <string>
 #include <algorithm>
+#include <sys/types.h>
+
+/**
+ * 链式缓冲区中的一块内存  普通块大小固定为kChunkSize，从线程局部的内存池中分配
+ * 调用peek()需要把数据拼接成连续内存时，第一块放不下就换成一个更大的块，这种块不进内存池
+ */
+struct BufferChunk
+{
+    char *data;
+    size_t capacity;
+    size_t readIndex;
+    size_t writeIndex;
+
+    size_t readableBytes() const { return writeIndex - readIndex; }
+    size_t writableBytes() const { return capacity - writeIndex; }
+};
 
 // 网络库底层的缓冲器类型定义
-class Buffer
+class Buffer : noncopyable
 {
 public:
     static const size_t kCheapPrepend = 8;
     static const size_t kInitialSize = 1024;
+    static const size_t kChunkSize = 16 * 1024;
+
+    /**
+     * kContiguous: 一整块std::vector<char>，空间不够时resize或者挪动数据
+     * kChained: 由固定大小的内存块串成的链表，append和readFd不会挪动已有数据，
+     *           writeFd通过一次writev把所有块发送出去，适合作为发送缓冲区和接收大数据
+     */
+    enum Mode
+    {
+        kContiguous,
+        kChained,
+    };
 
     explicit Buffer(size_t initialSize = kInitialSize)
-        : buffer_(kCheapPrepend + initialSize)
+        : chained_(false)
+        , buffer_(kCheapPrepend + initialSize)
+        , readerIndex_(kCheapPrepend)
+        , writerIndex_(kCheapPrepend)
+        , chainReadable_(0)
+    {}
+
+    explicit Buffer(Mode mode)
+        : chained_(mode == kChained)
+        , buffer_(chained_ ? 0 : kCheapPrepend + kInitialSize)
         , readerIndex_(kCheapPrepend)
         , writerIndex_(kCheapPrepend)
+        , chainReadable_(0)
     {}
 
-    size_t readableBytes() const 
+    ~Buffer();
+
+    bool chained() const { return chained_; }
+
+    size_t readableBytes() const
     {
-        return writerIndex_ - readerIndex_;
+        return chained_ ? chainReadable_ : writerIndex_ - readerIndex_;
     }
 
+    // 以下三个接口只对kContiguous模式有意义
     size_t writableBytes() const
     {
         return buffer_.size() - writerIndex_;
@@ -32,16 +78,26 @@ public:
         return readerIndex_;
     }
 
-    // 返回缓冲区中可读数据的起始地址
+    // 返回缓冲区中可读数据的起始地址  kChained模式下数据跨越多个块时会先拼接成连续内存
     const char* peek() const
     {
-        return begin() + readerIndex_;
+        return chained_ ? chainPeek(chainReadable_) : begin() + readerIndex_;
+    }
+
+    // 同peek()，但只保证从返回的地址开始有min(len, readableBytes())字节是连续的
+    const char* peek(size_t len) const
+    {
+        return chained_ ? chainPeek(len) : begin() + readerIndex_;
     }
 
     // onMessage string <- Buffer
     void retrieve(size_t len)
     {
-        if (len < readableBytes())
+        if (chained_)
+        {
+            chainRetrieve(len);
+        }
+        else if (len < readableBytes())
         {
             readerIndex_ += len; // 应用只读取了刻度缓冲区数据的一部分，就是len，还剩下readerIndex_ += len -> writerIndex_
         }
@@ -53,7 +109,14 @@ public:
 
     void retrieveAll()
     {
-        readerIndex_ = writerIndex_ = kCheapPrepend;
+        if (chained_)
+        {
+            chainRetrieve(chainReadable_);
+        }
+        else
+        {
+            readerIndex_ = writerIndex_ = kCheapPrepend;
+        }
     }
 
     // 把onMessage函数上报的Buffer数据，转成string类型的数据返回
@@ -64,6 +127,10 @@ public:
 
     std::string retrieveAsString(size_t len)
     {
+        if (chained_)
+        {
+            return chainRetrieveAsString(len);
+        }
         std::string result(peek(), len);
         retrieve(len); // 上面一句把缓冲区中可读的数据，已经读取出来，这里肯定要对缓冲区进行复位操作
         return result;
@@ -81,6 +148,11 @@ public:
     // 把[data, data+len]内存上的数据，添加到writable缓冲区当中
     void append(const char *data, size_t len)
     {
+        if (chained_)
+        {
+            chainAppend(data, len);
+            return;
+        }
         ensureWriteableBytes(len);
         std::copy(data, data+len, beginWrite());
         writerIndex_ += len;
@@ -98,8 +170,8 @@ public:
 
     // 从fd上读取数据
     ssize_t readFd(int fd, int* saveErrno);
-    // 通过fd发送数据
-    ssize_t writeFd(int fd, int* saveErrno);
+    // 通过fd发送数据，最多发送maxBytes字节
+    ssize_t writeFd(int fd, int* saveErrno, size_t maxBytes = static_cast<size_t>(-1));
 private:
     char* begin()
     {
@@ -119,7 +191,7 @@ private:
         else
         {
             size_t readalbe = readableBytes();
-            std::copy(begin() + readerIndex_, 
+            std::copy(begin() + readerIndex_,
                     begin() + writerIndex_,
                     begin() + kCheapPrepend);
             readerIndex_ = kCheapPrepend;
@@ -127,7 +199,21 @@ private:
         }
     }
 
+    // kChained模式的实现
+    const char* chainPeek(size_t len) const;
+    void chainRetrieve(size_t len);
+    std::string chainRetrieveAsString(size_t len);
+    void chainAppend(const char *data, size_t len);
+    ssize_t chainReadFd(int fd, int* saveErrno);
+    ssize_t chainWriteFd(int fd, int* saveErrno, size_t maxBytes);
+
+    const bool chained_;
+
     std::vector<char> buffer_;
     size_t readerIndex_;
     size_t writerIndex_;
-};
\ No newline at end of file
+
+    // peek()是const接口，拼接连续内存时需要修改块链表
+    mutable std::deque<BufferChunk> chunks_;
+    size_t chainReadable_;
+};
@@ -2,16 +2,21 @@
 
 #include <memory>
 #include <functional>
+#include <stdint.h>
 
 class Buffer;
 class TcpConnection;
 class Timestamp;
 
 using TcpConnectionPtr = std::shared_ptr<TcpConnection>;
+using ConnectionId = uint64_t;
 using ConnectionCallback = std::function<void (const TcpConnectionPtr&)>;
 using CloseCallback = std::function<void (const TcpConnectionPtr&)>;
 using WriteCompleteCallback = std::function<void (const TcpConnectionPtr&)>;
 using MessageCallback = std::function<void (const TcpConnectionPtr&,
                                         Buffer*,
                                         Timestamp)>;
-using HighWaterMarkCallback = std::function<void (const TcpConnectionPtr&, size_t)>;
\ No newline at end of file
+using HighWaterMarkCallback = std::function<void (const TcpConnectionPtr&, size_t)>;
+using LowWaterMarkCallback = std::function<void (const TcpConnectionPtr&, size_t)>;
+
+using TimerCallback = std::function<void()>;
\ No newline at end of file
@@ -45,6 +45,10 @@ public:
     void disableWriting() { events_ &= ~kWriteEvent; update(); }
     void disableAll() { events_ = kNoneEvent; update(); }
 
+    // 边沿触发模式  需要在注册到poller之前设置，回调里面要把fd读写到EAGAIN为止
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+    bool edgeTriggered() const { return edgeTriggered_; }
+
     // 返回fd当前的事件状态
     bool isNoneEvent() const { return events_ == kNoneEvent; }
     bool isWriting() const { return events_ & kWriteEvent; }
@@ -70,6 +74,7 @@ private:
     int events_; // 注册fd感兴趣的事件
     int revents_; // poller返回的具体发生的事件
     int index_;
+    bool edgeTriggered_;
 
     std::weak_ptr<void> tie_;
     bool tied_;
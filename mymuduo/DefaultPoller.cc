@@ -1,5 +1,7 @@
 #include "Poller.h"
 #include "EPollPoller.h"
+#include "UringPoller.h"
+#include "Logger.h"
 
 #include <stdlib.h>
 
@@ -9,6 +11,21 @@ Poller* Poller::newDefaultPoller(EventLoop *loop)
     {
         return nullptr; // 生成poll的实例
     }
+    else if (::getenv("MUDUO_USE_URING"))
+    {
+#ifdef MUDUO_HAVE_URING
+        UringPoller *poller = new UringPoller(loop); // 生成io_uring的实例
+        if (poller->valid())
+        {
+            return poller;
+        }
+        delete poller;
+        LOG_ERROR("io_uring is not available, fall back to epoll \n");
+#else
+        LOG_ERROR("mymuduo is built without io_uring, fall back to epoll \n");
+#endif
+        return new EPollPoller(loop);
+    }
     else
     {
         return new EPollPoller(loop); // 生成epoll的实例
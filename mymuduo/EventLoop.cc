@@ -2,6 +2,7 @@
 #include "Logger.h"
 #include "Poller.h"
 #include "Channel.h"
+#include "TimerQueue.h"
 
 #include <sys/eventfd.h>
 #include <unistd.h>
@@ -29,9 +30,12 @@ int createEventfd()
 EventLoop::EventLoop()
     : looping_(false)
     , quit_(false)
+    , iteration_(0)
     , callingPendingFunctors_(false)
+    , wakeupPending_(false)
     , threadId_(CurrentThread::tid())
     , poller_(Poller::newDefaultPoller(this))
+    , timerQueue_(new TimerQueue(this))
     , wakeupFd_(createEventfd())
     , wakeupChannel_(new Channel(this, wakeupFd_))
 {
@@ -71,18 +75,33 @@ void EventLoop::loop()
     {
         activeChannels_.clear();
         // 监听两类fd   一种是client的fd，一种wakeupfd
+        int64_t pollStart = metrics::nowMicros();
         pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+        int64_t pollEnd = metrics::nowMicros();
+        iteration_.store(iteration_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        metrics_.recordPoll(pollEnd - pollStart, activeChannels_.size());
+
+        int64_t callbackStart = pollEnd;
         for (Channel *channel : activeChannels_)
         {
+            // 回调里面channel可能被析构，先取出fd
+            int fd = channel->fd();
             // Poller监听哪些channel发生事件了，然后上报给EventLoop，通知channel处理相应的事件
             channel->handleEvent(pollReturnTime_);
+            int64_t callbackEnd = metrics::nowMicros();
+            metrics_.recordCallback(fd, callbackEnd - callbackStart);
+            callbackStart = callbackEnd;
         }
         // 执行当前EventLoop事件循环需要处理的回调操作
         /**
          * IO线程 mainLoop accept fd《=channel subloop
          * mainLoop 事先注册一个回调cb（需要subloop来执行）    wakeup subloop后，执行下面的方法，执行之前mainloop注册的cb操作
          */ 
-        doPendingFunctors();
+        size_t functors = doPendingFunctors();
+        int64_t iterationEnd = metrics::nowMicros();
+        metrics_.recordFunctors(functors, iterationEnd - callbackStart);
+
+        load_.recordPollLatency(iterationEnd - pollEnd);
     }
 
     LOG_INFO("EventLoop %p stop looping. \n", this);
@@ -108,32 +127,26 @@ void EventLoop::quit()
     }
 }
 
-// 在当前loop中执行cb
-void EventLoop::runInLoop(Functor cb)
+TimerId EventLoop::runAt(Timestamp time, TimerCallback cb)
 {
-    if (isInLoopThread()) // 在当前的loop线程中，执行cb
-    {
-        cb();
-    }
-    else // 在非当前loop线程中执行cb , 就需要唤醒loop所在线程，执行cb
-    {
-        queueInLoop(cb);
-    }
+    return timerQueue_->addTimer(std::move(cb), time, 0.0);
 }
-// 把cb放入队列中，唤醒loop所在的线程，执行cb
-void EventLoop::queueInLoop(Functor cb)
+
+TimerId EventLoop::runAfter(double delay, TimerCallback cb)
 {
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-        pendingFunctors_.emplace_back(cb);
-    }
+    Timestamp time(addTime(Timestamp::now(), delay));
+    return runAt(time, std::move(cb));
+}
 
-    // 唤醒相应的，需要执行上面回调操作的loop的线程了
-    // || callingPendingFunctors_的意思是：当前loop正在执行回调，但是loop又有了新的回调
-    if (!isInLoopThread() || callingPendingFunctors_) 
-    {
-        wakeup(); // 唤醒loop所在线程
-    }
+TimerId EventLoop::runEvery(double interval, TimerCallback cb)
+{
+    Timestamp time(addTime(Timestamp::now(), interval));
+    return timerQueue_->addTimer(std::move(cb), time, interval);
+}
+
+void EventLoop::cancel(TimerId timerId)
+{
+    timerQueue_->cancel(timerId);
 }
 
 void EventLoop::handleRead()
@@ -173,20 +186,14 @@ bool EventLoop::hasChannel(Channel *channel)
     return poller_->hasChannel(channel);
 }
 
-void EventLoop::doPendingFunctors() // 执行回调
+size_t EventLoop::doPendingFunctors() // 执行回调
 {
-    std::vector<Functor> functors;
     callingPendingFunctors_ = true;
+    // 先清掉标记再取任务，之后投递的线程会重新写wakeupFd_，不会丢失唤醒
+    wakeupPending_ = false;
 
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-        functors.swap(pendingFunctors_);
-    }
-
-    for (const Functor &functor : functors)
-    {
-        functor(); // 执行当前loop需要执行的回调操作
-    }
+    size_t count = pendingFunctors_.drain(); // 执行当前loop需要执行的回调操作
 
     callingPendingFunctors_ = false;
-}
\ No newline at end of file
+    return count;
+}
@@ -4,14 +4,20 @@
 #include <vector>
 #include <atomic>
 #include <memory>
-#include <mutex>
+#include <utility>
 
 #include "noncopyable.h"
 #include "Timestamp.h"
 #include "CurrentThread.h"
+#include "Callbacks.h"
+#include "TimerId.h"
+#include "FunctorQueue.h"
+#include "LoopLoad.h"
+#include "Metrics.h"
 
 class Channel;
 class Poller;
+class TimerQueue;
 
 // 时间循环类  主要包含了两个大模块 Channel   Poller（epoll的抽象）
 class EventLoop : noncopyable
@@ -28,11 +34,55 @@ public:
     void quit();
 
     Timestamp pollReturnTime() const { return pollReturnTime_; }
+    // loop循环的次数，也就是调用poller poll的次数，可以跨线程读取
+    int64_t iteration() const { return iteration_.load(std::memory_order_relaxed); }
+
+    // loop的负载计数，可以跨线程读取
+    LoopLoad& load() { return load_; }
+    const LoopLoad& load() const { return load_; }
+
+    // loop的运行统计：poll等待时间、活跃channel数、回调队列积压、回调耗时，可以跨线程读取
+    LoopMetrics::Snapshot metricsSnapshot() const { return metrics_.snapshot(); }
     
     // 在当前loop中执行cb
-    void runInLoop(Functor cb);
+    template <typename F>
+    void runInLoop(F &&cb)
+    {
+        if (isInLoopThread()) // 在当前的loop线程中，执行cb
+        {
+            cb();
+        }
+        else // 在非当前loop线程中执行cb , 就需要唤醒loop所在线程，执行cb
+        {
+            queueInLoop(std::forward<F>(cb));
+        }
+    }
+
     // 把cb放入队列中，唤醒loop所在的线程，执行cb
-    void queueInLoop(Functor cb);
+    template <typename F>
+    void queueInLoop(F &&cb)
+    {
+        pendingFunctors_.push(std::forward<F>(cb));
+
+        // 唤醒相应的，需要执行上面回调操作的loop的线程了
+        // || callingPendingFunctors_的意思是：当前loop正在执行回调，但是loop又有了新的回调
+        // 上一次执行回调之后，只有第一个投递回调的线程需要写wakeupFd_，后面的都合并到这一次唤醒里面
+        if ((!isInLoopThread() || callingPendingFunctors_)
+            && !wakeupPending_.load()
+            && !wakeupPending_.exchange(true))
+        {
+            wakeup(); // 唤醒loop所在线程
+        }
+    }
+
+    // 在time时刻执行cb
+    TimerId runAt(Timestamp time, TimerCallback cb);
+    // 在delay秒之后执行cb
+    TimerId runAfter(double delay, TimerCallback cb);
+    // 每隔interval秒执行一次cb
+    TimerId runEvery(double interval, TimerCallback cb);
+    // 取消定时器，可以跨线程调用
+    void cancel(TimerId timerId);
 
     // 用来唤醒loop所在的线程的
     void wakeup();
@@ -46,17 +96,21 @@ public:
     bool isInLoopThread() const { return threadId_ ==  CurrentThread::tid(); }
 private:
     void handleRead(); // wake up
-    void doPendingFunctors(); // 执行回调
+    size_t doPendingFunctors(); // 执行回调，返回执行的回调个数
 
     using ChannelList = std::vector<Channel*>;
 
     std::atomic_bool looping_;  // 原子操作，通过CAS实现的
     std::atomic_bool quit_; // 标识退出loop循环
+    std::atomic<int64_t> iteration_;
     
     const pid_t threadId_; // 记录当前loop所在线程的id
 
     Timestamp pollReturnTime_; // poller返回发生事件的channels的时间点
+    LoopLoad load_;
+    LoopMetrics metrics_;
     std::unique_ptr<Poller> poller_;
+    std::unique_ptr<TimerQueue> timerQueue_; // 定时器队列，timerfd也是poller_监听的一个channel
 
     int wakeupFd_; // 主要作用，当mainLoop获取一个新用户的channel，通过轮询算法选择一个subloop，通过该成员唤醒subloop处理channel
     std::unique_ptr<Channel> wakeupChannel_;
@@ -64,6 +118,6 @@ private:
     ChannelList activeChannels_;
 
     std::atomic_bool callingPendingFunctors_; // 标识当前loop是否有需要执行的回调操作
-    std::vector<Functor> pendingFunctors_; // 存储loop需要执行的所有的回调操作
-    std::mutex mutex_; // 互斥锁，用来保护上面vector容器的线程安全操作
+    FunctorQueue pendingFunctors_; // 存储loop需要执行的所有的回调操作  无锁队列，其它线程投递不需要加锁
+    std::atomic_bool wakeupPending_; // 已经有线程写过wakeupFd_，loop还没有开始执行回调
 };
\ No newline at end of file
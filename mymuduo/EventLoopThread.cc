@@ -16,10 +16,30 @@ EventLoopThread::EventLoopThread(const ThreadInitCallback &cb,
 
 EventLoopThread::~EventLoopThread()
 {
-    exiting_ = true;
-    if (loop_ != nullptr)
+    stop();
+}
+
+void EventLoopThread::stop(const ThreadExitCallback &cb)
+{
+    bool running = false;
+    {
+        // 加锁quit，loop线程看到exiting_之前不会销毁EventLoop
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (exiting_)
+        {
+            return;
+        }
+        exiting_ = true;
+        exitCallback_ = cb;
+        if (loop_ != nullptr)
+        {
+            running = true;
+            loop_->quit();
+        }
+        cond_.notify_all();
+    }
+    if (running)
     {
-        loop_->quit();
         thread_.join();
     }
 }
@@ -53,10 +73,26 @@ void EventLoopThread::threadFunc()
     {
         std::unique_lock<std::mutex> lock(mutex_);
         loop_ = &loop;
-        cond_.notify_one();
+        cond_.notify_all();
     }
 
     loop.loop(); // EventLoop loop  => Poller.poll
+
+    // loop()返回之后等到stop，这之前loop上的对象还可能被别的线程访问，EventLoop不能销毁
+    ThreadExitCallback exitCallback;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!exiting_)
+        {
+            cond_.wait(lock);
+        }
+        exitCallback = exitCallback_;
+    }
+    if (exitCallback)
+    {
+        exitCallback(&loop);
+    }
+
     std::unique_lock<std::mutex> lock(mutex_);
     loop_ = nullptr;
 }
\ No newline at end of file
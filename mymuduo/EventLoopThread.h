@@ -14,12 +14,16 @@ class EventLoopThread : noncopyable
 {
 public:
     using ThreadInitCallback = std::function<void(EventLoop*)>; 
+    using ThreadExitCallback = std::function<void(EventLoop*)>;
 
     EventLoopThread(const ThreadInitCallback &cb = ThreadInitCallback(), 
         const std::string &name = std::string());
     ~EventLoopThread();
 
     EventLoop* startLoop();
+    // 让loop退出并等待线程结束。cb在loop线程里面、loop()返回之后、EventLoop销毁之前调用，
+    // 可以在这里销毁属于这个loop的对象。loop被别人提前quit的话EventLoop会一直保留到stop
+    void stop(const ThreadExitCallback &cb = ThreadExitCallback());
 private:
     void threadFunc();
 
@@ -29,4 +33,5 @@ private:
     std::mutex mutex_;
     std::condition_variable cond_;
     ThreadInitCallback callback_;
+    ThreadExitCallback exitCallback_;
 };
\ No newline at end of file
@@ -1,7 +1,10 @@
 #include "EventLoopThreadPool.h"
 #include "EventLoopThread.h"
+#include "EventLoop.h"
+#include "Logger.h"
 
 #include <memory>
+#include <algorithm>
 
 EventLoopThreadPool::EventLoopThreadPool(EventLoop *baseLoop, const std::string &nameArg)
     : baseLoop_(baseLoop)
@@ -9,6 +12,7 @@ EventLoopThreadPool::EventLoopThreadPool(EventLoop *baseLoop, const std::string
     , started_(false)
     , numThreads_(0)
     , next_(0)
+    , policy_(kRoundRobin)
 {}
 
 EventLoopThreadPool::~EventLoopThreadPool()
@@ -34,14 +38,51 @@ void EventLoopThreadPool::start(const ThreadInitCallback &cb)
     }
 }
 
+void EventLoopThreadPool::stop(const ThreadExitCallback &cb)
+{
+    for (auto &t : threads_)
+    {
+        t->stop(cb);
+    }
+    threads_.clear();
+    loops_.clear();
+}
+
 // 如果工作在多线程中，baseLoop_默认以轮询的方式分配channel给subloop
 EventLoop* EventLoopThreadPool::getNextLoop()
 {
     EventLoop *loop = baseLoop_;
 
+    if (!loops_.empty() && placementCallback_)
+    {
+        EventLoop *chosen = placementCallback_(loops_);
+        if (std::find(loops_.begin(), loops_.end(), chosen) != loops_.end())
+        {
+            return chosen;
+        }
+        // 自定义策略返回了不属于线程池的loop，退回到内置的策略
+        LOG_ERROR("EventLoopThreadPool::getNextLoop [%s] - placement callback returned a loop not in the pool\n",
+            name_.c_str());
+    }
+
     if (!loops_.empty()) // 通过轮询获取下一个处理事件的loop
     {
         loop = loops_[next_];
+        if (policy_ != kRoundRobin)
+        {
+            // 从轮询的位置开始找负载最小的loop，负载相同的时候仍然是轮询的效果
+            int64_t best = loadOf(loop);
+            for (size_t i = 1; i < loops_.size(); ++i)
+            {
+                EventLoop *candidate = loops_[(next_ + i) % loops_.size()];
+                int64_t load = loadOf(candidate);
+                if (load < best)
+                {
+                    best = load;
+                    loop = candidate;
+                }
+            }
+        }
         ++next_;
         if (next_ >= loops_.size())
         {
@@ -52,6 +93,21 @@ EventLoop* EventLoopThreadPool::getNextLoop()
     return loop;
 }
 
+int64_t EventLoopThreadPool::loadOf(const EventLoop *loop) const
+{
+    switch (policy_)
+    {
+    case kLeastConnections:
+        return loop->load().connections();
+    case kLeastPendingBytes:
+        return loop->load().pendingBytes();
+    case kLeastPollLatency:
+        return loop->load().pollLatencyUs();
+    default:
+        return 0;
+    }
+}
+
 std::vector<EventLoop*> EventLoopThreadPool::getAllLoops()
 {
     if (loops_.empty())
@@ -60,6 +116,31 @@ std::vector<EventLoop*> EventLoopThreadPool::getAllLoops()
     }
     else
     {
-        loops_;
+        return loops_;
+    }
+}
+
+std::vector<LoopLoad::Snapshot> EventLoopThreadPool::loadSnapshot()
+{
+    std::vector<LoopLoad::Snapshot> result;
+    for (EventLoop *loop : getAllLoops())
+    {
+        LoopLoad::Snapshot snapshot;
+        snapshot.connections = loop->load().connections();
+        snapshot.pendingBytes = loop->load().pendingBytes();
+        snapshot.pollLatencyUs = loop->load().pollLatencyUs();
+        snapshot.iterations = loop->iteration();
+        result.push_back(snapshot);
     }
-}
\ No newline at end of file
+    return result;
+}
+
+std::vector<LoopMetrics::Snapshot> EventLoopThreadPool::metricsSnapshot()
+{
+    std::vector<LoopMetrics::Snapshot> result;
+    for (EventLoop *loop : getAllLoops())
+    {
+        result.push_back(loop->metricsSnapshot());
+    }
+    return result;
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include "noncopyable.h"
+#include "LoopLoad.h"
+#include "Metrics.h"
 
 #include <functional>
 #include <string>
@@ -13,28 +15,55 @@ class EventLoopThreadPool : noncopyable
 {
 public:
     using ThreadInitCallback = std::function<void(EventLoop*)>; 
+    using ThreadExitCallback = std::function<void(EventLoop*)>;
+    // 自定义的分配策略，参数是所有的subloop，返回新连接要分配到的subloop
+    using PlacementCallback = std::function<EventLoop*(const std::vector<EventLoop*>&)>;
+
+    // 新连接分配到subloop的策略
+    enum PlacementPolicy
+    {
+        kRoundRobin,        // 轮询
+        kLeastConnections,  // 连接数最少
+        kLeastPendingBytes, // 发送缓冲区积压的数据最少
+        kLeastPollLatency,  // 最近每轮处理耗时最短
+    };
 
     EventLoopThreadPool(EventLoop *baseLoop, const std::string &nameArg);
     ~EventLoopThreadPool();
 
     void setThreadNum(int numThreads) { numThreads_ = numThreads; }
+    void setPlacementPolicy(PlacementPolicy policy) { policy_ = policy; }
+    // 设置了自定义策略以后，PlacementPolicy不再生效；回调返回的loop不在线程池里面时仍按PlacementPolicy选择
+    void setPlacementCallback(const PlacementCallback &cb) { placementCallback_ = cb; }
 
     void start(const ThreadInitCallback &cb = ThreadInitCallback());
+    // 让所有subloop退出并等待线程结束，cb在每个subloop自己的线程里面、loop()返回之后调用
+    // stop之后getAllLoops等返回的subloop都已经销毁，只能再析构线程池
+    void stop(const ThreadExitCallback &cb = ThreadExitCallback());
 
     // 如果工作在多线程中，baseLoop_默认以轮询的方式分配channel给subloop
     EventLoop* getNextLoop();
 
     std::vector<EventLoop*> getAllLoops();
 
+    // 每个loop的负载，顺序和getAllLoops()一致，可以在任意线程调用
+    std::vector<LoopLoad::Snapshot> loadSnapshot();
+    // 每个loop的运行统计，顺序和getAllLoops()一致，可以在任意线程调用
+    std::vector<LoopMetrics::Snapshot> metricsSnapshot();
+
     bool started() const { return started_; }
     const std::string name() const { return name_; }
 private:
+    // 按照policy_取loop的负载，值越小越空闲
+    int64_t loadOf(const EventLoop *loop) const;
 
     EventLoop *baseLoop_; // EventLoop loop;  
     std::string name_;
     bool started_;
     int numThreads_;
     int next_;
+    PlacementPolicy policy_;
+    PlacementCallback placementCallback_;
     std::vector<std::unique_ptr<EventLoopThread>> threads_;
     std::vector<EventLoop*> loops_;
 };
\ No newline at end of file
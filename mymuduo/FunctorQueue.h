@@ -0,0 +1,143 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+/**
+ * 多生产者单消费者的无锁任务队列  EventLoop用它保存其它线程投递过来的回调
+ * 侵入式链表(Vyukov MPSC)：push只有一次atomic exchange，不需要加锁
+ * 任务对象直接保存在链表节点里面，std::bind/lambda不需要再被std::function包一层，
+ * 每个任务只有一次内存分配
+ *
+ * push可以在任意线程调用，drain只能在消费者(loop)线程调用
+ */
+class FunctorQueue : noncopyable
+{
+public:
+    FunctorQueue()
+        : head_(&stub_)
+        , tail_(&stub_)
+    {
+        stub_.next.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~FunctorQueue()
+    {
+        // 没来得及执行的任务直接销毁
+        while (Node *node = pop())
+        {
+            node->invoke(node, false);
+        }
+    }
+
+    template <typename F>
+    void push(F &&f)
+    {
+        using Task = TaskNode<typename std::decay<F>::type>;
+        pushNode(new Task(std::forward<F>(f)));
+    }
+
+    /**
+     * 执行队列中的任务，只执行调用时已经在队列里面的任务，
+     * 执行过程中新push进来的任务留到下一次drain，避免任务不断投递自己把loop饿死
+     * 返回执行的任务个数
+     */
+    size_t drain()
+    {
+        // head_是stub_并不代表队列为空：pop()把stub_放回队尾时，前面可能还有没链接完的任务
+        // 这时stub_之前的节点都是调用时已经在队列里面的任务，tail_走到stub_就停下
+        Node *last = head_.load(std::memory_order_acquire);
+        size_t count = 0;
+        while (!(last == &stub_ && tail_ == &stub_))
+        {
+            Node *node = pop();
+            if (node == nullptr)
+            {
+                break;
+            }
+            bool isLast = (node == last);
+            node->invoke(node, true);
+            ++count;
+            if (isLast)
+            {
+                break;
+            }
+        }
+        return count;
+    }
+private:
+    struct Node
+    {
+        std::atomic<Node*> next;
+        // run为true时执行任务，然后销毁节点
+        void (*invoke)(Node *node, bool run);
+    };
+
+    template <typename F>
+    struct TaskNode : Node
+    {
+        explicit TaskNode(F &&f) : func(std::move(f)) { this->invoke = &TaskNode::invokeTask; }
+        explicit TaskNode(const F &f) : func(f) { this->invoke = &TaskNode::invokeTask; }
+
+        static void invokeTask(Node *node, bool run)
+        {
+            TaskNode *task = static_cast<TaskNode*>(node);
+            if (run)
+            {
+                task->func();
+            }
+            delete task;
+        }
+
+        F func;
+    };
+
+    void pushNode(Node *node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node *prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // 取出一个节点，队列为空或者某个生产者正在push的中间状态返回nullptr
+    Node* pop()
+    {
+        Node *tail = tail_;
+        Node *next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_)
+        {
+            if (next == nullptr)
+            {
+                return nullptr;
+            }
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr)
+        {
+            tail_ = next;
+            return tail;
+        }
+        if (tail != head_.load(std::memory_order_acquire))
+        {
+            return nullptr; // 生产者exchange了head_但还没有链接上next
+        }
+        pushNode(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next != nullptr)
+        {
+            tail_ = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    std::atomic<Node*> head_; // 生产者push的位置
+    Node *tail_;              // 消费者pop的位置
+    Node stub_;
+};
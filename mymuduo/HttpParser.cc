@@ -0,0 +1,295 @@
+#include "HttpParser.h"
+#include "Buffer.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace
+{
+
+const char kCRLF[] = "\r\n";
+const char kHeaderEnd[] = "\r\n\r\n";
+
+bool isWhitespace(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+StringPiece trimWhitespace(const char *begin, const char *end)
+{
+    while (begin < end && isWhitespace(*begin))
+    {
+        ++begin;
+    }
+    while (end > begin && isWhitespace(end[-1]))
+    {
+        --end;
+    }
+    return StringPiece(begin, end - begin);
+}
+
+// Connection头部是逗号分隔的列表，判断里面是否有token
+bool hasToken(StringPiece value, const StringPiece &token)
+{
+    while (!value.empty())
+    {
+        const char *comma = static_cast<const char*>(::memchr(value.data(), ',', value.size()));
+        const char *end = comma ? comma : value.end();
+        if (trimWhitespace(value.data(), end).equalsIgnoreCase(token))
+        {
+            return true;
+        }
+        value = comma ? StringPiece(comma + 1, value.end() - comma - 1) : StringPiece();
+    }
+    return false;
+}
+
+bool parseContentLength(const StringPiece &value, size_t *length)
+{
+    if (value.empty() || value.size() > 18)
+    {
+        return false;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        if (value[i] < '0' || value[i] > '9')
+        {
+            return false;
+        }
+        n = n * 10 + (value[i] - '0');
+    }
+    *length = n;
+    return true;
+}
+
+} // namespace
+
+HttpParser::HttpParser(size_t maxBodySize)
+    : maxBodySize_(maxBodySize)
+    , state_(kExpectHeaders)
+    , scanned_(0)
+    , headerLen_(0)
+    , reparse_(false)
+    , errorStatus_(0)
+{
+}
+
+HttpParser::Result HttpParser::parse(const Buffer *buf)
+{
+    if (state_ == kFailed)
+    {
+        return kError;
+    }
+    if (state_ == kGotAll)
+    {
+        return kComplete;
+    }
+
+    const char *begin = buf->peek();
+    const size_t readable = buf->readableBytes();
+
+    if (state_ == kExpectHeaders)
+    {
+        // 上次扫描到的末尾可能正好是结束标记的前几个字节，往回退3个字节开始找
+        size_t from = scanned_ > 3 ? scanned_ - 3 : 0;
+        const char *found = static_cast<const char*>(
+            ::memmem(begin + from, readable - from, kHeaderEnd, 4));
+        if (found == nullptr)
+        {
+            scanned_ = readable;
+            return readable > kMaxHeaderSize ? fail(431) : kIncomplete;
+        }
+
+        headerLen_ = found + 4 - begin;
+        if (headerLen_ > kMaxHeaderSize)
+        {
+            return fail(431);
+        }
+        if (!parseHeaders(begin, begin + headerLen_))
+        {
+            return kError;
+        }
+        state_ = kExpectBody;
+        reparse_ = false;
+    }
+
+    if (readable < headerLen_ + request_.contentLength_)
+    {
+        reparse_ = true;
+        return kIncomplete;
+    }
+    if (reparse_)
+    {
+        request_.reset();
+        parseHeaders(begin, begin + headerLen_);
+    }
+    request_.body_ = StringPiece(begin + headerLen_, request_.contentLength_);
+    state_ = kGotAll;
+    return kComplete;
+}
+
+void HttpParser::consume(Buffer *buf)
+{
+    if (state_ != kGotAll)
+    {
+        return;
+    }
+    buf->retrieve(headerLen_ + request_.contentLength_);
+    request_.reset();
+    state_ = kExpectHeaders;
+    scanned_ = 0;
+    headerLen_ = 0;
+    reparse_ = false;
+}
+
+HttpParser::Result HttpParser::fail(int status)
+{
+    state_ = kFailed;
+    errorStatus_ = status;
+    return kError;
+}
+
+bool HttpParser::parseRequestLine(const char *begin, const char *end)
+{
+    // METHOD SP request-target SP HTTP-version
+    const char *space = std::find(begin, end, ' ');
+    if (space == end)
+    {
+        return false;
+    }
+    StringPiece method(begin, space - begin);
+    if (method == "GET")
+    {
+        request_.method_ = HttpRequest::kGet;
+    }
+    else if (method == "POST")
+    {
+        request_.method_ = HttpRequest::kPost;
+    }
+    else if (method == "HEAD")
+    {
+        request_.method_ = HttpRequest::kHead;
+    }
+    else if (method == "PUT")
+    {
+        request_.method_ = HttpRequest::kPut;
+    }
+    else if (method == "DELETE")
+    {
+        request_.method_ = HttpRequest::kDelete;
+    }
+    else if (method == "OPTIONS")
+    {
+        request_.method_ = HttpRequest::kOptions;
+    }
+    else if (method == "PATCH")
+    {
+        request_.method_ = HttpRequest::kPatch;
+    }
+    else
+    {
+        fail(501);
+        return false;
+    }
+    request_.methodString_ = method;
+
+    const char *targetBegin = space + 1;
+    space = std::find(targetBegin, end, ' ');
+    if (space == end || space == targetBegin)
+    {
+        return false;
+    }
+    const char *question = std::find(targetBegin, space, '?');
+    request_.path_ = StringPiece(targetBegin, question - targetBegin);
+    if (question != space)
+    {
+        request_.query_ = StringPiece(question + 1, space - question - 1);
+    }
+
+    StringPiece version(space + 1, end - space - 1);
+    if (version == "HTTP/1.1")
+    {
+        request_.version_ = HttpRequest::kHttp11;
+    }
+    else if (version == "HTTP/1.0")
+    {
+        request_.version_ = HttpRequest::kHttp10;
+    }
+    else if (version.startsWith("HTTP/"))
+    {
+        fail(505);
+        return false;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+bool HttpParser::parseHeaders(const char *begin, const char *end)
+{
+    const char *lineEnd = std::search(begin, end, kCRLF, kCRLF + 2);
+    if (!parseRequestLine(begin, lineEnd))
+    {
+        if (state_ != kFailed)
+        {
+            fail(400);
+        }
+        return false;
+    }
+
+    bool gotContentLength = false;
+    const char *headersEnd = end - 2; // 最后的空行
+    for (const char *line = lineEnd + 2; line < headersEnd; line = lineEnd + 2)
+    {
+        lineEnd = std::search(line, end, kCRLF, kCRLF + 2);
+        const char *colon = std::find(line, lineEnd, ':');
+        // 名字里面不允许有空白，这样也拒绝了obs-fold折行和名字与冒号之间的空白
+        if (colon == lineEnd || colon == line
+            || std::find_if(line, colon, isWhitespace) != colon)
+        {
+            fail(400);
+            return false;
+        }
+
+        StringPiece name(line, colon - line);
+        StringPiece value = trimWhitespace(colon + 1, lineEnd);
+        request_.headers_.push_back(HttpRequest::Header(name, value));
+
+        if (name.equalsIgnoreCase("Content-Length"))
+        {
+            size_t length = 0;
+            if (!parseContentLength(value, &length)
+                || (gotContentLength && length != request_.contentLength_))
+            {
+                fail(400);
+                return false;
+            }
+            if (length > maxBodySize_)
+            {
+                fail(413);
+                return false;
+            }
+            request_.contentLength_ = length;
+            gotContentLength = true;
+        }
+        else if (name.equalsIgnoreCase("Transfer-Encoding"))
+        {
+            fail(501); // 不支持chunked请求体
+            return false;
+        }
+    }
+
+    StringPiece connection = request_.header("Connection");
+    if (request_.version_ == HttpRequest::kHttp11)
+    {
+        request_.keepAlive_ = !hasToken(connection, "close");
+    }
+    else
+    {
+        request_.keepAlive_ = hasToken(connection, "keep-alive");
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "HttpRequest.h"
+
+class Buffer;
+
+/**
+ * 增量式的HTTP/1.1请求解析器  每个连接一个，直接在Buffer::peek()上解析，不拷贝数据
+ *
+ * onMessage里面的用法：
+ *   while (parser.parse(buf) == HttpParser::kComplete)
+ *   {
+ *       handle(parser.request());
+ *       parser.consume(buf); // 取走这个请求，继续解析流水线中的下一个
+ *   }
+ *
+ * 头部没有收全时记住已经扫描过的位置，下次只扫描新到的数据；请求体只支持Content-Length
+ */
+class HttpParser : noncopyable
+{
+public:
+    enum Result
+    {
+        kIncomplete, // 数据还不够一个完整的请求
+        kComplete,   // request()可用，处理完之后调用consume
+        kError,      // 请求格式错误，errorStatus()是应该返回的状态码，之后不能再继续解析这个连接
+    };
+
+    static const size_t kMaxHeaderSize = 8 * 1024;
+    static const size_t kDefaultMaxBodySize = 1024 * 1024;
+
+    explicit HttpParser(size_t maxBodySize = kDefaultMaxBodySize);
+
+    // 从buf->peek()开始解析一个请求，不会修改buf
+    Result parse(const Buffer *buf);
+    // parse返回kComplete之后有效，指向buf中的数据
+    const HttpRequest& request() const { return request_; }
+    // 从buf中取走当前的请求，开始解析下一个
+    void consume(Buffer *buf);
+
+    int errorStatus() const { return errorStatus_; }
+private:
+    enum State
+    {
+        kExpectHeaders,
+        kExpectBody,
+        kGotAll,
+        kFailed,
+    };
+
+    // 解析[begin, end)之间的请求行和头部，end指向空行之后
+    bool parseHeaders(const char *begin, const char *end);
+    bool parseRequestLine(const char *begin, const char *end);
+    Result fail(int status);
+
+    const size_t maxBodySize_;
+    State state_;
+    size_t scanned_;   // 已经确认没有头部结束标记的字节数
+    size_t headerLen_; // 请求行+头部+空行的长度
+    bool reparse_;     // 头部解析之后Buffer可能被挪动，请求体收全之后重新解析一遍头部
+    int errorStatus_;
+    HttpRequest request_;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "StringPiece.h"
+
+#include <vector>
+#include <utility>
+
+/**
+ * 一个HTTP请求  由HttpParser解析得到，所有字段都是指向接收缓冲区的StringPiece，没有拷贝，
+ * 只在HttpServer的回调期间有效(回调返回之后请求数据就从Buffer中取走了)，需要保存的话调用toString()
+ */
+class HttpRequest
+{
+public:
+    enum Method
+    {
+        kInvalid, kGet, kPost, kHead, kPut, kDelete, kOptions, kPatch,
+    };
+    enum Version
+    {
+        kUnknown, kHttp10, kHttp11,
+    };
+
+    using Header = std::pair<StringPiece, StringPiece>;
+
+    HttpRequest()
+        : method_(kInvalid)
+        , version_(kUnknown)
+        , keepAlive_(false)
+        , contentLength_(0)
+    {}
+
+    Method method() const { return method_; }
+    StringPiece methodString() const { return methodString_; }
+    Version version() const { return version_; }
+    // 请求目标中?之前的部分
+    StringPiece path() const { return path_; }
+    // ?之后的部分，不包含?
+    StringPiece query() const { return query_; }
+    StringPiece body() const { return body_; }
+
+    // 头部的名字大小写不敏感，没有这个头部返回空的StringPiece
+    StringPiece header(const StringPiece &name) const
+    {
+        for (const Header &header : headers_)
+        {
+            if (header.first.equalsIgnoreCase(name))
+            {
+                return header.second;
+            }
+        }
+        return StringPiece();
+    }
+    const std::vector<Header>& headers() const { return headers_; }
+
+    // 根据版本和Connection头部判断响应之后是否保持连接
+    bool keepAlive() const { return keepAlive_; }
+    size_t contentLength() const { return contentLength_; }
+
+    // 清空所有字段，headers_的内存保留下来给下一个请求使用
+    void reset()
+    {
+        method_ = kInvalid;
+        version_ = kUnknown;
+        keepAlive_ = false;
+        contentLength_ = 0;
+        methodString_ = path_ = query_ = body_ = StringPiece();
+        headers_.clear();
+    }
+private:
+    friend class HttpParser;
+
+    Method method_;
+    Version version_;
+    bool keepAlive_;
+    size_t contentLength_;
+    StringPiece methodString_;
+    StringPiece path_;
+    StringPiece query_;
+    StringPiece body_;
+    std::vector<Header> headers_;
+};
@@ -0,0 +1,63 @@
+#include "HttpResponse.h"
+#include "Buffer.h"
+
+#include <stdio.h>
+
+void HttpResponse::addHeader(const StringPiece &name, const StringPiece &value)
+{
+    headers_.append(name.data(), name.size());
+    headers_.append(": ", 2);
+    headers_.append(value.data(), value.size());
+    headers_.append("\r\n", 2);
+}
+
+void HttpResponse::appendToBuffer(Buffer *output, bool withBody) const
+{
+    char buf[64];
+    int n = snprintf(buf, sizeof buf, "HTTP/1.1 %d ", statusCode_);
+    output->append(buf, n);
+    output->append(statusMessage_.data(), statusMessage_.size());
+
+    if (closeConnection_)
+    {
+        static const char kClose[] = "\r\nConnection: close\r\n";
+        output->append(kClose, sizeof kClose - 1);
+    }
+    else
+    {
+        // HTTP/1.0的客户端需要显式的keep-alive
+        static const char kKeepAlive[] = "\r\nConnection: keep-alive\r\n";
+        output->append(kKeepAlive, sizeof kKeepAlive - 1);
+    }
+    n = snprintf(buf, sizeof buf, "Content-Length: %zu\r\n", body_.size());
+    output->append(buf, n);
+
+    output->append(headers_.data(), headers_.size());
+    output->append("\r\n", 2);
+    if (withBody)
+    {
+        output->append(body_.data(), body_.size());
+    }
+}
+
+const char* HttpResponse::reasonPhrase(int code)
+{
+    switch (code)
+    {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 301: return "Moved Permanently";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    case 505: return "HTTP Version Not Supported";
+    default:  return "Unknown";
+    }
+}
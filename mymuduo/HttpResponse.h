@@ -0,0 +1,53 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "StringPiece.h"
+
+#include <string>
+
+class Buffer;
+
+/**
+ * HTTP响应  状态行和头部直接格式化到outputBuffer，Content-Length和Connection头部自动生成
+ * setBody(StringPiece)只保存指针，常量字符串或者回调期间一直有效的数据可以少拷贝一次
+ */
+class HttpResponse : noncopyable
+{
+public:
+    explicit HttpResponse(bool closeConnection)
+        : statusCode_(200)
+        , statusMessage_("OK")
+        , closeConnection_(closeConnection)
+    {}
+
+    // message通常是字符串常量，需要在appendToBuffer之前一直有效
+    void setStatus(int code, const StringPiece &message)
+    { statusCode_ = code; statusMessage_ = message; }
+    // 使用标准的原因短语
+    void setStatus(int code)
+    { setStatus(code, reasonPhrase(code)); }
+    int statusCode() const { return statusCode_; }
+
+    void setCloseConnection(bool on) { closeConnection_ = on; }
+    bool closeConnection() const { return closeConnection_; }
+
+    void setContentType(const StringPiece &contentType)
+    { addHeader("Content-Type", contentType); }
+    void addHeader(const StringPiece &name, const StringPiece &value);
+
+    void setBody(const StringPiece &body) { ownedBody_.clear(); body_ = body; }
+    void setBody(const char *body) { setBody(StringPiece(body)); }
+    void setBody(std::string &&body) { ownedBody_ = std::move(body); body_ = ownedBody_; }
+
+    // withBody为false时只写状态行和头部(HEAD请求)，Content-Length仍然是body的长度
+    void appendToBuffer(Buffer *output, bool withBody = true) const;
+
+    static const char* reasonPhrase(int code);
+private:
+    int statusCode_;
+    StringPiece statusMessage_;
+    bool closeConnection_;
+    std::string headers_; // 已经格式化好的 "name: value\r\n"
+    StringPiece body_;
+    std::string ownedBody_;
+};
@@ -0,0 +1,111 @@
+#include "HttpServer.h"
+#include "Logger.h"
+
+namespace
+{
+
+// 没有设置回调时所有请求都返回404
+void defaultHttpCallback(const HttpRequest&, HttpResponse *resp)
+{
+    resp->setStatus(404);
+}
+
+} // namespace
+
+HttpServer::HttpServer(EventLoop *loop,
+                       const InetAddress &listenAddr,
+                       const std::string &name,
+                       TcpServer::Option option)
+    : loop_(loop)
+    , server_(loop, listenAddr, name, option)
+    , httpCallback_(defaultHttpCallback)
+    , maxBodySize_(HttpParser::kDefaultMaxBodySize)
+{
+    server_.setConnectionCallback(
+        std::bind(&HttpServer::onConnection, this, std::placeholders::_1)
+    );
+    server_.setMessageCallback(
+        std::bind(&HttpServer::onMessage, this,
+            std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)
+    );
+}
+
+void HttpServer::start()
+{
+    server_.start();
+}
+
+void HttpServer::onConnection(const TcpConnectionPtr &conn)
+{
+    if (conn->connected())
+    {
+        conn->setContext(std::make_shared<HttpParser>(maxBodySize_));
+    }
+}
+
+void HttpServer::onMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp)
+{
+    if (!conn->connected())
+    {
+        buf->retrieveAll(); // 已经决定关闭连接了，后面的请求不再处理
+        return;
+    }
+
+    // 解析器在onConnection里面设置，context被别人替换掉的话这个连接没法再处理
+    HttpParser *parser = static_cast<HttpParser*>(conn->getContext().get());
+    if (parser == nullptr)
+    {
+        LOG_ERROR("HttpServer::onMessage [%s] - no parser in connection context \n", conn->name().c_str());
+        buf->retrieveAll();
+        conn->shutdown();
+        return;
+    }
+
+    // 本线程所有连接共用的响应缓冲区，send之后就清空了，避免每次onMessage都分配内存
+    static thread_local Buffer t_output;
+    Buffer &output = t_output;
+    bool close = false;
+
+    for (;;)
+    {
+        HttpParser::Result result = parser->parse(buf);
+        if (result == HttpParser::kIncomplete)
+        {
+            break;
+        }
+        if (result == HttpParser::kError)
+        {
+            LOG_ERROR("HttpServer::onMessage [%s] - bad request, status %d \n",
+                conn->name().c_str(), parser->errorStatus());
+            HttpResponse response(true);
+            response.setStatus(parser->errorStatus());
+            response.appendToBuffer(&output);
+            buf->retrieveAll();
+            close = true;
+            break;
+        }
+
+        const HttpRequest &request = parser->request();
+        HttpResponse response(!request.keepAlive());
+        httpCallback_(request, &response);
+        response.appendToBuffer(&output, request.method() != HttpRequest::kHead);
+        parser->consume(buf);
+
+        if (response.closeConnection())
+        {
+            close = true;
+            break;
+        }
+    }
+
+    if (output.readableBytes() > 0)
+    {
+        conn->send(&output); // onMessage在连接所属的loop线程中，这里不会拷贝
+    }
+    // 连接不是kConnected状态时send什么也不做，这里一定要清空，否则会发给这个线程上的下一个连接
+    output.retrieveAll();
+    if (close)
+    {
+        conn->shutdown();
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "TcpServer.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "HttpParser.h"
+
+#include <functional>
+#include <string>
+
+/**
+ * 基于TcpServer的HTTP/1.1服务器  支持keep-alive和流水线
+ * 同一次onMessage里面解析出来的多个请求的响应合并到一个Buffer里面，一次send发送出去
+ *
+ * HttpCallback在连接所属的subloop线程中执行，request的字段只在回调期间有效
+ */
+class HttpServer : noncopyable
+{
+public:
+    using HttpCallback = std::function<void (const HttpRequest&, HttpResponse*)>;
+
+    HttpServer(EventLoop *loop,
+               const InetAddress &listenAddr,
+               const std::string &name,
+               TcpServer::Option option = TcpServer::kNoReusePort);
+
+    EventLoop* getLoop() const { return loop_; }
+    // 底层的TcpServer，用来设置线程数以外的其它选项，比如ET模式、连接分配策略
+    TcpServer& tcpServer() { return server_; }
+
+    void setHttpCallback(const HttpCallback &cb) { httpCallback_ = cb; }
+    void setThreadNum(int numThreads) { server_.setThreadNum(numThreads); }
+    // 请求体的最大字节数，超过的请求返回413
+    void setMaxBodySize(size_t maxBodySize) { maxBodySize_ = maxBodySize; }
+
+    void start();
+private:
+    void onConnection(const TcpConnectionPtr &conn);
+    void onMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp receiveTime);
+
+    EventLoop *loop_;
+    TcpServer server_;
+    HttpCallback httpCallback_;
+    size_t maxBodySize_;
+};
@@ -0,0 +1,105 @@
+#include "LogFile.h"
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+LogFile::LogFile(const std::string &basename, off_t rollSize, int rollInterval)
+    : basename_(basename)
+    , rollSize_(rollSize)
+    , rollInterval_(rollInterval > 0 ? rollInterval : kDefaultRollInterval)
+    , fp_(nullptr)
+    , writtenBytes_(0)
+    , startOfPeriod_(0)
+    , lastRoll_(0)
+{
+    rollFile();
+}
+
+LogFile::~LogFile()
+{
+    if (fp_)
+    {
+        ::fclose(fp_);
+    }
+}
+
+void LogFile::append(const char *data, size_t len)
+{
+    if (fp_ == nullptr)
+    {
+        return;
+    }
+
+    size_t written = 0;
+    while (written < len)
+    {
+        size_t n = ::fwrite_unlocked(data + written, 1, len - written, fp_);
+        if (n == 0)
+        {
+            int err = ::ferror(fp_);
+            if (err)
+            {
+                ::fprintf(stderr, "LogFile::append() failed: %s\n", ::strerror(err));
+            }
+            break;
+        }
+        written += n;
+    }
+    writtenBytes_ += written;
+
+    if (writtenBytes_ > rollSize_)
+    {
+        rollFile();
+    }
+    else if (::time(NULL) / rollInterval_ * rollInterval_ != startOfPeriod_)
+    {
+        rollFile();
+    }
+}
+
+void LogFile::flush()
+{
+    if (fp_)
+    {
+        ::fflush(fp_);
+    }
+}
+
+bool LogFile::rollFile()
+{
+    time_t now = ::time(NULL);
+    if (now <= lastRoll_)
+    {
+        return false;
+    }
+
+    std::string filename = getLogFileName(basename_, now);
+    FILE *fp = ::fopen(filename.c_str(), "ae"); // 'e' => O_CLOEXEC
+    if (fp == nullptr)
+    {
+        ::fprintf(stderr, "LogFile::rollFile() open %s failed: %s\n", filename.c_str(), ::strerror(errno));
+        return false;
+    }
+    if (fp_)
+    {
+        ::fclose(fp_);
+    }
+    fp_ = fp;
+    ::setbuffer(fp_, buffer_, sizeof buffer_);
+
+    lastRoll_ = now;
+    startOfPeriod_ = now / rollInterval_ * rollInterval_;
+    writtenBytes_ = 0;
+    return true;
+}
+
+std::string LogFile::getLogFileName(const std::string &basename, time_t now)
+{
+    char buf[64] = {0};
+    struct tm tm_time;
+    ::localtime_r(&now, &tm_time);
+    size_t n = ::strftime(buf, sizeof buf, ".%Y%m%d-%H%M%S", &tm_time);
+    snprintf(buf + n, sizeof buf - n, ".%d.log", ::getpid());
+    return basename + buf;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <string>
+#include <stdio.h>
+#include <time.h>
+#include <sys/types.h>
+
+/**
+ * 滚动日志文件  只在AsyncLogging的后台线程中使用，不需要加锁
+ * 文件名为 basename.YYYYmmdd-HHMMSS.pid.log，写满rollSize字节或者跨过一个rollInterval周期时新建文件
+ */
+class LogFile : noncopyable
+{
+public:
+    static const int kDefaultRollInterval = 24 * 60 * 60; // 默认每天滚动一次
+
+    LogFile(const std::string &basename, off_t rollSize, int rollInterval = kDefaultRollInterval);
+    ~LogFile();
+
+    void append(const char *data, size_t len);
+    void flush();
+
+    // 新建一个日志文件，同一秒内不会重复滚动
+    bool rollFile();
+private:
+    static std::string getLogFileName(const std::string &basename, time_t now);
+
+    const std::string basename_;
+    const off_t rollSize_;
+    const int rollInterval_;
+
+    FILE *fp_;
+    off_t writtenBytes_;   // 当前文件已经写入的字节数
+    time_t startOfPeriod_; // 当前文件所在的滚动周期的起点
+    time_t lastRoll_;
+    char buffer_[64 * 1024]; // fp_的用户态缓冲区
+};
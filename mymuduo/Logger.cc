@@ -1,7 +1,54 @@
 #include "Logger.h"
 #include "Timestamp.h"
 
-#include <iostream>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+namespace
+{
+
+const char *const kLevelNames[] = {"[DEBUG]", "[INFO]", "[ERROR]", "[FATAL]"};
+
+// 同一秒内的日志复用格式化好的时间，避免每条日志都调用localtime_r
+thread_local time_t t_lastSecond = 0;
+thread_local char t_time[32];
+thread_local int t_timeLen = 0;
+
+int formatTime(char *buf)
+{
+    time_t seconds = static_cast<time_t>(
+        Timestamp::now().microSecondsSinceEpoch() / Timestamp::kMicroSecondsPerSecond);
+    if (seconds != t_lastSecond || t_timeLen == 0)
+    {
+        struct tm tm_time;
+        ::localtime_r(&seconds, &tm_time);
+        t_timeLen = snprintf(t_time, sizeof t_time, "%4d/%02d/%02d %02d:%02d:%02d",
+            tm_time.tm_year + 1900,
+            tm_time.tm_mon + 1,
+            tm_time.tm_mday,
+            tm_time.tm_hour,
+            tm_time.tm_min,
+            tm_time.tm_sec);
+        t_lastSecond = seconds;
+    }
+    ::memcpy(buf, t_time, t_timeLen);
+    return t_timeLen;
+}
+
+void defaultOutput(const char *msg, size_t len)
+{
+    ::fwrite(msg, 1, len, stdout);
+}
+
+void defaultFlush()
+{
+    ::fflush(stdout);
+}
+
+} // namespace
 
 // 获取日志唯一的实例对象
 Logger& Logger::instance()
@@ -10,33 +57,80 @@ Logger& Logger::instance()
     return logger;
 }
 
-// 设置日志级别
-void Logger::setLogLevel(int level)
+Logger::Logger()
+    : logLevel_(DEBUG) // 运行期默认不过滤，编译进来的日志都输出
+    , sink_(nullptr)
+{
+    std::unique_ptr<Sink> sink(new Sink);
+    sink->output = defaultOutput;
+    sink->flush = defaultFlush;
+    publish(std::move(sink));
+}
+
+void Logger::publish(std::unique_ptr<Sink> sink)
 {
-    logLevel_ = level;
+    sink_.store(sink.get(), std::memory_order_release);
+    sinks_.push_back(std::move(sink));
 }
 
-// 写日志  [级别信息] time : msg
-void Logger::log(std::string msg)
+void Logger::setOutput(OutputFunc output)
 {
-    switch (logLevel_)
+    std::lock_guard<std::mutex> lock(sinkMutex_);
+    std::unique_ptr<Sink> sink(new Sink(*sink_.load(std::memory_order_relaxed)));
+    sink->output = output ? std::move(output) : OutputFunc(defaultOutput);
+    publish(std::move(sink));
+}
+
+void Logger::setFlush(FlushFunc flush)
+{
+    std::lock_guard<std::mutex> lock(sinkMutex_);
+    std::unique_ptr<Sink> sink(new Sink(*sink_.load(std::memory_order_relaxed)));
+    sink->flush = flush ? std::move(flush) : FlushFunc(defaultFlush);
+    publish(std::move(sink));
+}
+
+void Logger::flush()
+{
+    sink_.load(std::memory_order_acquire)->flush();
+}
+
+// 写日志  [级别信息]time : msg
+void Logger::log(int level, const char *format, ...)
+{
+    char buf[1024];
+    const size_t kMaxLen = sizeof buf - 1; // 留一个字节给结尾的换行
+
+    size_t len = 0;
+    if (level >= DEBUG && level <= FATAL)
     {
-    case INFO:
-        std::cout << "[INFO]";
-        break;
-    case ERROR:
-        std::cout << "[ERROR]";
-        break;
-    case FATAL:
-        std::cout << "[FATAL]";
-        break;
-    case DEBUG:
-        std::cout << "[DEBUG]";
-        break;
-    default:
-        break;
+        size_t n = ::strlen(kLevelNames[level]);
+        ::memcpy(buf, kLevelNames[level], n);
+        len += n;
     }
+    len += formatTime(buf + len);
+    ::memcpy(buf + len, " : ", 3);
+    len += 3;
 
-    // 打印时间和msg
-    std::cout << Timestamp::now().toString() << " : " << msg << std::endl;
-}
\ No newline at end of file
+    va_list args;
+    va_start(args, format);
+    int n = ::vsnprintf(buf + len, kMaxLen - len, format, args);
+    va_end(args);
+    if (n > 0)
+    {
+        len += std::min(static_cast<size_t>(n), kMaxLen - len - 1); // 超长的日志被截断
+    }
+
+    // 调用者自己带了换行的话不再重复添加
+    while (len > 0 && buf[len - 1] == '\n')
+    {
+        --len;
+    }
+    buf[len++] = '\n';
+
+    const Sink *sink = sink_.load(std::memory_order_acquire);
+    sink->output(buf, len);
+    if (level == FATAL)
+    {
+        sink->flush();
+    }
+}
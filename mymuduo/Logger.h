@@ -1,74 +1,119 @@
 #pragma once
 
 #include <string>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <stdlib.h>
 
 #include "noncopyable.h"
 
-// LOG_INFO("%s %d", arg1, arg2)
-#define LOG_INFO(logmsgFormat, ...) \
-    do \
-    { \
-        Logger &logger = Logger::instance(); \
-        logger.setLogLevel(INFO); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
-    } while(0) 
+// 日志级别的数值，预处理器里面也要用到，所以用宏定义
+#define MUDUO_LOG_DEBUG 0
+#define MUDUO_LOG_INFO  1
+#define MUDUO_LOG_ERROR 2
+#define MUDUO_LOG_FATAL 3
 
-#define LOG_ERROR(logmsgFormat, ...) \
+/**
+ * 编译期的最低日志级别  低于这个级别的LOG_XXX语句整个被去掉，参数也不会被求值
+ * 可以通过 -DMUDUO_MIN_LOG_LEVEL=2 只保留ERROR和FATAL，默认定义了MUDEBUG时保留DEBUG
+ */
+#ifndef MUDUO_MIN_LOG_LEVEL
+#ifdef MUDEBUG
+#define MUDUO_MIN_LOG_LEVEL MUDUO_LOG_DEBUG
+#else
+#define MUDUO_MIN_LOG_LEVEL MUDUO_LOG_INFO
+#endif
+#endif
+
+// 运行期还会再和Logger::logLevel()比较一次，级别作为参数传给log，不再修改全局状态
+#define MUDUO_LOG_IMPL(level, logmsgFormat, ...) \
     do \
     { \
         Logger &logger = Logger::instance(); \
-        logger.setLogLevel(ERROR); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
-    } while(0) 
+        if (logger.logLevel() <= level) \
+        { \
+            logger.log(level, logmsgFormat, ##__VA_ARGS__); \
+        } \
+    } while(0)
 
+// LOG_INFO("%s %d", arg1, arg2)
+#if MUDUO_MIN_LOG_LEVEL <= MUDUO_LOG_INFO
+#define LOG_INFO(logmsgFormat, ...) MUDUO_LOG_IMPL(INFO, logmsgFormat, ##__VA_ARGS__)
+#else
+#define LOG_INFO(logmsgFormat, ...) do {} while(0)
+#endif
+
+#if MUDUO_MIN_LOG_LEVEL <= MUDUO_LOG_ERROR
+#define LOG_ERROR(logmsgFormat, ...) MUDUO_LOG_IMPL(ERROR, logmsgFormat, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(logmsgFormat, ...) do {} while(0)
+#endif
+
+// FATAL不受级别过滤，输出之后先把日志刷到文件再退出
 #define LOG_FATAL(logmsgFormat, ...) \
     do \
     { \
-        Logger &logger = Logger::instance(); \
-        logger.setLogLevel(FATAL); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
+        Logger::instance().log(FATAL, logmsgFormat, ##__VA_ARGS__); \
         exit(-1); \
-    } while(0) 
+    } while(0)
 
-#ifdef MUDEBUG
-#define LOG_DEBUG(logmsgFormat, ...) \
-    do \
-    { \
-        Logger &logger = Logger::instance(); \
-        logger.setLogLevel(DEBUG); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
-    } while(0) 
+#if MUDUO_MIN_LOG_LEVEL <= MUDUO_LOG_DEBUG
+#define LOG_DEBUG(logmsgFormat, ...) MUDUO_LOG_IMPL(DEBUG, logmsgFormat, ##__VA_ARGS__)
 #else
-    #define LOG_DEBUG(logmsgFormat, ...)
+#define LOG_DEBUG(logmsgFormat, ...) do {} while(0)
 #endif
 
-// 定义日志的级别  INFO  ERROR  FATAL  DEBUG 
+// 定义日志的级别  DEBUG  INFO  ERROR  FATAL  按严重程度从低到高排列
 enum LogLevel
 {
-    INFO,  // 普通信息
-    ERROR, // 错误信息
-    FATAL, // core信息
-    DEBUG, // 调试信息
+    DEBUG = MUDUO_LOG_DEBUG, // 调试信息
+    INFO = MUDUO_LOG_INFO,   // 普通信息
+    ERROR = MUDUO_LOG_ERROR, // 错误信息
+    FATAL = MUDUO_LOG_FATAL, // core信息
 };
 
-// 输出一个日志类
+/**
+ * 输出一个日志类  负责把一条日志格式化成 [级别信息]time : msg\n，然后交给输出函数
+ * 默认输出到stdout，AsyncLogging::start()之后输出到它的前端缓冲区，由后台线程写文件
+ */
 class Logger : noncopyable
 {
 public:
+    using OutputFunc = std::function<void(const char *msg, size_t len)>;
+    using FlushFunc = std::function<void()>;
+
     // 获取日志唯一的实例对象
     static Logger& instance();
-    // 设置日志级别
-    void setLogLevel(int level);
-    // 写日志
-    void log(std::string msg);
+
+    // 运行期的最低日志级别，可以在任意线程调用
+    void setLogLevel(int level) { logLevel_.store(level, std::memory_order_relaxed); }
+    int logLevel() const { return logLevel_.load(std::memory_order_relaxed); }
+
+    // 写日志  FATAL级别的日志写完之后会调用flush
+    void log(int level, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+    // 替换输出和刷新函数，可以在其它线程写日志的同时调用，传nullptr恢复默认的stdout
+    void setOutput(OutputFunc output);
+    void setFlush(FlushFunc flush);
+    void flush();
 private:
-    int logLevel_;
-};
\ No newline at end of file
+    // 输出和刷新函数放在一起，整体通过原子指针发布，写日志的线程不用加锁
+    struct Sink
+    {
+        OutputFunc output;
+        FlushFunc flush;
+    };
+
+    Logger();
+    void publish(std::unique_ptr<Sink> sink);
+
+    std::atomic_int logLevel_;
+    std::atomic<const Sink*> sink_;
+
+    // 替换下来的Sink可能还有线程在使用，不释放，只在设置的时候加锁
+    std::mutex sinkMutex_;
+    std::vector<std::unique_ptr<Sink>> sinks_;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * 每个EventLoop的负载计数  EventLoopThreadPool给新连接选择subloop时读取
+ * 所有字段都是原子变量，其它线程可以不加锁地读取
+ * pendingBytes和pollLatency只在loop线程中写，用load + store代替原子加减，省掉lock前缀
+ */
+class LoopLoad : noncopyable
+{
+public:
+    // 其它线程读取的时候拿到的一份拷贝
+    struct Snapshot
+    {
+        int64_t connections;   // 当前连接数
+        int64_t pendingBytes;  // 所有连接发送缓冲区中还没有发送出去的字节数
+        int64_t pollLatencyUs; // 每轮poll返回后处理事件和回调的耗时，指数平均，单位微秒
+        int64_t iterations;    // loop循环的次数
+    };
+
+    LoopLoad()
+        : connections_(0)
+        , pendingBytes_(0)
+        , pollLatencyUs_(0)
+    {}
+
+    // 连接在mainLoop中创建，在subloop中销毁，所以这两个用原子加减
+    void connectionAdded() { connections_.fetch_add(1, std::memory_order_relaxed); }
+    void connectionRemoved() { connections_.fetch_sub(1, std::memory_order_relaxed); }
+
+    // 只能在loop线程中调用
+    void addPendingBytes(int64_t delta)
+    {
+        pendingBytes_.store(pendingBytes_.load(std::memory_order_relaxed) + delta,
+                            std::memory_order_relaxed);
+    }
+
+    // 只能在loop线程中调用  新样本占1/8的权重
+    void recordPollLatency(int64_t us)
+    {
+        int64_t avg = pollLatencyUs_.load(std::memory_order_relaxed);
+        pollLatencyUs_.store(avg + (us - avg) / 8, std::memory_order_relaxed);
+    }
+
+    int64_t connections() const { return connections_.load(std::memory_order_relaxed); }
+    int64_t pendingBytes() const { return pendingBytes_.load(std::memory_order_relaxed); }
+    int64_t pollLatencyUs() const { return pollLatencyUs_.load(std::memory_order_relaxed); }
+private:
+    std::atomic<int64_t> connections_;
+    std::atomic<int64_t> pendingBytes_;
+    std::atomic<int64_t> pollLatencyUs_;
+};
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * 运行时统计  EventLoop和TcpConnection各持有一份，只在所属的loop线程中更新，
+ * 其它线程随时可以调用snapshot()不加锁地读取
+ * 单写者，所以更新用load + store代替原子加减，省掉lock前缀，热路径上只有几次普通的内存读写
+ * 快照中的各个字段是分别读取的，相互之间不保证是同一时刻的值
+ */
+
+namespace metrics
+{
+
+// 单调时钟，单位微秒
+inline int64_t nowMicros()
+{
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 * 1000 + ts.tv_nsec / 1000;
+}
+
+// 只能由唯一的写线程调用
+inline void add(std::atomic<uint64_t> &counter, uint64_t delta)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+inline void updateMax(std::atomic<uint64_t> &counter, uint64_t value)
+{
+    if (value > counter.load(std::memory_order_relaxed))
+    {
+        counter.store(value, std::memory_order_relaxed);
+    }
+}
+
+} // namespace metrics
+
+/**
+ * 以2为底的对数分桶直方图  第0个桶是0，第i个桶是[2^(i-1), 2^i)，最后一个桶收集所有更大的值
+ * 微秒为单位时最后一个桶从2^30us(约18分钟)开始，足够覆盖poll的等待时间
+ */
+class Histogram : noncopyable
+{
+public:
+    static const int kBuckets = 32;
+
+    struct Snapshot
+    {
+        uint64_t count;
+        uint64_t sum;
+        uint64_t max;
+        uint64_t buckets[kBuckets];
+
+        double mean() const { return count ? static_cast<double>(sum) / count : 0.0; }
+        // 第p(0~100)百分位所在桶的上界，不超过max
+        uint64_t percentile(double p) const
+        {
+            uint64_t rank = static_cast<uint64_t>(count * p / 100.0);
+            uint64_t seen = 0;
+            for (int i = 0; i < kBuckets; ++i)
+            {
+                seen += buckets[i];
+                if (seen > rank)
+                {
+                    uint64_t upper = i == 0 ? 0 : (1ULL << i) - 1;
+                    return upper < max ? upper : max;
+                }
+            }
+            return max;
+        }
+    };
+
+    Histogram()
+        : count_(0)
+        , sum_(0)
+        , max_(0)
+    {
+        for (int i = 0; i < kBuckets; ++i)
+        {
+            buckets_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // 只能由唯一的写线程调用
+    void record(uint64_t value)
+    {
+        int bucket = value == 0 ? 0 : 64 - __builtin_clzll(value);
+        if (bucket >= kBuckets)
+        {
+            bucket = kBuckets - 1;
+        }
+        metrics::add(buckets_[bucket], 1);
+        metrics::add(count_, 1);
+        metrics::add(sum_, value);
+        metrics::updateMax(max_, value);
+    }
+
+    // 可以在任意线程调用
+    void snapshot(Snapshot *result) const
+    {
+        result->count = count_.load(std::memory_order_relaxed);
+        result->sum = sum_.load(std::memory_order_relaxed);
+        result->max = max_.load(std::memory_order_relaxed);
+        for (int i = 0; i < kBuckets; ++i)
+        {
+            result->buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        }
+    }
+private:
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+    std::atomic<uint64_t> buckets_[kBuckets];
+};
+
+/**
+ * EventLoop的运行统计，由EventLoop::loop()更新
+ */
+class LoopMetrics : noncopyable
+{
+public:
+    struct Snapshot
+    {
+        Histogram::Snapshot pollWaitUs;      // 阻塞在poll里面的时间
+        Histogram::Snapshot activeChannels;  // 每轮poll返回的活跃channel数
+        Histogram::Snapshot pendingFunctors; // 每轮执行的其它线程投递过来的回调个数，也就是回调队列的积压
+        Histogram::Snapshot callbackUs;      // 每个channel的事件处理耗时，以及每轮回调队列的总耗时
+        int slowestCallbackFd;               // 最慢的一次事件处理所属的fd，回调队列为-1
+    };
+
+    LoopMetrics()
+        : callbackMaxUs_(0)
+        , slowestCallbackFd_(-1)
+    {}
+
+    // 以下只能在loop线程中调用
+    void recordPoll(uint64_t waitUs, uint64_t activeChannels)
+    {
+        pollWaitUs_.record(waitUs);
+        activeChannels_.record(activeChannels);
+    }
+
+    void recordCallback(int fd, uint64_t us)
+    {
+        if (us > callbackMaxUs_)
+        {
+            callbackMaxUs_ = us;
+            slowestCallbackFd_.store(fd, std::memory_order_relaxed);
+        }
+        callbackUs_.record(us);
+    }
+
+    void recordFunctors(uint64_t count, uint64_t us)
+    {
+        pendingFunctors_.record(count);
+        if (count > 0)
+        {
+            recordCallback(-1, us);
+        }
+    }
+
+    // 可以在任意线程调用
+    Snapshot snapshot() const
+    {
+        Snapshot result;
+        pollWaitUs_.snapshot(&result.pollWaitUs);
+        activeChannels_.snapshot(&result.activeChannels);
+        pendingFunctors_.snapshot(&result.pendingFunctors);
+        callbackUs_.snapshot(&result.callbackUs);
+        result.slowestCallbackFd = slowestCallbackFd_.load(std::memory_order_relaxed);
+        return result;
+    }
+private:
+    Histogram pollWaitUs_;
+    Histogram activeChannels_;
+    Histogram pendingFunctors_;
+    Histogram callbackUs_;
+    uint64_t callbackMaxUs_; // 只在loop线程中读写
+    std::atomic<int> slowestCallbackFd_;
+};
+
+/**
+ * TcpConnection的收发统计，在连接所属的loop线程中更新
+ */
+class ConnectionMetrics : noncopyable
+{
+public:
+    struct Snapshot
+    {
+        uint64_t bytesReceived;
+        uint64_t bytesSent;
+        uint64_t messagesReceived; // messageCallback被调用的次数
+        uint64_t messagesSent;     // send/sendFile/sendZeroCopy在loop线程中被处理的次数
+        uint64_t outputPeakBytes;  // 发送缓冲区(不含文件块)的最大积压
+    };
+
+    ConnectionMetrics()
+        : bytesReceived_(0)
+        , bytesSent_(0)
+        , messagesReceived_(0)
+        , messagesSent_(0)
+        , outputPeakBytes_(0)
+    {}
+
+    // 以下只能在loop线程中调用
+    void addBytesReceived(uint64_t n) { metrics::add(bytesReceived_, n); }
+    void addBytesSent(uint64_t n) { metrics::add(bytesSent_, n); }
+    void messageReceived() { metrics::add(messagesReceived_, 1); }
+    void messageSent() { metrics::add(messagesSent_, 1); }
+    void updateOutputPeak(uint64_t bytes) { metrics::updateMax(outputPeakBytes_, bytes); }
+
+    // 可以在任意线程调用
+    Snapshot snapshot() const
+    {
+        Snapshot result;
+        result.bytesReceived = bytesReceived_.load(std::memory_order_relaxed);
+        result.bytesSent = bytesSent_.load(std::memory_order_relaxed);
+        result.messagesReceived = messagesReceived_.load(std::memory_order_relaxed);
+        result.messagesSent = messagesSent_.load(std::memory_order_relaxed);
+        result.outputPeakBytes = outputPeakBytes_.load(std::memory_order_relaxed);
+        return result;
+    }
+private:
+    std::atomic<uint64_t> bytesReceived_;
+    std::atomic<uint64_t> bytesSent_;
+    std::atomic<uint64_t> messagesReceived_;
+    std::atomic<uint64_t> messagesSent_;
+    std::atomic<uint64_t> outputPeakBytes_;
+};
@@ -0,0 +1,153 @@
+#include "Relay.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "Buffer.h"
+
+#include <atomic>
+#include <memory>
+
+namespace
+{
+
+/**
+ * 一个方向from -> to的转发状态
+ * forwarded只在from的loop线程中读写；to已经写出的字节数从to->metrics()中读取
+ * paused由from的loop线程写，to的loop线程读取，用来决定是否需要通知from恢复读取
+ */
+struct RelayDirection
+{
+    std::weak_ptr<TcpConnection> from;
+    std::weak_ptr<TcpConnection> to;
+    size_t maxBufferedBytes;
+    uint64_t forwarded; // 转发给to的字节数
+    uint64_t sentBase;  // relay开始时to已经写出的字节数
+    std::atomic_bool paused;
+};
+
+using DirectionPtr = std::shared_ptr<RelayDirection>;
+
+// 已经转发、但to还没有写进内核的字节数
+size_t bufferedBytes(const RelayDirection &dir, const TcpConnectionPtr &to)
+{
+    uint64_t sent = to->metrics().bytesSent - dir.sentBase;
+    return dir.forwarded > sent ? dir.forwarded - sent : 0;
+}
+
+// 在from的loop线程中执行
+void checkResume(const DirectionPtr &dir)
+{
+    TcpConnectionPtr from = dir->from.lock();
+    if (!from || !dir->paused)
+    {
+        return;
+    }
+    TcpConnectionPtr to = dir->to.lock();
+    if (!to || !to->connected() || bufferedBytes(*dir, to) <= dir->maxBufferedBytes / 2)
+    {
+        dir->paused = false;
+        from->startRead();
+    }
+}
+
+// from的messageCallback
+void onRelayMessage(const DirectionPtr &dir, const TcpConnectionPtr &from, Buffer *buf)
+{
+    TcpConnectionPtr to = dir->to.lock();
+    if (!to || !to->connected())
+    {
+        buf->retrieveAll(); // 对端已经断开
+        return;
+    }
+
+    dir->forwarded += buf->readableBytes();
+    to->send(buf);
+    if (!dir->paused && bufferedBytes(*dir, to) >= dir->maxBufferedBytes)
+    {
+        from->stopRead();
+        dir->paused = true;
+        // 和onDrained配对：to可能在paused置位之前就已经写完了数据，这里再检查一次
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        checkResume(dir);
+    }
+}
+
+// to的writeCompleteCallback和lowWaterMarkCallback，在to的loop线程中执行
+void onDrained(const DirectionPtr &dir)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!dir->paused.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    if (TcpConnectionPtr from = dir->from.lock())
+    {
+        from->getLoop()->runInLoop(std::bind(checkResume, dir));
+    }
+}
+
+// 在conn的loop线程中执行  out是conn -> peer方向，in是peer -> conn方向
+void installInLoop(const TcpConnectionPtr &conn, const DirectionPtr &out, const DirectionPtr &in)
+{
+    TcpConnectionPtr peer = out->to.lock();
+    ConnectionCallback userCallback = conn->connectionCallback();
+    conn->setConnectionCallback([userCallback, out, in](const TcpConnectionPtr &c) {
+        if (userCallback)
+        {
+            userCallback(c);
+        }
+        if (!c->connected())
+        {
+            if (TcpConnectionPtr other = out->to.lock())
+            {
+                other->shutdown();
+                // 对端可能因为这一端积压太多被暂停了读取，恢复之后才能发现它断开，之后的数据直接丢弃
+                other->getLoop()->runInLoop(std::bind(checkResume, in));
+            }
+        }
+    });
+    conn->setMessageCallback([out](const TcpConnectionPtr &c, Buffer *buf, Timestamp) {
+        onRelayMessage(out, c, buf);
+    });
+    conn->setWriteCompleteCallback([in](const TcpConnectionPtr&) {
+        onDrained(in);
+    });
+    conn->setLowWaterMarkCallback([in](const TcpConnectionPtr&, size_t) {
+        onDrained(in);
+    }, in->maxBufferedBytes / 2);
+
+    if (!conn->connected())
+    {
+        if (peer)
+        {
+            peer->shutdown();
+        }
+        return;
+    }
+    // relay之前已经收到的数据
+    if (conn->inputBuffer()->readableBytes() > 0)
+    {
+        onRelayMessage(out, conn, conn->inputBuffer());
+    }
+}
+
+DirectionPtr makeDirection(const TcpConnectionPtr &from, const TcpConnectionPtr &to, size_t maxBufferedBytes)
+{
+    DirectionPtr dir = std::make_shared<RelayDirection>();
+    dir->from = from;
+    dir->to = to;
+    dir->maxBufferedBytes = maxBufferedBytes;
+    dir->forwarded = 0;
+    dir->sentBase = to->metrics().bytesSent;
+    dir->paused = false;
+    return dir;
+}
+
+} // namespace
+
+void relay(const TcpConnectionPtr &connA, const TcpConnectionPtr &connB, size_t maxBufferedBytes)
+{
+    DirectionPtr aToB = makeDirection(connA, connB, maxBufferedBytes);
+    DirectionPtr bToA = makeDirection(connB, connA, maxBufferedBytes);
+    connA->getLoop()->runInLoop(std::bind(installInLoop, connA, aToB, bToA));
+    connB->getLoop()->runInLoop(std::bind(installInLoop, connB, bToA, aToB));
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Callbacks.h"
+
+#include <stddef.h>
+
+// relay默认的每个方向最多积压的字节数
+const size_t kDefaultRelayBufferBytes = 1024 * 1024; // 1M
+
+/**
+ * 把两个连接对接起来，一端收到的数据原样转发给另一端  两个连接可以属于不同的loop，可以在任意线程调用
+ *
+ * 流控：每个方向上已经转发、但对端还没有写进内核的字节数达到maxBufferedBytes时，对数据来源stopRead，
+ * 降到maxBufferedBytes / 2以下时再startRead，每对连接最多积压 2 * maxBufferedBytes 字节，
+ * 慢的一端会通过TCP窗口把压力传回快的一端，而不是让发送缓冲区无限增长
+ * 检查发生在每次转发之后，所以最多再超出一次读取的数据量(LT模式64K，ET模式ioBudget)
+ *
+ * 一端断开之后shutdown另一端(发送完已经转发的数据再关闭写方向)，另一端之后收到的数据直接丢弃
+ *
+ * 会替换两个连接的messageCallback、writeCompleteCallback和lowWaterMarkCallback，
+ * connectionCallback会被包装，原来的回调仍然会执行
+ */
+void relay(const TcpConnectionPtr &connA,
+           const TcpConnectionPtr &connB,
+           size_t maxBufferedBytes = kDefaultRelayBufferBytes);
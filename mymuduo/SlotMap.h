@@ -0,0 +1,139 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+/**
+ * 以整数id为键的对象表  插入时分配id，查找和删除都是下标访问，O(1)且没有字符串哈希和内存分配
+ * id = (generation << 24) | index，共48位；槽位被删除后generation加一，旧的id不会再匹配到新对象
+ * 空闲槽位通过下标串成链表复用
+ *
+ * 不是线程安全的，只能在所属的线程中使用(TcpServer里面每个loop一个，只在该loop线程中访问)
+ */
+template <typename T>
+class SlotMap : noncopyable
+{
+public:
+    using Id = uint64_t;
+
+    static const int kIndexBits = 24;
+    static const int kGenerationBits = 24;
+    static const int kIdBits = kIndexBits + kGenerationBits;
+    static const Id kInvalidId = 0; // generation从1开始，有效的id不会是0
+
+    SlotMap() : freeHead_(kNoFree), size_(0) {}
+
+    Id insert(T value)
+    {
+        uint32_t index;
+        if (freeHead_ != kNoFree)
+        {
+            index = freeHead_;
+            freeHead_ = slots_[index].nextFree;
+        }
+        else
+        {
+            index = static_cast<uint32_t>(slots_.size());
+            slots_.push_back(Slot());
+        }
+
+        Slot &slot = slots_[index];
+        slot.value = std::move(value);
+        slot.used = true;
+        ++size_;
+        return makeId(index, slot.generation);
+    }
+
+    // 返回nullptr表示id已经失效
+    T* find(Id id)
+    {
+        uint32_t index = indexOf(id);
+        if (index >= slots_.size())
+        {
+            return nullptr;
+        }
+        Slot &slot = slots_[index];
+        return slot.used && slot.generation == generationOf(id) ? &slot.value : nullptr;
+    }
+
+    bool erase(Id id)
+    {
+        T *value = find(id);
+        if (value == nullptr)
+        {
+            return false;
+        }
+        release(indexOf(id));
+        return true;
+    }
+
+    // 依次访问所有对象 f(id, T&)
+    template <typename F>
+    void forEach(F f)
+    {
+        for (uint32_t i = 0; i < slots_.size(); ++i)
+        {
+            if (slots_[i].used)
+            {
+                f(makeId(i, slots_[i].generation), slots_[i].value);
+            }
+        }
+    }
+
+    void clear()
+    {
+        for (uint32_t i = 0; i < slots_.size(); ++i)
+        {
+            if (slots_[i].used)
+            {
+                release(i);
+            }
+        }
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+private:
+    static const uint32_t kNoFree = UINT32_MAX;
+    static const uint32_t kIndexMask = (1U << kIndexBits) - 1;
+    static const uint32_t kGenerationMask = (1U << kGenerationBits) - 1;
+
+    struct Slot
+    {
+        Slot() : value(), generation(1), nextFree(kNoFree), used(false) {}
+
+        T value;
+        uint32_t generation;
+        uint32_t nextFree;
+        bool used;
+    };
+
+    static Id makeId(uint32_t index, uint32_t generation)
+    {
+        return (static_cast<Id>(generation) << kIndexBits) | index;
+    }
+    static uint32_t indexOf(Id id) { return static_cast<uint32_t>(id & kIndexMask); }
+    static uint32_t generationOf(Id id) { return static_cast<uint32_t>((id >> kIndexBits) & kGenerationMask); }
+
+    void release(uint32_t index)
+    {
+        Slot &slot = slots_[index];
+        slot.value = T(); // 释放对象持有的资源，比如TcpConnectionPtr
+        slot.used = false;
+        slot.generation = (slot.generation + 1) & kGenerationMask;
+        if (slot.generation == 0)
+        {
+            slot.generation = 1;
+        }
+        slot.nextFree = freeHead_;
+        freeHead_ = index;
+        --size_;
+    }
+
+    std::vector<Slot> slots_;
+    uint32_t freeHead_;
+    size_t size_;
+};
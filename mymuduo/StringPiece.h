@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <string.h>
+#include <strings.h>
+
+/**
+ * 指向一段外部内存的只读字符串视图  C++11里面没有std::string_view，这里实现需要的部分
+ * 不持有内存，使用者要保证底层数据在StringPiece使用期间有效
+ */
+class StringPiece
+{
+public:
+    StringPiece() : data_(nullptr), size_(0) {}
+    StringPiece(const char *str) : data_(str), size_(str ? ::strlen(str) : 0) {}
+    StringPiece(const char *data, size_t size) : data_(data), size_(size) {}
+    StringPiece(const std::string &str) : data_(str.data()), size_(str.size()) {}
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const char* begin() const { return data_; }
+    const char* end() const { return data_ + size_; }
+
+    char operator[](size_t i) const { return data_[i]; }
+
+    void removePrefix(size_t n) { data_ += n; size_ -= n; }
+    void removeSuffix(size_t n) { size_ -= n; }
+
+    bool startsWith(const StringPiece &x) const
+    {
+        return size_ >= x.size_ && ::memcmp(data_, x.data_, x.size_) == 0;
+    }
+
+    // 忽略大小写比较，用于HTTP头部名字这类大小写不敏感的字段
+    bool equalsIgnoreCase(const StringPiece &x) const
+    {
+        return size_ == x.size_ && ::strncasecmp(data_, x.data_, size_) == 0;
+    }
+
+    std::string toString() const { return std::string(data_, size_); }
+
+    bool operator==(const StringPiece &x) const
+    {
+        return size_ == x.size_ && ::memcmp(data_, x.data_, size_) == 0;
+    }
+    bool operator!=(const StringPiece &x) const { return !(*this == x); }
+private:
+    const char *data_;
+    size_t size_;
+};
@@ -10,7 +10,12 @@
 #include <sys/socket.h>
 #include <strings.h>
 #include <netinet/tcp.h>
+#include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/errqueue.h>
 #include <string>
 
 static EventLoop* CheckLoopNotNull(EventLoop *loop)
@@ -22,13 +27,31 @@ static EventLoop* CheckLoopNotNull(EventLoop *loop)
     return loop;
 }
 
+// 单次sendfile最多传输的字节数(内核的限制)
+static const size_t kMaxSendfileBytes = 0x7ffff000;
+
 TcpConnection::TcpConnection(EventLoop *loop, 
                 const std::string &nameArg, 
                 int sockfd,
                 const InetAddress& localAddr,
-                const InetAddress& peerAddr)
+                const InetAddress& peerAddr,
+                Buffer::Mode inputBufferMode)
+    : TcpConnection(loop, std::make_shared<const std::string>(nameArg), 0,
+                    sockfd, localAddr, peerAddr, inputBufferMode)
+{
+}
+
+TcpConnection::TcpConnection(EventLoop *loop, 
+                std::shared_ptr<const std::string> namePrefix,
+                uint64_t sequence,
+                int sockfd,
+                const InetAddress& localAddr,
+                const InetAddress& peerAddr,
+                Buffer::Mode inputBufferMode)
     : loop_(CheckLoopNotNull(loop))
-    , name_(nameArg)
+    , namePrefix_(std::move(namePrefix))
+    , sequence_(sequence)
+    , id_(0)
     , state_(kConnecting)
     , reading_(true)
     , socket_(new Socket(sockfd))
@@ -36,6 +59,19 @@ TcpConnection::TcpConnection(EventLoop *loop,
     , localAddr_(localAddr)
     , peerAddr_(peerAddr)
     , highWaterMark_(64*1024*1024) // 64M
+    , lowWaterMark_(0)
+    , aboveLowWaterMark_(false)
+    , edgeTriggered_(false)
+    , ioBudget_(kDefaultIoBudget)
+    , inputBuffer_(inputBufferMode)
+    , outputBuffer_(Buffer::kChained)
+    , bufferAppended_(0)
+    , bufferWritten_(0)
+    , segmentBytes_(0)
+    , segmentMemoryBytes_(0)
+    , zeroCopyEnabled_(false)
+    , zeroCopyDisabled_(false)
+    , zeroCopyNextId_(0)
 {
     // 下面给channel设置相应的回调函数，poller给channel通知感兴趣的事件发生了，channel会回调相应的操作函数
     channel_->setReadCallback(
@@ -51,15 +87,38 @@ TcpConnection::TcpConnection(EventLoop *loop,
         std::bind(&TcpConnection::handleError, this)
     );
 
-    LOG_INFO("TcpConnection::ctor[%s] at fd=%d\n", name_.c_str(), sockfd);
+    LOG_INFO("TcpConnection::ctor[%s] at fd=%d\n", name().c_str(), sockfd);
     socket_->setKeepAlive(true);
+
+    // 构造的时候(mainLoop中)就计入subloop的连接数，突发的新连接才不会全部分配到同一个subloop
+    loop_->load().connectionAdded();
 }
 
 
 TcpConnection::~TcpConnection()
 {
     LOG_INFO("TcpConnection::dtor[%s] at fd=%d state=%d \n", 
-        name_.c_str(), channel_->fd(), (int)state_);
+        name().c_str(), channel_->fd(), (int)state_);
+
+    for (const OutputSegment &segment : segments_)
+    {
+        if (segment.fd >= 0)
+        {
+            ::close(segment.fd);
+        }
+    }
+}
+
+const std::string& TcpConnection::name() const
+{
+    if (sequence_ == 0)
+    {
+        return *namePrefix_;
+    }
+    std::call_once(nameOnce_, [this]() {
+        name_ = *namePrefix_ + std::to_string(sequence_);
+    });
+    return name_;
 }
 
 void TcpConnection::send(const std::string &buf)
@@ -72,16 +131,37 @@ void TcpConnection::send(const std::string &buf)
         }
         else
         {
+            // 跨线程发送要把数据拷贝一份，回调执行的时候调用者的buf可能已经析构了
             loop_->runInLoop(std::bind(
-                &TcpConnection::sendInLoop,
-                this,
-                buf.c_str(),
-                buf.size()
+                &TcpConnection::sendStringInLoop,
+                shared_from_this(),
+                buf
             ));
         }
     }
 }
 
+void TcpConnection::sendStringInLoop(const std::string &message)
+{
+    sendInLoop(message.data(), message.size());
+}
+
+void TcpConnection::send(Buffer *buf)
+{
+    if (state_ == kConnected)
+    {
+        if (loop_->isInLoopThread())
+        {
+            sendInLoop(buf->peek(), buf->readableBytes());
+            buf->retrieveAll();
+        }
+        else
+        {
+            send(buf->retrieveAllAsString());
+        }
+    }
+}
+
 /**
  * 发送数据  应用写的快， 而内核发送数据慢， 需要把待发送数据写入缓冲区， 而且设置了水位回调
  */ 
@@ -97,13 +177,15 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
         LOG_ERROR("disconnected, give up writing!");
         return;
     }
+    metrics_.messageSent();
 
     // 表示channel_第一次开始写数据，而且缓冲区没有待发送数据
-    if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
+    if (!channel_->isWriting() && outputBytes() == 0)
     {
         nwrote = ::write(channel_->fd(), data, len);
         if (nwrote >= 0)
         {
+            metrics_.addBytesSent(nwrote);
             remaining = len - nwrote;
             if (remaining == 0 && writeCompleteCallback_)
             {
@@ -133,7 +215,7 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
     if (!faultError && remaining > 0) 
     {
         // 目前发送缓冲区剩余的待发送数据的长度
-        size_t oldLen = outputBuffer_.readableBytes();
+        size_t oldLen = outputMemoryBytes();
         if (oldLen + remaining >= highWaterMark_
             && oldLen < highWaterMark_
             && highWaterMarkCallback_)
@@ -143,6 +225,10 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
             );
         }
         outputBuffer_.append((char*)data + nwrote, remaining);
+        bufferAppended_ += remaining;
+        loop_->load().addPendingBytes(remaining);
+        metrics_.updateOutputPeak(outputMemoryBytes());
+        aboveLowWaterMark_ = outputMemoryBytes() > lowWaterMark_;
         if (!channel_->isWriting())
         {
             channel_->enableWriting(); // 这里一定要注册channel的写事件，否则poller不会给channel通知epollout
@@ -150,6 +236,334 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
     }
 }
 
+void TcpConnection::sendFile(int fd, off_t offset, size_t len)
+{
+    if (state_ == kConnected && len > 0)
+    {
+        // 发送是异步的，dup一份fd，调用者可以马上关闭自己的fd
+        int dupfd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (dupfd < 0)
+        {
+            LOG_ERROR("TcpConnection::sendFile dup fd=%d errno=%d \n", fd, errno);
+            return;
+        }
+
+        if (loop_->isInLoopThread())
+        {
+            sendFileInLoop(dupfd, offset, len);
+        }
+        else
+        {
+            loop_->runInLoop(std::bind(
+                &TcpConnection::sendFileInLoop,
+                shared_from_this(),
+                dupfd,
+                offset,
+                len
+            ));
+        }
+    }
+}
+
+void TcpConnection::sendFileInLoop(int fd, off_t offset, size_t len)
+{
+    if (state_ == kDisconnected)
+    {
+        ::close(fd);
+        LOG_ERROR("disconnected, give up writing!");
+        return;
+    }
+
+    OutputSegment segment;
+    segment.bufferPos = bufferAppended_;
+    segment.fd = fd;
+    segment.offset = offset;
+    segment.remaining = len;
+    segment.blockOffset = 0;
+    queueSegment(std::move(segment));
+}
+
+void TcpConnection::sendZeroCopy(const std::shared_ptr<const std::string> &block)
+{
+    if (state_ == kConnected && block && !block->empty())
+    {
+        if (loop_->isInLoopThread())
+        {
+            sendZeroCopyInLoop(block);
+        }
+        else
+        {
+            loop_->runInLoop(std::bind(
+                &TcpConnection::sendZeroCopyInLoop,
+                shared_from_this(),
+                block
+            ));
+        }
+    }
+}
+
+void TcpConnection::sendZeroCopyInLoop(const std::shared_ptr<const std::string> &block)
+{
+    if (state_ == kDisconnected)
+    {
+        LOG_ERROR("disconnected, give up writing!");
+        return;
+    }
+
+    OutputSegment segment;
+    segment.bufferPos = bufferAppended_;
+    segment.fd = -1;
+    segment.offset = 0;
+    segment.remaining = block->size();
+    segment.block = block;
+    segment.blockOffset = 0;
+    queueSegment(std::move(segment));
+}
+
+void TcpConnection::queueSegment(OutputSegment segment)
+{
+    size_t len = segment.remaining;
+    if (segment.fd < 0)
+    {
+        size_t oldLen = outputMemoryBytes();
+        if (oldLen + len >= highWaterMark_
+            && oldLen < highWaterMark_
+            && highWaterMarkCallback_)
+        {
+            loop_->queueInLoop(
+                std::bind(highWaterMarkCallback_, shared_from_this(), oldLen+len)
+            );
+        }
+        segmentMemoryBytes_ += len;
+    }
+    segmentBytes_ += len;
+    segments_.push_back(std::move(segment));
+    loop_->load().addPendingBytes(len);
+    metrics_.messageSent();
+    metrics_.updateOutputPeak(outputMemoryBytes());
+    aboveLowWaterMark_ = outputMemoryBytes() > lowWaterMark_;
+
+    if (channel_->isWriting())
+    {
+        return; // 前面还有数据在等epollout，排在它们后面
+    }
+
+    // 前面没有待发送的数据，先直接发送，发不完的再注册epollout
+    int savedErrno = 0;
+    size_t total = 0;
+    ssize_t n = 0;
+    while (outputBytes() > 0 && total < ioBudget_)
+    {
+        n = writeOnce(&savedErrno);
+        if (n <= 0)
+        {
+            break;
+        }
+        total += n;
+    }
+    checkLowWaterMark();
+
+    if (outputBytes() == 0)
+    {
+        if (writeCompleteCallback_)
+        {
+            loop_->queueInLoop(
+                std::bind(writeCompleteCallback_, shared_from_this())
+            );
+        }
+    }
+    else if (n < 0 && savedErrno != EWOULDBLOCK && savedErrno != EAGAIN)
+    {
+        LOG_ERROR("TcpConnection::queueSegment");
+        if (savedErrno != EPIPE && savedErrno != ECONNRESET)
+        {
+            channel_->enableWriting();
+        }
+    }
+    else
+    {
+        channel_->enableWriting();
+    }
+}
+
+void TcpConnection::popSegment()
+{
+    const OutputSegment &segment = segments_.front();
+    if (segment.fd >= 0)
+    {
+        ::close(segment.fd);
+    }
+    segments_.pop_front();
+}
+
+ssize_t TcpConnection::writeOnce(int *savedErrno)
+{
+    if (outputBytes() == 0)
+    {
+        return 0;
+    }
+    if (!segments_.empty() && segments_.front().bufferPos == bufferWritten_)
+    {
+        return writeSegment(segments_.front(), savedErrno);
+    }
+
+    // 只写到下一个块之前的位置
+    size_t limit = segments_.empty() ? outputBuffer_.readableBytes()
+                                     : segments_.front().bufferPos - bufferWritten_;
+    ssize_t n = outputBuffer_.writeFd(channel_->fd(), savedErrno, limit);
+    if (n > 0)
+    {
+        outputBuffer_.retrieve(n);
+        bufferWritten_ += n;
+        loop_->load().addPendingBytes(-n);
+        metrics_.addBytesSent(n);
+    }
+    return n;
+}
+
+ssize_t TcpConnection::writeSegment(OutputSegment &segment, int *savedErrno)
+{
+    ssize_t n = 0;
+    if (segment.fd >= 0)
+    {
+        n = ::sendfile(channel_->fd(), segment.fd, &segment.offset,
+                       std::min(segment.remaining, kMaxSendfileBytes));
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK
+                       && errno != EPIPE && errno != ECONNRESET))
+        {
+            // 文件在发送过程中被截断了，或者fd不支持sendfile，剩下的部分已经发不出去
+            LOG_ERROR("TcpConnection::sendFile name:%s - errno:%d, %lu bytes dropped \n",
+                name().c_str(), n == 0 ? 0 : errno, segment.remaining);
+            segmentBytes_ -= segment.remaining;
+            loop_->load().addPendingBytes(-static_cast<int64_t>(segment.remaining));
+            popSegment();
+            return writeOnce(savedErrno);
+        }
+    }
+    else
+    {
+        bool zeroCopy = false;
+        if (segment.block->size() >= kZeroCopyThreshold && !zeroCopyDisabled_)
+        {
+            if (!zeroCopyEnabled_)
+            {
+                int on = 1;
+                zeroCopyEnabled_ = ::setsockopt(channel_->fd(), SOL_SOCKET, SO_ZEROCOPY, &on, sizeof on) == 0;
+                zeroCopyDisabled_ = !zeroCopyEnabled_; // 内核不支持
+            }
+            zeroCopy = zeroCopyEnabled_;
+        }
+
+        const char *data = segment.block->data() + segment.blockOffset;
+        n = ::send(channel_->fd(), data, segment.remaining, zeroCopy ? MSG_ZEROCOPY : 0);
+        if (n < 0 && zeroCopy && errno == ENOBUFS)
+        {
+            // 超过了锁定内存的限制，这一次退化成普通send
+            zeroCopy = false;
+            n = ::send(channel_->fd(), data, segment.remaining, 0);
+        }
+
+        if (n > 0)
+        {
+            segment.blockOffset += n;
+            segmentMemoryBytes_ -= n;
+            if (zeroCopy)
+            {
+                // 内核按顺序给每次成功的MSG_ZEROCOPY send分配一个序号，完成通知里面带的是序号区间
+                uint32_t id = zeroCopyNextId_++;
+                if (!zeroCopyPending_.empty()
+                    && zeroCopyPending_.back().block == segment.block
+                    && zeroCopyPending_.back().lastId + 1 == id)
+                {
+                    zeroCopyPending_.back().lastId = id;
+                    ++zeroCopyPending_.back().outstanding;
+                }
+                else
+                {
+                    ZeroCopyPending pending = {id, id, 1, segment.block};
+                    zeroCopyPending_.push_back(pending);
+                }
+            }
+        }
+    }
+
+    if (n < 0)
+    {
+        *savedErrno = errno;
+        return n;
+    }
+
+    segment.remaining -= n;
+    segmentBytes_ -= n;
+    loop_->load().addPendingBytes(-n);
+    metrics_.addBytesSent(n);
+    if (segment.remaining == 0)
+    {
+        popSegment();
+    }
+    return n;
+}
+
+bool TcpConnection::handleZeroCopyCompletions()
+{
+    if (!zeroCopyEnabled_)
+    {
+        return false;
+    }
+
+    bool completed = false;
+    for (;;)
+    {
+        char control[128];
+        struct msghdr msg;
+        ::bzero(&msg, sizeof msg);
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof control;
+        if (::recvmsg(channel_->fd(), &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+        {
+            break; // EAGAIN 错误队列已经读完了
+        }
+
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm))
+        {
+            if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+                && !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+            {
+                continue;
+            }
+            const struct sock_extended_err *serr =
+                reinterpret_cast<const struct sock_extended_err*>(CMSG_DATA(cm));
+            if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr->ee_errno != 0)
+            {
+                continue;
+            }
+
+            completed = true;
+            if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+            {
+                // 内核还是复制了数据(比如loopback)，MSG_ZEROCOPY只剩额外的开销，之后不再使用
+                zeroCopyDisabled_ = true;
+            }
+
+            // [ee_info, ee_data]区间内的send已经完成，对应的内存块可以释放了
+            for (ZeroCopyPending &pending : zeroCopyPending_)
+            {
+                uint32_t lo = std::max(pending.firstId, serr->ee_info);
+                uint32_t hi = std::min(pending.lastId, serr->ee_data);
+                if (lo <= hi)
+                {
+                    pending.outstanding -= hi - lo + 1;
+                }
+            }
+            while (!zeroCopyPending_.empty() && zeroCopyPending_.front().outstanding == 0)
+            {
+                zeroCopyPending_.pop_front();
+            }
+        }
+    }
+    return completed;
+}
+
 // 关闭连接
 void TcpConnection::shutdown()
 {
@@ -170,11 +584,57 @@ void TcpConnection::shutdownInLoop()
     }
 }
 
+void TcpConnection::startRead()
+{
+    loop_->runInLoop(std::bind(&TcpConnection::startReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::stopRead()
+{
+    loop_->runInLoop(std::bind(&TcpConnection::stopReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::startReadInLoop()
+{
+    if (state_ == kDisconnected || reading_)
+    {
+        return;
+    }
+    reading_ = true;
+    // ET模式下重新加上EPOLLIN时，如果fd已经可读，epoll_ctl之后会再通知一次，不会丢掉暂停期间到达的数据
+    channel_->enableReading();
+}
+
+void TcpConnection::stopReadInLoop()
+{
+    if (state_ == kDisconnected || !reading_)
+    {
+        return;
+    }
+    reading_ = false;
+    channel_->disableReading();
+}
+
+void TcpConnection::checkLowWaterMark()
+{
+    if (aboveLowWaterMark_ && outputMemoryBytes() <= lowWaterMark_)
+    {
+        aboveLowWaterMark_ = false;
+        if (lowWaterMarkCallback_)
+        {
+            loop_->queueInLoop(
+                std::bind(lowWaterMarkCallback_, shared_from_this(), outputMemoryBytes())
+            );
+        }
+    }
+}
+
 // 连接建立
 void TcpConnection::connectEstablished()
 {
     setState(kConnected);
     channel_->tie(shared_from_this());
+    channel_->setEdgeTriggered(edgeTriggered_);
     channel_->enableReading(); // 向poller注册channel的epollin事件
 
     // 新连接建立，执行回调
@@ -191,14 +651,29 @@ void TcpConnection::connectDestroyed()
         connectionCallback_(shared_from_this());
     }
     channel_->remove(); // 把channel从poller中删除掉
+
+    loop_->load().addPendingBytes(-static_cast<int64_t>(outputBytes()));
+    loop_->load().connectionRemoved();
 }
 
 void TcpConnection::handleRead(Timestamp receiveTime)
 {
+    if (edgeTriggered_)
+    {
+        handleReadEdgeTriggered(receiveTime);
+        return;
+    }
+    if (!reading_)
+    {
+        return; // 同一轮poll里面前面的回调已经stopRead，数据留在内核里等startRead
+    }
+
     int savedErrno = 0;
     ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
     if (n > 0)
     {
+        metrics_.addBytesReceived(n);
+        metrics_.messageReceived();
         // 已建立连接的用户，有可读事件发生了，调用用户传入的回调操作onMessage
         messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
     }
@@ -214,35 +689,109 @@ void TcpConnection::handleRead(Timestamp receiveTime)
     }
 }
 
+/**
+ * ET模式下poller只在fd从不可读变成可读时通知一次，所以要一直读到EAGAIN
+ * 一次最多读ioBudget_字节，超过了就把剩下的读操作放到pendingFunctors里面，
+ * 让本轮poll返回的其它channel先得到处理，避免一个大流量连接饿死同一个loop上的其它连接
+ */
+void TcpConnection::handleReadEdgeTriggered(Timestamp receiveTime)
+{
+    if (state_ == kDisconnected || !reading_)
+    {
+        return; // 继续读之前连接已经关闭了，或者已经stopRead
+    }
+
+    int savedErrno = 0;
+    size_t total = 0;
+    ssize_t n = 0;
+    while (total < ioBudget_)
+    {
+        n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
+        if (n <= 0)
+        {
+            break;
+        }
+        total += n;
+    }
+
+    if (total > 0)
+    {
+        metrics_.addBytesReceived(total);
+        metrics_.messageReceived();
+        messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+    }
+
+    if (n == 0)
+    {
+        handleClose();
+    }
+    else if (n < 0)
+    {
+        if (savedErrno != EAGAIN && savedErrno != EWOULDBLOCK)
+        {
+            errno = savedErrno;
+            LOG_ERROR("TcpConnection::handleRead");
+            handleError();
+        }
+    }
+    else // 预算用完了，fd上可能还有数据，ET模式下不会再通知
+    {
+        loop_->queueInLoop(
+            std::bind(&TcpConnection::handleReadEdgeTriggered, shared_from_this(), receiveTime)
+        );
+    }
+}
+
 void TcpConnection::handleWrite()
 {
     if (channel_->isWriting())
     {
         int savedErrno = 0;
-        ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno);
-        if (n > 0)
+        size_t total = 0;
+        ssize_t n = 0;
+        for (;;)
         {
-            outputBuffer_.retrieve(n);
-            if (outputBuffer_.readableBytes() == 0)
+            // outputBuffer_和sendFile/sendZeroCopy排队的块按顺序发送
+            n = writeOnce(&savedErrno);
+            if (n <= 0)
             {
-                channel_->disableWriting();
-                if (writeCompleteCallback_)
-                {
-                    // 唤醒loop_对应的thread线程，执行回调
-                    loop_->queueInLoop(
-                        std::bind(writeCompleteCallback_, shared_from_this())
-                    );
-                }
-                if (state_ == kDisconnecting)
-                {
-                    shutdownInLoop();
-                }
+                break;
+            }
+            total += n;
+            // LT模式只写一次；ET模式一直写到EAGAIN、数据发完或者预算用完
+            if (!edgeTriggered_ || outputBytes() == 0 || total >= ioBudget_)
+            {
+                break;
             }
         }
-        else
+        checkLowWaterMark();
+
+        if (outputBytes() == 0)
+        {
+            channel_->disableWriting();
+            if (writeCompleteCallback_)
+            {
+                // 唤醒loop_对应的thread线程，执行回调
+                loop_->queueInLoop(
+                    std::bind(writeCompleteCallback_, shared_from_this())
+                );
+            }
+            if (state_ == kDisconnecting)
+            {
+                shutdownInLoop();
+            }
+        }
+        else if (n < 0 && savedErrno != EAGAIN && savedErrno != EWOULDBLOCK)
         {
             LOG_ERROR("TcpConnection::handleWrite");
         }
+        else if (edgeTriggered_ && n > 0)
+        {
+            // 预算用完了，socket可能仍然可写，ET模式下不会再通知
+            loop_->queueInLoop(
+                std::bind(&TcpConnection::handleWrite, shared_from_this())
+            );
+        }
     }
     else
     {
@@ -264,6 +813,9 @@ void TcpConnection::handleClose()
 
 void TcpConnection::handleError()
 {
+    // MSG_ZEROCOPY的完成通知也是通过EPOLLERR报告的，并不是连接出错
+    bool zeroCopyCompleted = handleZeroCopyCompletions();
+
     int optval;
     socklen_t optlen = sizeof optval;
     int err = 0;
@@ -275,5 +827,9 @@ void TcpConnection::handleError()
     {
         err = optval;
     }
-    LOG_ERROR("TcpConnection::handleError name:%s - SO_ERROR:%d \n", name_.c_str(), err);
+    if (zeroCopyCompleted && err == 0)
+    {
+        return;
+    }
+    LOG_ERROR("TcpConnection::handleError name:%s - SO_ERROR:%d \n", name().c_str(), err);
 }
\ No newline at end of file
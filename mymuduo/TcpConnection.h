@@ -5,10 +5,15 @@
 #include "Callbacks.h"
 #include "Buffer.h"
 #include "Timestamp.h"
+#include "Metrics.h"
 
 #include <memory>
 #include <string>
 #include <atomic>
+#include <deque>
+#include <mutex>
+#include <stdint.h>
+#include <sys/types.h>
 
 class Channel;
 class EventLoop;
@@ -26,21 +31,75 @@ public:
                 const std::string &name, 
                 int sockfd,
                 const InetAddress& localAddr,
-                const InetAddress& peerAddr);
+                const InetAddress& peerAddr,
+                Buffer::Mode inputBufferMode = Buffer::kContiguous);
+    /**
+     * TcpServer使用  名字为 *namePrefix + sequence，第一次调用name()时才拼接，
+     * 关闭了INFO日志的时候短连接的建立和关闭不会产生任何字符串操作
+     */
+    TcpConnection(EventLoop *loop,
+                std::shared_ptr<const std::string> namePrefix,
+                uint64_t sequence,
+                int sockfd,
+                const InetAddress& localAddr,
+                const InetAddress& peerAddr,
+                Buffer::Mode inputBufferMode = Buffer::kContiguous);
     ~TcpConnection();
 
     EventLoop* getLoop() const { return loop_; }
-    const std::string& name() const { return name_; }
+    const std::string& name() const;
+
+    // TcpServer分配的连接id，在同一个TcpServer内唯一，没有加入TcpServer的连接为0
+    ConnectionId id() const { return id_; }
+    void setId(ConnectionId id) { id_ = id; }
     const InetAddress& localAddress() const { return localAddr_; }
     const InetAddress& peerAddress() const { return peerAddr_; }
 
     bool connected() const { return state_ == kConnected; }
 
+    // 收发字节数、消息数和发送缓冲区的峰值，可以在任意线程调用
+    ConnectionMetrics::Snapshot metrics() const { return metrics_.snapshot(); }
+
     // 发送数据
     void send(const std::string &buf);
+    // 发送buf中的所有数据并清空buf，在loop线程中调用时不需要额外拷贝一次
+    void send(Buffer *buf);
+
+    /**
+     * 通过sendfile发送文件[offset, offset+len)的内容，数据不经过用户态
+     * 内部会dup一份fd，调用返回之后调用者就可以关闭自己的fd
+     * 和send的数据按调用顺序发送，全部发完之后回调writeCompleteCallback_
+     * 文件数据不占用内存，所以不计入高水位
+     */
+    void sendFile(int fd, off_t offset, size_t len);
+
+    /**
+     * 发送一块只读的大内存  不拷贝到outputBuffer_，发送期间持有block的引用
+     * 不小于kZeroCopyThreshold的块使用MSG_ZEROCOPY，内核通过错误队列通知发送完成之后才释放引用；
+     * 内核不支持或者通知数据被复制了(比如loopback)，之后的块退化为普通send
+     */
+    void sendZeroCopy(const std::shared_ptr<const std::string> &block);
+
+    static const size_t kZeroCopyThreshold = 32 * 1024;
     // 关闭连接
     void shutdown();
 
+    /**
+     * 暂停/恢复读取  从poller中去掉/加上EPOLLIN，暂停期间数据留在内核的接收缓冲区里，
+     * 对端会因为TCP窗口变小而放慢发送，可以跨线程调用
+     */
+    void startRead();
+    void stopRead();
+    // 只能在loop线程中调用
+    bool isReading() const { return reading_; }
+
+    // 接收缓冲区，只能在loop线程中访问
+    Buffer* inputBuffer() { return &inputBuffer_; }
+
+    // 用户自定义的连接上下文，比如HttpServer每个连接的请求解析器
+    void setContext(const std::shared_ptr<void> &context) { context_ = context; }
+    const std::shared_ptr<void>& getContext() const { return context_; }
+
     void setConnectionCallback(const ConnectionCallback& cb)
     { connectionCallback_ = cb; }
 
@@ -53,9 +112,28 @@ public:
     void setHighWaterMarkCallback(const HighWaterMarkCallback& cb, size_t highWaterMark)
     { highWaterMarkCallback_ = cb; highWaterMark_ = highWaterMark; }
 
+    /**
+     * 待发送的数据(不含文件块)从高于lowWaterMark降到不高于lowWaterMark时回调，
+     * 和高水位回调配合：高水位时stopRead数据来源，低水位时startRead
+     */
+    void setLowWaterMarkCallback(const LowWaterMarkCallback& cb, size_t lowWaterMark)
+    { lowWaterMarkCallback_ = cb; lowWaterMark_ = lowWaterMark; }
+
     void setCloseCallback(const CloseCallback& cb)
     { closeCallback_ = cb; }
 
+    const ConnectionCallback& connectionCallback() const { return connectionCallback_; }
+    const MessageCallback& messageCallback() const { return messageCallback_; }
+    const WriteCompleteCallback& writeCompleteCallback() const { return writeCompleteCallback_; }
+
+    // 开启边沿触发模式，需要在connectEstablished之前调用
+    // 每次读写事件一直处理到EAGAIN，但最多处理ioBudget字节，剩下的排到本轮其它channel之后继续
+    void setEdgeTriggered(bool on, size_t ioBudget = kDefaultIoBudget)
+    { edgeTriggered_ = on; ioBudget_ = ioBudget; }
+    bool edgeTriggered() const { return edgeTriggered_; }
+
+    static const size_t kDefaultIoBudget = 1024 * 1024; // 1M
+
     // 连接建立
     void connectEstablished();
     // 连接销毁
@@ -65,17 +143,64 @@ private:
     void setState(StateE state) { state_ = state; }
 
     void handleRead(Timestamp receiveTime);
+    void handleReadEdgeTriggered(Timestamp receiveTime);
     void handleWrite();
     void handleClose();
     void handleError();
 
     void sendInLoop(const void* message, size_t len);
+    void sendStringInLoop(const std::string &message);
+    void sendFileInLoop(int fd, off_t offset, size_t len);
+    void sendZeroCopyInLoop(const std::shared_ptr<const std::string> &block);
     void shutdownInLoop();
+    void startReadInLoop();
+    void stopReadInLoop();
+    // 待发送的数据变少之后检查是否降到了低水位
+    void checkLowWaterMark();
+
+    /**
+     * outputBuffer_之后排队的文件块或者内存块  和outputBuffer_中的数据按照调用顺序发送：
+     * outputBuffer_累计写出bufferPos字节之后，才轮到这个块
+     */
+    struct OutputSegment
+    {
+        uint64_t bufferPos;
+        int fd;          // 文件块：dup出来的fd；内存块：-1
+        off_t offset;    // 文件块下一次sendfile的位置
+        size_t remaining;
+        std::shared_ptr<const std::string> block; // 内存块
+        size_t blockOffset;
+    };
+
+    // MSG_ZEROCOPY发送过的内存块，等待内核通知完成  [firstId, lastId]是这个块用到的send调用序号
+    struct ZeroCopyPending
+    {
+        uint32_t firstId;
+        uint32_t lastId;
+        uint32_t outstanding;
+        std::shared_ptr<const std::string> block;
+    };
+
+    void queueSegment(OutputSegment segment);
+    void popSegment();
+    // 按顺序发送一次待发送的数据，返回写出的字节数
+    ssize_t writeOnce(int *savedErrno);
+    ssize_t writeSegment(OutputSegment &segment, int *savedErrno);
+    // 读取错误队列中MSG_ZEROCOPY的完成通知，返回是否读到了通知
+    bool handleZeroCopyCompletions();
+    // 所有待发送的数据(包括文件块)
+    size_t outputBytes() const { return outputBuffer_.readableBytes() + segmentBytes_; }
+    // 占用内存的待发送数据，用来判断高水位
+    size_t outputMemoryBytes() const { return outputBuffer_.readableBytes() + segmentMemoryBytes_; }
 
     EventLoop *loop_; // 这里绝对不是baseLoop， 因为TcpConnection都是在subLoop里面管理的
-    const std::string name_;
+    const std::shared_ptr<const std::string> namePrefix_;
+    const uint64_t sequence_; // 为0时名字就是namePrefix_
+    mutable std::once_flag nameOnce_;
+    mutable std::string name_;
+    ConnectionId id_;
     std::atomic_int state_;
-    bool reading_;
+    bool reading_; // 是否在监听EPOLLIN，stopRead之后为false
 
     // 这里和Acceptor类似   Acceptor=》mainLoop    TcpConenction=》subLoop
     std::unique_ptr<Socket> socket_;
@@ -88,9 +213,29 @@ private:
     MessageCallback messageCallback_; // 有读写消息时的回调
     WriteCompleteCallback writeCompleteCallback_; // 消息发送完成以后的回调
     HighWaterMarkCallback highWaterMarkCallback_;
+    LowWaterMarkCallback lowWaterMarkCallback_;
     CloseCallback closeCallback_;
     size_t highWaterMark_;
+    size_t lowWaterMark_;
+    bool aboveLowWaterMark_; // 待发送的数据高于lowWaterMark_，降下来之后回调一次
+    std::shared_ptr<void> context_;
+
+    bool edgeTriggered_;
+    size_t ioBudget_;
 
     Buffer inputBuffer_;  // 接收数据的缓冲区
-    Buffer outputBuffer_; // 发送数据的缓冲区
+    Buffer outputBuffer_; // 发送数据的缓冲区  链式模式，大块数据不会触发vector扩容，发送时一次writev
+
+    uint64_t bufferAppended_; // 累计写入outputBuffer_的字节数
+    uint64_t bufferWritten_;  // 累计从outputBuffer_写出的字节数
+    std::deque<OutputSegment> segments_;
+    size_t segmentBytes_;
+    size_t segmentMemoryBytes_;
+
+    bool zeroCopyEnabled_;  // 已经设置了SO_ZEROCOPY
+    bool zeroCopyDisabled_; // 内核不支持或者数据会被复制，不再使用MSG_ZEROCOPY
+    uint32_t zeroCopyNextId_; // 内核给下一次MSG_ZEROCOPY send分配的序号
+    std::deque<ZeroCopyPending> zeroCopyPending_;
+
+    ConnectionMetrics metrics_;
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "TcpConnection.h"
 
 #include <strings.h>
+#include <unistd.h>
 #include <functional>
 
 static EventLoop* CheckLoopNotNull(EventLoop *loop)
@@ -21,30 +22,45 @@ TcpServer::TcpServer(EventLoop *loop,
                 : loop_(CheckLoopNotNull(loop))
                 , ipPort_(listenAddr.toIpPort())
                 , name_(nameArg)
-                , acceptor_(new Acceptor(loop, listenAddr, option == kReusePort))
+                , listenAddr_(listenAddr)
+                , option_(option)
+                , acceptor_(option == kReusePortPerLoop ? nullptr : new Acceptor(loop, listenAddr, option == kReusePort))
                 , threadPool_(new EventLoopThreadPool(loop, name_))
                 , connectionCallback_()
                 , messageCallback_()
-                , nextConnId_(1)
                 , started_(0)
+                , inputBufferMode_(Buffer::kContiguous)
+                , edgeTriggered_(false)
+                , ioBudget_(TcpConnection::kDefaultIoBudget)
+                , namePrefix_(std::make_shared<const std::string>(nameArg + "-" + ipPort_ + "#"))
+                , nextConnId_(1)
 {
     // 当有先用户连接时，会执行TcpServer::newConnection回调
-    acceptor_->setNewConnectionCallback(std::bind(&TcpServer::newConnection, this, 
-        std::placeholders::_1, std::placeholders::_2));
+    if (acceptor_)
+    {
+        acceptor_->setNewConnectionCallback(std::bind(&TcpServer::newConnection, this, 
+            std::placeholders::_1, std::placeholders::_2));
+    }
 }
 
 TcpServer::~TcpServer()
 {
-    for (auto &item : connections_)
+    // 连接表和subloop上的Acceptor只能在各自的线程里面销毁：先让subloop退出，
+    // 在subloop线程里面loop()返回之后销毁，不依赖loop还会不会执行投递过去的回调
+    threadPool_->stop([this](EventLoop *loop) {
+        auto it = contextOfLoop_.find(loop);
+        if (it != contextOfLoop_.end())
+        {
+            destroyLoopContext(it->second);
+        }
+    });
+
+    // 没有subloop的时候连接都在baseloop上，和muduo一样要求在baseloop线程中析构TcpServer
+    // (或者baseloop已经退出，并且和当前线程同步过，比如join过它的线程)
+    auto it = contextOfLoop_.find(loop_);
+    if (it != contextOfLoop_.end())
     {
-        // 这个局部的shared_ptr智能指针对象，出右括号，可以自动释放new出来的TcpConnection对象资源了
-        TcpConnectionPtr conn(item.second); 
-        item.second.reset();
-
-        // 销毁连接
-        conn->getLoop()->runInLoop(
-            std::bind(&TcpConnection::connectDestroyed, conn)
-        );
+        destroyLoopContext(it->second);
     }
 }
 
@@ -60,7 +76,38 @@ void TcpServer::start()
     if (started_++ == 0) // 防止一个TcpServer对象被start多次
     {
         threadPool_->start(threadInitCallback_); // 启动底层的loop线程池
-        loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
+
+        // 没有subloop的时候getAllLoops返回的就是baseLoop
+        std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+        for (size_t i = 0; i < loops.size(); ++i)
+        {
+            LoopContext *ctx = new LoopContext;
+            ctx->index = static_cast<int>(i);
+            ctx->loop = loops[i];
+            ctx->nextConnSeq = 1;
+            if (option_ == kReusePortPerLoop)
+            {
+                ctx->namePrefix = std::make_shared<const std::string>(
+                    *namePrefix_ + std::to_string(i) + ".");
+                ctx->acceptor.reset(new Acceptor(loops[i], listenAddr_, true));
+                ctx->acceptor->setNewConnectionCallback(std::bind(&TcpServer::newLoopConnection, this, 
+                    ctx, std::placeholders::_1, std::placeholders::_2));
+            }
+            loopContexts_.push_back(std::unique_ptr<LoopContext>(ctx));
+            contextOfLoop_[ctx->loop] = ctx;
+        }
+
+        if (option_ == kReusePortPerLoop)
+        {
+            for (auto &ctx : loopContexts_)
+            {
+                ctx->loop->runInLoop(std::bind(&Acceptor::listen, ctx->acceptor.get()));
+            }
+        }
+        else
+        {
+            loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
+        }
     }
 }
 
@@ -69,14 +116,75 @@ void TcpServer::newConnection(int sockfd, const InetAddress &peerAddr)
 {
     // 轮询算法，选择一个subLoop，来管理channel
     EventLoop *ioLoop = threadPool_->getNextLoop(); 
-    char buf[64] = {0};
-    snprintf(buf, sizeof buf, "-%s#%d", ipPort_.c_str(), nextConnId_);
+    auto it = contextOfLoop_.find(ioLoop);
+    if (it == contextOfLoop_.end())
+    {
+        LOG_ERROR("TcpServer::newConnection [%s] - no context for the chosen loop, drop the connection\n",
+            name_.c_str());
+        ::close(sockfd);
+        return;
+    }
+    LoopContext *ctx = it->second;
+
+    TcpConnectionPtr conn = createConnection(ioLoop, namePrefix_, nextConnId_, sockfd, peerAddr);
     ++nextConnId_;
-    std::string connName = name_ + buf;
 
-    LOG_INFO("TcpServer::newConnection [%s] - new connection [%s] from %s \n",
-        name_.c_str(), connName.c_str(), peerAddr.toIpPort().c_str());
+    // 加入subloop自己的连接表，然后调用TcpConnection::connectEstablished
+    ioLoop->runInLoop(std::bind(&TcpServer::establishConnection, this, ctx, conn));
+}
+
+// kReusePortPerLoop模式  运行在ctx->loop线程中
+void TcpServer::newLoopConnection(LoopContext *ctx, int sockfd, const InetAddress &peerAddr)
+{
+    TcpConnectionPtr conn = createConnection(ctx->loop, ctx->namePrefix, ctx->nextConnSeq, sockfd, peerAddr);
+    ++ctx->nextConnSeq;
+    establishConnection(ctx, conn);
+}
+
+void TcpServer::establishConnection(LoopContext *ctx, const TcpConnectionPtr &conn)
+{
+    conn->setId(makeConnectionId(ctx, ctx->connections.insert(conn)));
+
+    // 设置了如何关闭连接的回调   conn->shutDown()
+    conn->setCloseCallback(
+        std::bind(&TcpServer::removeConnection, this, ctx, std::placeholders::_1)
+    );
+    conn->connectEstablished();
+}
+
+// 运行在ctx->loop线程中，连接就在这个线程的连接表里面，直接删除
+void TcpServer::removeConnection(LoopContext *ctx, const TcpConnectionPtr &conn)
+{
+    LOG_INFO("TcpServer::removeConnection [%s] - connection %s\n", 
+        name_.c_str(), conn->name().c_str());
 
+    ctx->connections.erase(localConnectionId(conn->id()));
+    ctx->loop->queueInLoop(
+        std::bind(&TcpConnection::connectDestroyed, conn)
+    );
+}
+
+void TcpServer::destroyLoopContext(LoopContext *ctx)
+{
+    ctx->acceptor.reset();
+
+    std::vector<TcpConnectionPtr> conns;
+    conns.reserve(ctx->connections.size());
+    ctx->connections.forEach([&conns](ConnectionMap::Id, TcpConnectionPtr &conn) {
+        conns.push_back(conn);
+    });
+    ctx->connections.clear();
+
+    for (const TcpConnectionPtr &conn : conns)
+    {
+        // 销毁连接
+        conn->connectDestroyed();
+    }
+}
+
+TcpConnectionPtr TcpServer::createConnection(EventLoop *ioLoop, const std::shared_ptr<const std::string> &namePrefix,
+                                             uint64_t sequence, int sockfd, const InetAddress &peerAddr)
+{
     // 通过sockfd获取其绑定的本机的ip地址和端口信息
     sockaddr_in local;
     ::bzero(&local, sizeof local);
@@ -90,40 +198,19 @@ void TcpServer::newConnection(int sockfd, const InetAddress &peerAddr)
     // 根据连接成功的sockfd，创建TcpConnection连接对象
     TcpConnectionPtr conn(new TcpConnection(
                             ioLoop,
-                            connName,
+                            namePrefix,
+                            sequence,
                             sockfd,   // Socket Channel
                             localAddr,
-                            peerAddr));
-    connections_[connName] = conn;
+                            peerAddr,
+                            inputBufferMode_));
+    LOG_INFO("TcpServer::newConnection [%s] - new connection [%s] from %s \n",
+        name_.c_str(), conn->name().c_str(), peerAddr.toIpPort().c_str());
+
     // 下面的回调都是用户设置给TcpServer=>TcpConnection=>Channel=>Poller=>notify channel调用回调
     conn->setConnectionCallback(connectionCallback_);
     conn->setMessageCallback(messageCallback_);
     conn->setWriteCompleteCallback(writeCompleteCallback_);
-
-    // 设置了如何关闭连接的回调   conn->shutDown()
-    conn->setCloseCallback(
-        std::bind(&TcpServer::removeConnection, this, std::placeholders::_1)
-    );
-
-    // 直接调用TcpConnection::connectEstablished
-    ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
-}
-
-void TcpServer::removeConnection(const TcpConnectionPtr &conn)
-{
-    loop_->runInLoop(
-        std::bind(&TcpServer::removeConnectionInLoop, this, conn)
-    );
+    conn->setEdgeTriggered(edgeTriggered_, ioBudget_);
+    return conn;
 }
-
-void TcpServer::removeConnectionInLoop(const TcpConnectionPtr &conn)
-{
-    LOG_INFO("TcpServer::removeConnectionInLoop [%s] - connection %s\n", 
-        name_.c_str(), conn->name().c_str());
-
-    connections_.erase(conn->name());
-    EventLoop *ioLoop = conn->getLoop(); 
-    ioLoop->queueInLoop(
-        std::bind(&TcpConnection::connectDestroyed, conn)
-    );
-}
\ No newline at end of file
@@ -11,11 +11,13 @@
 #include "Callbacks.h"
 #include "TcpConnection.h"
 #include "Buffer.h"
+#include "SlotMap.h"
 
 #include <functional>
 #include <string>
 #include <memory>
 #include <atomic>
+#include <vector>
 #include <unordered_map>
 
 // 对外的服务器编程使用的类
@@ -28,12 +30,16 @@ public:
     {
         kNoReusePort,
         kReusePort,
+        // 每个subloop各自创建一个SO_REUSEPORT的监听socket和Acceptor，由内核把新连接分散到各个subloop，
+        // accept和TcpConnection的创建都在subloop自己的线程里面完成，不再经过mainLoop转发
+        kReusePortPerLoop,
     };
 
     TcpServer(EventLoop *loop,
                 const InetAddress &listenAddr,
                 const std::string &nameArg,
                 Option option = kNoReusePort);
+    // 在baseloop线程中析构，subloop线程在析构时结束
     ~TcpServer();
 
     void setThreadInitcallback(const ThreadInitCallback &cb) { threadInitCallback_ = cb; }
@@ -41,24 +47,78 @@ public:
     void setMessageCallback(const MessageCallback &cb) { messageCallback_ = cb; }
     void setWriteCompleteCallback(const WriteCompleteCallback &cb) { writeCompleteCallback_ = cb; }
 
+    // 设置新连接接收缓冲区的模式，kChained模式下readFd直接读到内存块里面，省掉extrabuf的二次拷贝
+    void setInputBufferMode(Buffer::Mode mode) { inputBufferMode_ = mode; }
+
+    // 新连接使用边沿触发模式，ioBudget是每次读写事件最多处理的字节数
+    void setEdgeTriggered(bool on, size_t ioBudget = TcpConnection::kDefaultIoBudget)
+    { edgeTriggered_ = on; ioBudget_ = ioBudget; }
+
     // 设置底层subloop的个数
     void setThreadNum(int numThreads);
 
+    // 设置新连接分配到subloop的策略，默认轮询
+    void setPlacementPolicy(EventLoopThreadPool::PlacementPolicy policy) { threadPool_->setPlacementPolicy(policy); }
+    void setPlacementCallback(const EventLoopThreadPool::PlacementCallback &cb) { threadPool_->setPlacementCallback(cb); }
+
+    // 每个subloop的负载，用来观察连接分配是否倾斜，可以在任意线程调用
+    std::vector<LoopLoad::Snapshot> loopLoads() const { return threadPool_->loadSnapshot(); }
+    // 每个subloop的运行统计，可以在任意线程调用
+    std::vector<LoopMetrics::Snapshot> loopMetrics() const { return threadPool_->metricsSnapshot(); }
+
     // 开启服务器监听
     void start();
 private:
+    using ConnectionMap = SlotMap<TcpConnectionPtr>;
+
+    /**
+     * 每个loop一个的连接表  连接的加入和删除都在该loop线程中完成，不需要加锁，
+     * 连接关闭时也不用再回到mainLoop删除
+     * kReusePortPerLoop模式下还持有这个loop自己的Acceptor
+     */
+    struct LoopContext
+    {
+        int index;
+        EventLoop *loop;
+        std::unique_ptr<Acceptor> acceptor;
+        std::shared_ptr<const std::string> namePrefix; // kReusePortPerLoop模式下连接名字的前缀
+        uint64_t nextConnSeq;
+        ConnectionMap connections;
+    };
+
+    // 连接id = loop下标 << 48 | 连接表中的id
+    static ConnectionId makeConnectionId(const LoopContext *ctx, ConnectionMap::Id id)
+    {
+        return (static_cast<ConnectionId>(ctx->index) << ConnectionMap::kIdBits) | id;
+    }
+    static ConnectionMap::Id localConnectionId(ConnectionId id)
+    {
+        return id & ((static_cast<ConnectionId>(1) << ConnectionMap::kIdBits) - 1);
+    }
+
     void newConnection(int sockfd, const InetAddress &peerAddr);
-    void removeConnection(const TcpConnectionPtr &conn);
-    void removeConnectionInLoop(const TcpConnectionPtr &conn);
+    // 运行在ctx->loop线程中，把连接加入连接表并建立连接
+    void establishConnection(LoopContext *ctx, const TcpConnectionPtr &conn);
+    void removeConnection(LoopContext *ctx, const TcpConnectionPtr &conn);
+
+    // kReusePortPerLoop模式下，subloop上的Acceptor接收到新连接，直接在本线程中建立
+    void newLoopConnection(LoopContext *ctx, int sockfd, const InetAddress &peerAddr);
+    void destroyLoopContext(LoopContext *ctx);
 
-    using ConnectionMap = std::unordered_map<std::string, TcpConnectionPtr>;
+    // 创建TcpConnection对象并设置用户回调
+    TcpConnectionPtr createConnection(EventLoop *ioLoop, const std::shared_ptr<const std::string> &namePrefix,
+                                      uint64_t sequence, int sockfd, const InetAddress &peerAddr);
 
     EventLoop *loop_; // baseLoop 用户定义的loop
 
     const std::string ipPort_;
     const std::string name_;
+    const InetAddress listenAddr_;
+    const Option option_;
 
-    std::unique_ptr<Acceptor> acceptor_; // 运行在mainLoop，任务就是监听新连接事件
+    std::unique_ptr<Acceptor> acceptor_; // 运行在mainLoop，任务就是监听新连接事件  kReusePortPerLoop模式下为空
+    std::vector<std::unique_ptr<LoopContext>> loopContexts_;
+    std::unordered_map<EventLoop*, LoopContext*> contextOfLoop_; // start之后只读，只在mainLoop中使用
 
     std::shared_ptr<EventLoopThreadPool> threadPool_; // one loop per thread
 
@@ -69,7 +129,10 @@ private:
     ThreadInitCallback threadInitCallback_; // loop线程初始化的回调
 
     std::atomic_int started_;
+    Buffer::Mode inputBufferMode_;
+    bool edgeTriggered_;
+    size_t ioBudget_;
 
-    int nextConnId_;
-    ConnectionMap connections_; // 保存所有的连接
+    const std::shared_ptr<const std::string> namePrefix_; // 连接名字的前缀 name-ip:port#
+    uint64_t nextConnId_;
 };
\ No newline at end of file
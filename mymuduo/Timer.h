@@ -0,0 +1,71 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Callbacks.h"
+
+#include <stdint.h>
+
+// 侵入式双向链表节点  时间轮每个槽位的表头也是一个TimerNode
+struct TimerNode
+{
+    TimerNode() : prev(this), next(this) {}
+
+    TimerNode *prev;
+    TimerNode *next;
+};
+
+/**
+ * 定时器  挂在TimerQueue时间轮的某个槽位上
+ * 通过TimerNode组成侵入式链表，插入和删除都是O(1)，不需要额外分配链表节点
+ * Timer对象由TimerQueue回收复用，sequence_每复用一次就加一，用来判断TimerId是否已经失效
+ */
+class Timer : public TimerNode, noncopyable
+{
+public:
+    Timer(TimerCallback cb, uint64_t expiration, uint64_t interval)
+        : callback_(std::move(cb))
+        , expiration_(expiration)
+        , interval_(interval)
+        , sequence_(1)
+        , slot_(-1)
+        , canceled_(false)
+    {}
+
+    void reset(TimerCallback cb, uint64_t expiration, uint64_t interval)
+    {
+        callback_ = std::move(cb);
+        expiration_ = expiration;
+        interval_ = interval;
+        canceled_ = false;
+    }
+
+    // 定时器到期，执行回调
+    void run() const { callback_(); }
+
+    // 释放回调绑定的资源，并让之前发出去的TimerId失效
+    void release()
+    {
+        callback_ = TimerCallback();
+        ++sequence_;
+    }
+
+    uint64_t expiration() const { return expiration_; }
+    void setExpiration(uint64_t expiration) { expiration_ = expiration; }
+    uint64_t interval() const { return interval_; }
+    bool repeat() const { return interval_ > 0; }
+    int64_t sequence() const { return sequence_; }
+
+    // 所在的槽位编号，小于0表示不在时间轮上
+    int slot() const { return slot_; }
+    void setSlot(int slot) { slot_ = slot; }
+
+    bool canceled() const { return canceled_; }
+    void setCanceled() { canceled_ = true; }
+private:
+    TimerCallback callback_;
+    uint64_t expiration_; // 到期的tick
+    uint64_t interval_;   // 重复定时器的间隔tick数，0表示一次性定时器
+    int64_t sequence_;
+    int slot_;
+    bool canceled_;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+
+class Timer;
+
+/**
+ * 用户取消定时器时使用的标识
+ * timer_指向的对象在TimerQueue生命周期内不会被释放，只会被复用，
+ * 所以通过比较sequence_就可以知道这个TimerId是否已经过期
+ */
+class TimerId
+{
+public:
+    TimerId()
+        : timer_(nullptr)
+        , sequence_(0)
+    {}
+
+    TimerId(Timer *timer, int64_t seq)
+        : timer_(timer)
+        , sequence_(seq)
+    {}
+
+    friend class TimerQueue;
+private:
+    Timer *timer_;
+    int64_t sequence_;
+};
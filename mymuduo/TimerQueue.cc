@@ -0,0 +1,405 @@
+#include "TimerQueue.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <strings.h>
+
+const uint64_t TimerQueue::kMaxSpan;
+const uint64_t TimerQueue::kNever;
+
+static int createTimerfd()
+{
+    int timerfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerfd < 0)
+    {
+        LOG_FATAL("timerfd_create error:%d \n", errno);
+    }
+    return timerfd;
+}
+
+// 第level层槽位下标所对应的tick位移
+static inline int levelShift(int level)
+{
+    return level == 0 ? 0 : 8 + (level - 1) * 6;
+}
+
+// 在位图words的[0, nbits)范围内，从start开始循环查找第一个置位的bit，返回距离start的偏移，没有返回-1
+static int findNextSet(const uint64_t *words, int nbits, int start)
+{
+    const int nwords = nbits / 64;
+    int word = start / 64;
+    uint64_t bits = words[word] & (~0ULL << (start % 64));
+    for (int i = 0; i <= nwords; ++i)
+    {
+        if (bits)
+        {
+            int pos = word * 64 + __builtin_ctzll(bits);
+            return (pos - start + nbits) % nbits;
+        }
+        word = (word + 1) % nwords;
+        bits = words[word];
+    }
+    return -1;
+}
+
+TimerQueue::TimerQueue(EventLoop *loop)
+    : loop_(loop)
+    , timerfd_(createTimerfd())
+    , timerfdChannel_(loop, timerfd_)
+    , currentTick_(nowTick())
+    , armedTick_(kNever)
+    , numTimers_(0)
+    , callingExpiredTimers_(false)
+    , freeList_(nullptr)
+{
+    ::bzero(occupied_, sizeof occupied_);
+    timerfdChannel_.setReadCallback(std::bind(&TimerQueue::handleRead, this));
+    timerfdChannel_.enableReading();
+}
+
+TimerQueue::~TimerQueue()
+{
+    timerfdChannel_.disableAll();
+    timerfdChannel_.remove();
+    ::close(timerfd_);
+
+    for (int i = 0; i < kNumSlots; ++i)
+    {
+        TimerNode *head = &slots_[i];
+        while (head->next != head)
+        {
+            Timer *timer = static_cast<Timer*>(head->next);
+            unlink(timer);
+            delete timer;
+        }
+    }
+    while (freeList_)
+    {
+        Timer *timer = freeList_;
+        freeList_ = static_cast<Timer*>(timer->next);
+        delete timer;
+    }
+}
+
+TimerId TimerQueue::addTimer(TimerCallback cb, Timestamp when, double interval)
+{
+    int64_t delay = when.microSecondsSinceEpoch() - Timestamp::now().microSecondsSinceEpoch();
+    uint64_t expiration = nowTick() + (delay > 0 ? (delay + 999) / 1000 : 0);
+    uint64_t intervalTicks = interval > 0 ? ticksFromSeconds(interval) : 0;
+
+    if (loop_->isInLoopThread())
+    {
+        // loop线程中直接从回收链表取Timer，不需要分配内存
+        Timer *timer = allocTimer(std::move(cb), expiration, intervalTicks);
+        addTimerInLoop(timer);
+        return TimerId(timer, timer->sequence());
+    }
+    else
+    {
+        // 其它线程中新建一个Timer交给loop线程，之后它同样会被回收到loop线程的回收链表中
+        Timer *timer = new Timer(std::move(cb), expiration, intervalTicks);
+        TimerId timerId(timer, timer->sequence());
+        loop_->queueInLoop(std::bind(&TimerQueue::addTimerInLoop, this, timer));
+        return timerId;
+    }
+}
+
+void TimerQueue::cancel(TimerId timerId)
+{
+    loop_->runInLoop(std::bind(&TimerQueue::cancelInLoop, this, timerId));
+}
+
+void TimerQueue::addTimerInLoop(Timer *timer)
+{
+    if (numTimers_ == 0)
+    {
+        // 时间轮上没有定时器的时候currentTick_不会推进，这里重新对齐到当前时间
+        uint64_t now = nowTick();
+        if (now > currentTick_)
+        {
+            currentTick_ = now;
+        }
+    }
+    insert(timer);
+    ++numTimers_;
+
+    uint64_t tick = eventTickOf(timer);
+    if (!callingExpiredTimers_ && tick < armedTick_)
+    {
+        resetTimerfd(tick);
+    }
+}
+
+void TimerQueue::cancelInLoop(TimerId timerId)
+{
+    Timer *timer = timerId.timer_;
+    if (timer == nullptr || timer->sequence() != timerId.sequence_)
+    {
+        return; // 定时器已经到期或者已经被取消了
+    }
+
+    if (timer->slot() == kRunning)
+    {
+        // 在定时器自己的回调里面取消，等回调执行完再回收
+        timer->setCanceled();
+    }
+    else if (timer->slot() != kDetached)
+    {
+        unlink(timer);
+        --numTimers_;
+        freeTimer(timer);
+    }
+    // timerfd不需要重新设置，提前醒来一次发现没有到期的定时器即可
+}
+
+Timer* TimerQueue::allocTimer(TimerCallback cb, uint64_t expiration, uint64_t interval)
+{
+    if (freeList_)
+    {
+        Timer *timer = freeList_;
+        freeList_ = static_cast<Timer*>(timer->next);
+        timer->reset(std::move(cb), expiration, interval);
+        return timer;
+    }
+    return new Timer(std::move(cb), expiration, interval);
+}
+
+void TimerQueue::freeTimer(Timer *timer)
+{
+    timer->release();
+    timer->setSlot(kDetached);
+    timer->next = freeList_;
+    freeList_ = timer;
+}
+
+void TimerQueue::insert(Timer *timer)
+{
+    uint64_t expiration = timer->expiration();
+    if (expiration < currentTick_)
+    {
+        expiration = currentTick_;
+    }
+    else if (expiration - currentTick_ > kMaxSpan)
+    {
+        expiration = currentTick_ + kMaxSpan;
+    }
+    timer->setExpiration(expiration);
+
+    uint64_t delta = expiration - currentTick_;
+    int slot;
+    if (delta < kRootSize)
+    {
+        slot = static_cast<int>(expiration & (kRootSize - 1));
+    }
+    else
+    {
+        int level = 1;
+        while (level < kLevels - 1 && delta >= (1ULL << levelShift(level + 1)))
+        {
+            ++level;
+        }
+        int idx = static_cast<int>((expiration >> levelShift(level)) & (kLevelSize - 1));
+        slot = kRootSize + (level - 1) * kLevelSize + idx;
+    }
+
+    // 挂到槽位链表的尾部
+    TimerNode *head = &slots_[slot];
+    timer->prev = head->prev;
+    timer->next = head;
+    head->prev->next = timer;
+    head->prev = timer;
+
+    occupied_[slot / 64] |= 1ULL << (slot % 64);
+    timer->setSlot(slot);
+}
+
+void TimerQueue::unlink(Timer *timer)
+{
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+
+    int slot = timer->slot();
+    if (slot >= 0 && slots_[slot].next == &slots_[slot])
+    {
+        occupied_[slot / 64] &= ~(1ULL << (slot % 64));
+    }
+    timer->prev = timer->next = timer;
+    timer->setSlot(kDetached);
+}
+
+void TimerQueue::detachSlot(int slot, TimerNode *list, int mark)
+{
+    TimerNode *head = &slots_[slot];
+    if (head->next == head)
+    {
+        return;
+    }
+
+    for (TimerNode *node = head->next; node != head; node = node->next)
+    {
+        static_cast<Timer*>(node)->setSlot(mark);
+    }
+
+    // 整个槽位链表拼接到list的尾部
+    head->next->prev = list->prev;
+    list->prev->next = head->next;
+    head->prev->next = list;
+    list->prev = head->prev;
+    head->prev = head->next = head;
+
+    occupied_[slot / 64] &= ~(1ULL << (slot % 64));
+}
+
+void TimerQueue::cascade(int level)
+{
+    int idx = static_cast<int>((currentTick_ >> levelShift(level)) & (kLevelSize - 1));
+    TimerNode list;
+    detachSlot(kRootSize + (level - 1) * kLevelSize + idx, &list, kDetached);
+    while (list.next != &list)
+    {
+        Timer *timer = static_cast<Timer*>(list.next);
+        unlink(timer);
+        insert(timer);
+    }
+}
+
+void TimerQueue::advance(uint64_t now)
+{
+    callingExpiredTimers_ = true;
+    while (currentTick_ <= now)
+    {
+        // 中间没有需要处理的槽位，直接跳过去
+        uint64_t next = nextEventTick();
+        if (next > now)
+        {
+            currentTick_ = now + 1;
+            break;
+        }
+        currentTick_ = next;
+
+        // currentTick_低位全为0的层，需要把上一层对应的槽位级联下来
+        for (int level = 1; level < kLevels; ++level)
+        {
+            if (currentTick_ & ((1ULL << levelShift(level)) - 1))
+            {
+                break;
+            }
+            cascade(level);
+        }
+
+        TimerNode expired;
+        detachSlot(static_cast<int>(currentTick_ & (kRootSize - 1)), &expired, kExpired);
+        ++currentTick_;
+
+        while (expired.next != &expired)
+        {
+            Timer *timer = static_cast<Timer*>(expired.next);
+            unlink(timer);
+            --numTimers_;
+
+            timer->setSlot(kRunning);
+            timer->run();
+
+            if (timer->repeat() && !timer->canceled())
+            {
+                timer->setExpiration(nowTick() + timer->interval());
+                insert(timer);
+                ++numTimers_;
+            }
+            else
+            {
+                freeTimer(timer);
+            }
+        }
+    }
+    callingExpiredTimers_ = false;
+}
+
+uint64_t TimerQueue::nextEventTick() const
+{
+    uint64_t next = kNever;
+
+    int offset = findNextSet(occupied_, kRootSize,
+                             static_cast<int>(currentTick_ & (kRootSize - 1)));
+    if (offset >= 0)
+    {
+        next = currentTick_ + offset;
+    }
+
+    for (int level = 1; level < kLevels; ++level)
+    {
+        int shift = levelShift(level);
+        uint64_t block = (currentTick_ + (1ULL << shift) - 1) >> shift;
+        offset = findNextSet(&occupied_[(kRootSize + (level - 1) * kLevelSize) / 64], kLevelSize,
+                             static_cast<int>(block & (kLevelSize - 1)));
+        if (offset >= 0)
+        {
+            uint64_t tick = (block + offset) << shift;
+            if (tick < next)
+            {
+                next = tick;
+            }
+        }
+    }
+    return next;
+}
+
+uint64_t TimerQueue::eventTickOf(const Timer *timer) const
+{
+    int slot = timer->slot();
+    if (slot < kRootSize)
+    {
+        return timer->expiration();
+    }
+    // 上层槽位在定时器所在区间的起点被级联
+    int shift = levelShift((slot - kRootSize) / kLevelSize + 1);
+    return (timer->expiration() >> shift) << shift;
+}
+
+void TimerQueue::resetTimerfd(uint64_t tick)
+{
+    struct itimerspec newValue;
+    ::bzero(&newValue, sizeof newValue);
+    if (tick != kNever)
+    {
+        // CLOCK_MONOTONIC上的绝对时间，tick已经过去的话timerfd会立即触发
+        newValue.it_value.tv_sec = static_cast<time_t>(tick / 1000);
+        newValue.it_value.tv_nsec = static_cast<long>((tick % 1000) * 1000 * 1000);
+    }
+    if (::timerfd_settime(timerfd_, TFD_TIMER_ABSTIME, &newValue, NULL) < 0)
+    {
+        LOG_ERROR("timerfd_settime error:%d \n", errno);
+    }
+    armedTick_ = tick;
+}
+
+void TimerQueue::handleRead()
+{
+    uint64_t howmany;
+    ssize_t n = ::read(timerfd_, &howmany, sizeof howmany);
+    if (n != sizeof howmany)
+    {
+        LOG_DEBUG("TimerQueue::handleRead() reads %ld bytes instead of 8 \n", n);
+    }
+
+    armedTick_ = kNever;
+    advance(nowTick());
+    resetTimerfd(nextEventTick());
+}
+
+uint64_t TimerQueue::nowTick()
+{
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / (1000 * 1000);
+}
+
+uint64_t TimerQueue::ticksFromSeconds(double seconds)
+{
+    uint64_t ticks = static_cast<uint64_t>(seconds * 1000 + 0.999);
+    return ticks > 0 ? ticks : 1;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Timestamp.h"
+#include "Callbacks.h"
+#include "Channel.h"
+#include "Timer.h"
+#include "TimerId.h"
+
+#include <stdint.h>
+
+class EventLoop;
+
+/**
+ * 每个EventLoop一个的定时器队列  基于timerfd + 分层时间轮
+ * tick精度为1ms，第0层256个槽，第1~4层各64个槽，最多可以表示 2^32 ms(约49天)的定时
+ * 插入和取消都是O(1)，只有新定时器比当前timerfd设定的时间更早到期时才需要调用timerfd_settime
+ *
+ * addTimer/cancel可以跨线程调用，在loop线程中调用时直接操作时间轮，不加锁也不会唤醒loop
+ */
+class TimerQueue : noncopyable
+{
+public:
+    explicit TimerQueue(EventLoop *loop);
+    ~TimerQueue();
+
+    // interval > 0 表示重复定时器，单位秒
+    TimerId addTimer(TimerCallback cb, Timestamp when, double interval);
+    void cancel(TimerId timerId);
+
+    // 当前时间轮上的定时器数量，只能在loop线程中调用
+    size_t size() const { return numTimers_; }
+private:
+    static const int kLevels = 5;
+    static const int kRootBits = 8;
+    static const int kLevelBits = 6;
+    static const int kRootSize = 1 << kRootBits;   // 第0层槽位数
+    static const int kLevelSize = 1 << kLevelBits; // 第1~4层槽位数
+    static const int kNumSlots = kRootSize + (kLevels - 1) * kLevelSize;
+    static const uint64_t kMaxSpan = (1ULL << (kRootBits + (kLevels - 1) * kLevelBits)) - 1;
+    static const uint64_t kNever = UINT64_MAX;
+
+    // 不在时间轮上的定时器的slot_
+    static const int kDetached = -1; // 空闲或者还没有加入时间轮
+    static const int kExpired = -2;  // 已到期，等待执行
+    static const int kRunning = -3;  // 回调正在执行
+
+    void handleRead(); // timerfd可读，处理到期的定时器
+
+    void addTimerInLoop(Timer *timer);
+    void cancelInLoop(TimerId timerId);
+
+    Timer* allocTimer(TimerCallback cb, uint64_t expiration, uint64_t interval);
+    void freeTimer(Timer *timer);
+
+    // 按照定时器的到期tick，把它挂到对应层的槽位上
+    void insert(Timer *timer);
+    // 把定时器从所在的链表上摘下来
+    void unlink(Timer *timer);
+    // 把某个槽位上的所有定时器移动到list上，并把它们的slot_标记为mark
+    void detachSlot(int slot, TimerNode *list, int mark);
+    // 把第level层当前的槽位重新分配到更低的层
+    void cascade(int level);
+    // 处理所有到期时间不晚于now的tick
+    void advance(uint64_t now);
+
+    // 时间轮上下一个需要处理的tick(到期或者级联)，没有定时器返回kNever
+    uint64_t nextEventTick() const;
+    // 定时器所在槽位需要被处理的tick
+    uint64_t eventTickOf(const Timer *timer) const;
+    void resetTimerfd(uint64_t tick);
+
+    static uint64_t nowTick();
+    static uint64_t ticksFromSeconds(double seconds);
+
+    EventLoop *loop_;
+    const int timerfd_;
+    Channel timerfdChannel_;
+
+    TimerNode slots_[kNumSlots];
+    uint64_t occupied_[kNumSlots / 64]; // 槽位是否非空的位图，用来快速找到下一个非空槽位
+
+    uint64_t currentTick_; // 下一个需要处理的tick
+    uint64_t armedTick_;   // timerfd当前设定的到期tick
+    size_t numTimers_;
+    bool callingExpiredTimers_;
+
+    Timer *freeList_; // 回收的Timer对象，通过next串起来
+};
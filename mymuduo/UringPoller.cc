@@ -0,0 +1,427 @@
+#include "UringPoller.h"
+
+#ifdef MUDUO_HAVE_URING
+
+#include "Logger.h"
+#include "Channel.h"
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+// channel未添加到poller中
+static const int kNew = -1;
+// channel已添加到poller中
+static const int kAdded = 1;
+// channel的事件为空，暂时不监听
+static const int kDeleted = 2;
+
+// POLL_REMOVE自己的完成事件，直接丢弃
+static const uint64_t kIgnoreToken = UINT64_MAX;
+
+static int sysIoUringSetup(unsigned entries, struct io_uring_params *p)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+static int sysIoUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags,
+                           const void *arg, size_t argsz)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argsz));
+}
+
+UringPoller::UringPoller(EventLoop *loop)
+    : Poller(loop)
+    , ringfd_(-1)
+    , sqRing_(MAP_FAILED)
+    , sqRingSize_(0)
+    , sqes_(nullptr)
+    , sqesSize_(0)
+    , toSubmit_(0)
+    , cqRing_(MAP_FAILED)
+    , cqRingSize_(0)
+{
+    if (!setupRing())
+    {
+        teardownRing();
+    }
+}
+
+UringPoller::~UringPoller()
+{
+    teardownRing();
+}
+
+bool UringPoller::setupRing()
+{
+    struct io_uring_params params;
+    ::memset(&params, 0, sizeof params);
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = kCqEntries;
+
+    ringfd_ = sysIoUringSetup(kSqEntries, &params);
+    if (ringfd_ < 0)
+    {
+        LOG_ERROR("io_uring_setup error:%d \n", errno);
+        return false;
+    }
+    // poll的超时依赖IORING_ENTER_EXT_ARG(5.11)，CQ溢出不丢事件依赖IORING_FEAT_NODROP
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP))
+    {
+        LOG_ERROR("io_uring features 0x%x not supported \n", params.features);
+        return false;
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap)
+    {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+
+    sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     ringfd_, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED)
+    {
+        LOG_ERROR("io_uring mmap sq ring error:%d \n", errno);
+        return false;
+    }
+    if (singleMmap)
+    {
+        cqRing_ = sqRing_;
+    }
+    else
+    {
+        cqRing_ = ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         ringfd_, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED)
+        {
+            LOG_ERROR("io_uring mmap cq ring error:%d \n", errno);
+            return false;
+        }
+    }
+
+    sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ringfd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        LOG_ERROR("io_uring mmap sqes error:%d \n", errno);
+        return false;
+    }
+    sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+    char *sq = static_cast<char*>(sqRing_);
+    sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqEntries_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    char *cq = static_cast<char*>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+}
+
+void UringPoller::teardownRing()
+{
+    if (sqes_)
+    {
+        ::munmap(sqes_, sqesSize_);
+        sqes_ = nullptr;
+    }
+    if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_)
+    {
+        ::munmap(cqRing_, cqRingSize_);
+    }
+    cqRing_ = MAP_FAILED;
+    if (sqRing_ != MAP_FAILED)
+    {
+        ::munmap(sqRing_, sqRingSize_);
+        sqRing_ = MAP_FAILED;
+    }
+    if (ringfd_ >= 0)
+    {
+        ::close(ringfd_);
+        ringfd_ = -1;
+    }
+}
+
+Timestamp UringPoller::poll(int timeoutMs, ChannelList *activeChannels)
+{
+    // 提交队列满了没有提交出去的取消请求，先重新提交
+    size_t pendingCancels = 0;
+    for (uint64_t token : cancels_)
+    {
+        if (!submitCancel(token))
+        {
+            cancels_[pendingCancels++] = token;
+        }
+    }
+    cancels_.resize(pendingCancels);
+
+    // 上一轮完成了的单次poll，事件已经处理过了，重新提交
+    // 提交失败的会被arm放回fired_，所以先换到rearming_里面遍历
+    rearming_.swap(fired_);
+    for (int fd : rearming_)
+    {
+        Registration &reg = registrations_[fd];
+        if (reg.channel && !reg.armed && reg.channel->index() == kAdded)
+        {
+            arm(fd);
+        }
+    }
+    rearming_.clear();
+
+    // 还有没提交出去的请求，这一轮不等待，尽快回来重试
+    if (!fired_.empty() || !cancels_.empty())
+    {
+        timeoutMs = 0;
+    }
+
+    submitAndWait(timeoutMs);
+    Timestamp now(Timestamp::now());
+    reapCompletions(activeChannels);
+    return now;
+}
+
+void UringPoller::updateChannel(Channel *channel)
+{
+    const int index = channel->index();
+    const int fd = channel->fd();
+    LOG_DEBUG("func=%s => fd=%d events=%d index=%d \n", __FUNCTION__, fd, channel->events(), index);
+
+    if (index == kNew || index == kDeleted)
+    {
+        if (index == kNew)
+        {
+            channels_[fd] = channel;
+            registration(fd).channel = channel;
+        }
+        channel->set_index(kAdded);
+        if (!channel->isNoneEvent())
+        {
+            arm(fd);
+        }
+    }
+    else // 已经注册过了，事件变化之后取消原来的poll再重新提交
+    {
+        disarm(fd);
+        if (channel->isNoneEvent())
+        {
+            channel->set_index(kDeleted);
+        }
+        else
+        {
+            arm(fd);
+        }
+    }
+}
+
+void UringPoller::removeChannel(Channel *channel)
+{
+    const int fd = channel->fd();
+    channels_.erase(fd);
+    LOG_DEBUG("func=%s => fd=%d\n", __FUNCTION__, fd);
+
+    Registration &reg = registration(fd);
+    disarm(fd);
+    reg.channel = nullptr;
+    reg.active = false;
+    reg.revents = 0;
+    channel->set_index(kNew);
+}
+
+UringPoller::Registration& UringPoller::registration(int fd)
+{
+    if (static_cast<size_t>(fd) >= registrations_.size())
+    {
+        registrations_.resize(std::max(static_cast<size_t>(fd) + 1, registrations_.size() * 2));
+    }
+    return registrations_[fd];
+}
+
+bool UringPoller::arm(int fd)
+{
+    Registration &reg = registration(fd);
+    Channel *channel = reg.channel;
+    struct io_uring_sqe *sqe = getSqe();
+    if (sqe == nullptr)
+    {
+        // 下一轮poll之前重新提交
+        reg.armed = false;
+        fired_.push_back(fd);
+        return false;
+    }
+    ++reg.generation;
+    reg.armed = true;
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = static_cast<uint32_t>(channel->events()); // EPOLLIN/EPOLLOUT和POLLIN/POLLOUT取值相同
+    sqe->len = channel->edgeTriggered() ? IORING_POLL_ADD_MULTI : 0;
+    sqe->user_data = makeToken(fd, reg.generation);
+    return true;
+}
+
+void UringPoller::disarm(int fd)
+{
+    Registration &reg = registration(fd);
+    if (!reg.armed)
+    {
+        return;
+    }
+
+    // 提交不出去的取消请求下一轮poll之前重新提交，poll请求持有文件的引用，不取消的话fd关闭之后连接也不会断开
+    const uint64_t token = makeToken(fd, reg.generation);
+    if (!submitCancel(token))
+    {
+        cancels_.push_back(token);
+    }
+
+    // 被取消的poll之后还会产生一个-ECANCELED的完成事件，generation变了就会被丢弃
+    ++reg.generation;
+    reg.armed = false;
+}
+
+bool UringPoller::submitCancel(uint64_t token)
+{
+    struct io_uring_sqe *sqe = getSqe();
+    if (sqe == nullptr)
+    {
+        return false;
+    }
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = token;
+    sqe->user_data = kIgnoreToken;
+    return true;
+}
+
+struct io_uring_sqe* UringPoller::getSqe()
+{
+    unsigned tail = *sqTail_;
+    unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    if (tail - head >= sqEntries_)
+    {
+        // 提交队列满了，先提交不等待
+        int ret = sysIoUringEnter(ringfd_, toSubmit_, 0, 0, nullptr, 0);
+        if (ret > 0)
+        {
+            toSubmit_ -= ret;
+        }
+        head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+        if (tail - head >= sqEntries_)
+        {
+            // CQ积压太多的时候内核拒绝提交(EBUSY)，要先在poll里面收割完成事件，调用者下一轮重试
+            LOG_ERROR("io_uring submission queue full \n");
+            return nullptr;
+        }
+    }
+
+    unsigned index = tail & sqMask_;
+    struct io_uring_sqe *sqe = &sqes_[index];
+    ::memset(sqe, 0, sizeof *sqe);
+    sqArray_[index] = index;
+    __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+    ++toSubmit_;
+    return sqe;
+}
+
+void UringPoller::submitAndWait(int timeoutMs)
+{
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    ::memset(&arg, 0, sizeof arg);
+    if (timeoutMs >= 0)
+    {
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = (timeoutMs % 1000) * 1000 * 1000LL;
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+
+    int ret = sysIoUringEnter(ringfd_, toSubmit_, 1,
+                              IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof arg);
+    if (ret >= 0)
+    {
+        toSubmit_ -= ret;
+    }
+    else if (errno != ETIME && errno != EINTR && errno != EBUSY)
+    {
+        LOG_ERROR("UringPoller::poll() err:%d \n", errno);
+    }
+}
+
+void UringPoller::reapCompletions(ChannelList *activeChannels)
+{
+    const size_t first = activeChannels->size();
+    unsigned head = *cqHead_;
+    unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head)
+    {
+        const struct io_uring_cqe &cqe = cqes_[head & cqMask_];
+        if (cqe.user_data == kIgnoreToken)
+        {
+            continue;
+        }
+
+        const int fd = static_cast<int>(cqe.user_data & 0xffffffff);
+        const uint32_t generation = static_cast<uint32_t>(cqe.user_data >> 32);
+        if (static_cast<size_t>(fd) >= registrations_.size())
+        {
+            continue;
+        }
+        Registration &reg = registrations_[fd];
+        if (reg.channel == nullptr || reg.generation != generation)
+        {
+            continue; // 已经被取消或者重新提交过的poll
+        }
+
+        if (!(cqe.flags & IORING_CQE_F_MORE))
+        {
+            // 单次poll完成，或者multishot poll被内核终止，下一轮重新提交
+            reg.armed = false;
+            fired_.push_back(fd);
+        }
+
+        if (cqe.res < 0)
+        {
+            reg.revents |= EPOLLERR;
+        }
+        else if (cqe.res == 0)
+        {
+            continue;
+        }
+        else
+        {
+            reg.revents |= cqe.res;
+        }
+        if (!reg.active)
+        {
+            reg.active = true;
+            activeChannels->push_back(reg.channel);
+        }
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+
+    for (size_t i = first; i < activeChannels->size(); ++i)
+    {
+        Channel *channel = (*activeChannels)[i];
+        Registration &reg = registrations_[channel->fd()];
+        channel->set_revents(reg.revents);
+        reg.revents = 0;
+        reg.active = false;
+    }
+}
+
+#endif // MUDUO_HAVE_URING
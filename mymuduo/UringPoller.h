@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Poller.h"
+#include "Timestamp.h"
+
+#include <vector>
+#include <stdint.h>
+
+class Channel;
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/**
+ * 基于io_uring的Poller  环境变量MUDUO_USE_URING选择，内核不支持时DefaultPoller退回到EPollPoller
+ * 直接使用io_uring_setup/io_uring_enter系统调用，不依赖liburing
+ *
+ * 保持和EPollPoller一样的就绪通知语义，Channel的回调仍然自己read/write：
+ *   LT模式的Channel：单次IORING_OP_POLL_ADD，事件处理完之后在下一次poll时重新提交，
+ *                    提交的时候fd仍然就绪会立刻完成，所以和epoll的LT一样不会丢事件
+ *   ET模式的Channel：multishot poll，fd每次有新的就绪状态都会产生一个完成事件，不需要重新提交
+ * 每轮poll把所有注册、修改、重新提交的SQE和等待完成事件合并成一次io_uring_enter
+ *
+ * multishot accept/recv + provided buffer ring是完成通知的模型(内核把数据读到缓冲区里再通知)，
+ * 和现有Channel的回调语义不兼容，这里没有使用
+ */
+class UringPoller : public Poller
+{
+public:
+    explicit UringPoller(EventLoop *loop);
+    ~UringPoller() override;
+
+    // io_uring是否初始化成功
+    bool valid() const { return ringfd_ >= 0; }
+
+    Timestamp poll(int timeoutMs, ChannelList *activeChannels) override;
+    void updateChannel(Channel *channel) override;
+    void removeChannel(Channel *channel) override;
+private:
+    static const unsigned kSqEntries = 1024;
+    static const unsigned kCqEntries = 16384;
+
+    // 每个fd的注册状态，用fd做下标
+    struct Registration
+    {
+        Registration() : channel(nullptr), generation(0), armed(false), active(false), revents(0) {}
+
+        Channel *channel;
+        uint32_t generation; // 每次提交POLL_ADD都加一，旧的完成事件据此丢弃
+        bool armed;          // 有一个POLL_ADD在内核中等待
+        bool active;         // 已经放进本轮的activeChannels
+        int revents;
+    };
+
+    bool setupRing();
+    void teardownRing();
+
+    // 取一个空闲的SQE，提交队列满的时候先把已有的SQE提交给内核，还是满的返回nullptr
+    io_uring_sqe* getSqe();
+    // 提交SQE并等待至少一个完成事件，timeoutMs < 0表示一直等待
+    void submitAndWait(int timeoutMs);
+    void reapCompletions(ChannelList *activeChannels);
+
+    // 提交队列满了arm返回false，fd放进fired_在下一轮poll之前重新提交
+    bool arm(int fd);
+    void disarm(int fd);
+    bool submitCancel(uint64_t token);
+    Registration& registration(int fd);
+
+    static uint64_t makeToken(int fd, uint32_t generation)
+    {
+        return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+    }
+
+    int ringfd_;
+
+    // 提交队列
+    void *sqRing_;
+    size_t sqRingSize_;
+    unsigned *sqHead_;
+    unsigned *sqTail_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    unsigned *sqArray_;
+    io_uring_sqe *sqes_;
+    size_t sqesSize_;
+    unsigned toSubmit_; // 已经放进提交队列、还没有io_uring_enter的SQE数量
+
+    // 完成队列
+    void *cqRing_; // 支持IORING_FEAT_SINGLE_MMAP时和sqRing_是同一块内存
+    size_t cqRingSize_;
+    unsigned *cqHead_;
+    unsigned *cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe *cqes_;
+
+    std::vector<Registration> registrations_;
+    std::vector<int> fired_; // 上一轮完成了的单次poll和提交失败的poll，下一轮poll之前重新提交
+    std::vector<int> rearming_; // 重新提交时和fired_交换，两个数组的内存都可以复用
+    std::vector<uint64_t> cancels_; // 提交失败的POLL_REMOVE，下一轮poll之前重新提交
+};
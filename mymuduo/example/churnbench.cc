@@ -0,0 +1,121 @@
+/**
+ * 短连接建立/关闭的压力测试
+ * 多个客户端线程不停地connect -> 等待服务器关闭 -> close，服务器在连接建立的回调里面直接shutdown，
+ * 最后输出每秒处理的连接数，用来观察TcpServer连接表和accept/close路径的开销
+ *
+ * 用法: ./churnbench main|perloop [连接总数] [客户端线程数] [subloop个数]
+ *   main:    mainLoop上的Acceptor接收连接，分配给subloop
+ *   perloop: kReusePortPerLoop模式，每个subloop各自accept
+ * 测试结果输出在stderr
+ */
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/Logger.h>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static const uint16_t kPort = 8002;
+
+static double nowSeconds()
+{
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void runClient(std::atomic<int> *remaining)
+{
+    sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    char buf[16];
+    while (remaining->fetch_sub(1) > 0)
+    {
+        int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (::connect(sockfd, (sockaddr*)&addr, sizeof addr) < 0)
+        {
+            perror("connect");
+            exit(1);
+        }
+        // 等服务器先关闭，TIME_WAIT留在服务器一侧，客户端的端口可以马上复用
+        while (::read(sockfd, buf, sizeof buf) > 0)
+        {
+        }
+        ::close(sockfd);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || (strcmp(argv[1], "main") != 0 && strcmp(argv[1], "perloop") != 0))
+    {
+        fprintf(stderr, "Usage: %s main|perloop [connections] [client threads] [threads]\n", argv[0]);
+        return 1;
+    }
+    const bool perLoop = strcmp(argv[1], "perloop") == 0;
+    const int numConns = argc > 2 ? atoi(argv[2]) : 200000;
+    const int numClients = argc > 3 ? atoi(argv[3]) : 8;
+    const int numThreads = argc > 4 ? atoi(argv[4]) : 4;
+
+    Logger::instance().setLogLevel(ERROR); // 每个连接都有INFO日志，这里只测连接表和accept/close的开销
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "ChurnBench",
+                     perLoop ? TcpServer::kReusePortPerLoop : TcpServer::kNoReusePort);
+    server.setThreadNum(numThreads);
+
+    std::atomic<int> closed(0);
+    server.setConnectionCallback([&](const TcpConnectionPtr &conn) {
+        if (conn->connected())
+        {
+            conn->shutdown();
+        }
+        else
+        {
+            ++closed;
+        }
+    });
+    server.setMessageCallback([](const TcpConnectionPtr&, Buffer *buf, Timestamp) {
+        buf->retrieveAll();
+    });
+    server.start();
+
+    double start = nowSeconds();
+    std::atomic<int> remaining(numConns);
+    std::vector<std::thread> clients;
+    for (int i = 0; i < numClients; ++i)
+    {
+        clients.emplace_back(runClient, &remaining);
+    }
+
+    double elapsed = 0;
+    loop.runEvery(0.01, [&]() {
+        if (closed >= numConns)
+        {
+            elapsed = nowSeconds() - start;
+            loop.quit();
+        }
+    });
+    loop.loop();
+
+    for (std::thread &t : clients)
+    {
+        t.join();
+    }
+
+    fprintf(stderr, "mode=%s conns=%d clients=%d threads=%d time=%.3fs rate=%.0f conn/s\n",
+            perLoop ? "perloop" : "main", numConns, numClients, numThreads, elapsed, numConns / elapsed);
+    return 0;
+}
@@ -0,0 +1,139 @@
+/**
+ * LT / ET 模式对比
+ * 多个客户端同时以小块写入的方式向服务器灌数据，服务器只统计收到的字节数，
+ * 最后输出吞吐量以及每MB数据对应的epoll_wait调用次数(所有subloop的loop迭代次数之和)
+ *
+ * 用法: ./etbench lt|et [连接数] [每个连接发送的MB] [subloop个数]
+ * 网络库的日志输出在stdout，测试结果输出在stderr:  ./etbench et > /dev/null
+ */
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/Logger.h>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const uint16_t kPort = 8001;
+static const size_t kWriteSize = 4096; // 客户端每次write的大小
+
+static double nowSeconds()
+{
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void runClient(size_t bytes)
+{
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (::connect(sockfd, (sockaddr*)&addr, sizeof addr) < 0)
+    {
+        perror("connect");
+        exit(1);
+    }
+
+    std::string data(kWriteSize, 'x');
+    while (bytes > 0)
+    {
+        size_t len = bytes < kWriteSize ? bytes : kWriteSize;
+        ssize_t n = ::write(sockfd, data.data(), len);
+        if (n <= 0)
+        {
+            perror("write");
+            break;
+        }
+        bytes -= n;
+    }
+    ::close(sockfd);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || (strcmp(argv[1], "lt") != 0 && strcmp(argv[1], "et") != 0))
+    {
+        fprintf(stderr, "Usage: %s lt|et [connections] [MB per connection] [threads]\n", argv[0]);
+        return 1;
+    }
+    const bool edgeTriggered = strcmp(argv[1], "et") == 0;
+    const int numConns = argc > 2 ? atoi(argv[2]) : 64;
+    const size_t bytesPerConn = (argc > 3 ? atoi(argv[3]) : 16) * 1024 * 1024UL;
+    const int numThreads = argc > 4 ? atoi(argv[4]) : 4;
+    const size_t totalBytes = bytesPerConn * numConns;
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "EtBench");
+    server.setThreadNum(numThreads);
+    server.setEdgeTriggered(edgeTriggered);
+
+    std::mutex mutex;
+    std::vector<EventLoop*> loops;
+    server.setThreadInitcallback([&](EventLoop *ioLoop) {
+        std::lock_guard<std::mutex> lock(mutex);
+        loops.push_back(ioLoop);
+    });
+
+    server.setConnectionCallback([](const TcpConnectionPtr&) {});
+
+    std::atomic<size_t> received(0);
+    server.setMessageCallback([&](const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+        received += buf->readableBytes();
+        buf->retrieveAll();
+    });
+    server.start();
+
+    int64_t iterationsBefore = 0;
+    for (EventLoop *ioLoop : loops)
+    {
+        iterationsBefore += ioLoop->iteration();
+    }
+
+    double start = nowSeconds();
+    std::vector<std::thread> clients;
+    for (int i = 0; i < numConns; ++i)
+    {
+        clients.emplace_back(runClient, bytesPerConn);
+    }
+
+    double elapsed = 0;
+    loop.runEvery(0.01, [&]() {
+        if (received >= totalBytes)
+        {
+            elapsed = nowSeconds() - start;
+            loop.quit();
+        }
+    });
+    loop.loop();
+
+    for (std::thread &t : clients)
+    {
+        t.join();
+    }
+
+    int64_t iterations = -iterationsBefore;
+    for (EventLoop *ioLoop : loops)
+    {
+        iterations += ioLoop->iteration();
+    }
+
+    double mb = totalBytes / (1024.0 * 1024.0);
+    fprintf(stderr, "mode=%s conns=%d threads=%d total=%.0fMB time=%.3fs throughput=%.1fMB/s "
+            "epoll_wait=%ld epoll_wait/MB=%.1f\n",
+            edgeTriggered ? "ET" : "LT", numConns, numThreads, mb, elapsed, mb / elapsed,
+            iterations, iterations / mb);
+    return 0;
+}
@@ -0,0 +1,169 @@
+/**
+ * HttpServer压力测试
+ * 服务器提供 /health 和 /metrics 两个接口；内置的客户端用keep-alive长连接，每次写入depth个流水线请求，
+ * 收齐depth个响应之后再发下一批，最后输出每秒处理的请求数
+ *
+ * 用法:
+ *   ./httpbench bench [连接数] [流水线深度] [秒数] [subloop个数]
+ *   ./httpbench server [subloop个数]     只启动服务器，用wrk测试:
+ *       wrk -t4 -c64 -d10s http://127.0.0.1:8003/health
+ * 测试结果输出在stderr
+ */
+#include <mymuduo/HttpServer.h>
+#include <mymuduo/Logger.h>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const uint16_t kPort = 8003;
+static const char kRequest[] = "GET /health HTTP/1.1\r\nHost: 127.0.0.1\r\nUser-Agent: httpbench\r\n\r\n";
+
+static double nowSeconds()
+{
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void onRequest(TcpServer *server, const HttpRequest &req, HttpResponse *resp)
+{
+    if (req.path() == "/health")
+    {
+        resp->setContentType("text/plain");
+        resp->setBody("OK\n");
+    }
+    else if (req.path() == "/metrics")
+    {
+        std::string body;
+        std::vector<LoopLoad::Snapshot> loads = server->loopLoads();
+        for (size_t i = 0; i < loads.size(); ++i)
+        {
+            char line[128];
+            snprintf(line, sizeof line, "loop_connections{loop=\"%zu\"} %ld\n", i, (long)loads[i].connections);
+            body += line;
+        }
+        resp->setContentType("text/plain");
+        resp->setBody(std::move(body));
+    }
+    else
+    {
+        resp->setStatus(404);
+    }
+}
+
+static void runClient(int depth, double deadline, std::atomic<long> *completed)
+{
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (::connect(sockfd, (sockaddr*)&addr, sizeof addr) < 0)
+    {
+        perror("connect");
+        exit(1);
+    }
+
+    std::string batch;
+    for (int i = 0; i < depth; ++i)
+    {
+        batch += kRequest;
+    }
+
+    // 先发一个请求得到响应的长度，/health的响应长度是固定的
+    char buf[65536];
+    ::write(sockfd, kRequest, sizeof kRequest - 1);
+    ssize_t responseLen = ::read(sockfd, buf, sizeof buf);
+    if (responseLen <= 0)
+    {
+        perror("read");
+        exit(1);
+    }
+
+    long count = 0;
+    while (nowSeconds() < deadline)
+    {
+        if (::write(sockfd, batch.data(), batch.size()) != static_cast<ssize_t>(batch.size()))
+        {
+            perror("write");
+            break;
+        }
+        size_t expected = responseLen * depth;
+        while (expected > 0)
+        {
+            ssize_t n = ::read(sockfd, buf, sizeof buf);
+            if (n <= 0)
+            {
+                perror("read");
+                exit(1);
+            }
+            expected -= n;
+        }
+        count += depth;
+    }
+    *completed += count;
+    ::close(sockfd);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || (strcmp(argv[1], "bench") != 0 && strcmp(argv[1], "server") != 0))
+    {
+        fprintf(stderr, "Usage: %s bench [connections] [pipeline depth] [seconds] [threads]\n"
+                        "       %s server [threads]\n", argv[0], argv[0]);
+        return 1;
+    }
+    const bool serverOnly = strcmp(argv[1], "server") == 0;
+    const int numConns = !serverOnly && argc > 2 ? atoi(argv[2]) : 64;
+    const int depth = !serverOnly && argc > 3 ? atoi(argv[3]) : 1;
+    const double seconds = !serverOnly && argc > 4 ? atof(argv[4]) : 5;
+    const int numThreads = serverOnly ? (argc > 2 ? atoi(argv[2]) : 4) : (argc > 5 ? atoi(argv[5]) : 4);
+
+    Logger::instance().setLogLevel(ERROR);
+
+    EventLoop loop;
+    HttpServer server(&loop, InetAddress(kPort), "HttpBench");
+    server.setThreadNum(numThreads);
+    server.setHttpCallback(std::bind(onRequest, &server.tcpServer(),
+        std::placeholders::_1, std::placeholders::_2));
+    server.start();
+
+    if (serverOnly)
+    {
+        loop.loop();
+        return 0;
+    }
+
+    std::atomic<long> completed(0);
+    double start = nowSeconds();
+    std::vector<std::thread> clients;
+    for (int i = 0; i < numConns; ++i)
+    {
+        clients.emplace_back(runClient, depth, start + seconds, &completed);
+    }
+    std::thread waiter([&]() {
+        for (std::thread &t : clients)
+        {
+            t.join();
+        }
+        loop.quit();
+    });
+    loop.loop();
+    waiter.join();
+
+    double elapsed = nowSeconds() - start;
+    fprintf(stderr, "conns=%d depth=%d threads=%d requests=%ld time=%.3fs rate=%.0f req/s\n",
+            numConns, depth, numThreads, completed.load(), elapsed, completed / elapsed);
+    return 0;
+}
@@ -0,0 +1,160 @@
+/**
+ * EPollPoller / UringPoller 对比
+ * 小消息echo：每个客户端发送一条消息，等服务器原样返回之后再发下一条，
+ * 输出每秒往返次数以及往返延迟的p50/p99/max
+ *
+ * 用法: ./pollerbench epoll|uring [连接数] [每个连接的往返次数] [消息字节数] [subloop个数] [et]
+ * 网络库的日志输出在stdout，测试结果输出在stderr:  ./pollerbench uring > /dev/null
+ */
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/Logger.h>
+
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const uint16_t kPort = 8002;
+
+static double nowSeconds()
+{
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 每次往返的延迟(微秒)写到latencies里面
+static void runClient(int rounds, size_t msgSize, std::vector<double> *latencies)
+{
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    ::setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof on);
+    sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (::connect(sockfd, (sockaddr*)&addr, sizeof addr) < 0)
+    {
+        perror("connect");
+        exit(1);
+    }
+
+    std::string data(msgSize, 'x');
+    std::vector<char> reply(msgSize);
+    latencies->reserve(rounds);
+    for (int i = 0; i < rounds; ++i)
+    {
+        double start = nowSeconds();
+        if (::write(sockfd, data.data(), msgSize) != static_cast<ssize_t>(msgSize))
+        {
+            perror("write");
+            break;
+        }
+        size_t got = 0;
+        while (got < msgSize)
+        {
+            ssize_t n = ::read(sockfd, reply.data() + got, msgSize - got);
+            if (n <= 0)
+            {
+                perror("read");
+                exit(1);
+            }
+            got += n;
+        }
+        latencies->push_back((nowSeconds() - start) * 1e6);
+    }
+    ::close(sockfd);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || (strcmp(argv[1], "epoll") != 0 && strcmp(argv[1], "uring") != 0))
+    {
+        fprintf(stderr, "Usage: %s epoll|uring [connections] [rounds per connection] [message size] "
+                "[threads] [et]\n", argv[0]);
+        return 1;
+    }
+    const bool uring = strcmp(argv[1], "uring") == 0;
+    const int numConns = argc > 2 ? atoi(argv[2]) : 64;
+    const int rounds = argc > 3 ? atoi(argv[3]) : 20000;
+    const size_t msgSize = argc > 4 ? atoi(argv[4]) : 64;
+    const int numThreads = argc > 5 ? atoi(argv[5]) : 4;
+    const bool edgeTriggered = argc > 6 && strcmp(argv[6], "et") == 0;
+
+    // Poller在EventLoop构造的时候选择，必须在创建任何EventLoop之前设置
+    if (uring)
+    {
+        ::setenv("MUDUO_USE_URING", "1", 1);
+    }
+    else
+    {
+        ::unsetenv("MUDUO_USE_URING");
+    }
+    Logger::instance().setLogLevel(ERROR);
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "PollerBench");
+    server.setThreadNum(numThreads);
+    server.setEdgeTriggered(edgeTriggered);
+    server.setConnectionCallback([](const TcpConnectionPtr&) {});
+    server.setMessageCallback([](const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+        conn->send(buf);
+    });
+    server.start();
+
+    std::vector<std::vector<double>> latencies(numConns);
+    std::atomic<int> finished(0);
+    double start = nowSeconds();
+    std::vector<std::thread> clients;
+    for (int i = 0; i < numConns; ++i)
+    {
+        clients.emplace_back([&, i]() {
+            runClient(rounds, msgSize, &latencies[i]);
+            ++finished;
+        });
+    }
+
+    double elapsed = 0;
+    loop.runEvery(0.01, [&]() {
+        if (finished == numConns)
+        {
+            elapsed = nowSeconds() - start;
+            loop.quit();
+        }
+    });
+    loop.loop();
+
+    for (std::thread &t : clients)
+    {
+        t.join();
+    }
+
+    std::vector<double> all;
+    for (const std::vector<double> &v : latencies)
+    {
+        all.insert(all.end(), v.begin(), v.end());
+    }
+    std::sort(all.begin(), all.end());
+    if (all.empty())
+    {
+        return 1;
+    }
+
+    fprintf(stderr, "poller=%s mode=%s conns=%d threads=%d msg=%zuB rounds=%zu time=%.3fs "
+            "throughput=%.0f msg/s latency p50=%.1fus p99=%.1fus max=%.1fus\n",
+            uring ? "uring" : "epoll", edgeTriggered ? "ET" : "LT", numConns, numThreads, msgSize,
+            all.size(), elapsed, all.size() / elapsed,
+            all[all.size() / 2], all[all.size() * 99 / 100], all.back());
+    return 0;
+}
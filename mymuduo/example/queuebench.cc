@@ -0,0 +1,74 @@
+/**
+ * 跨线程runInLoop的吞吐量测试
+ * 1~16个生产者线程同时向同一个loop投递空任务，统计每秒能够执行的任务数，
+ * 以及loop被唤醒的次数(loop迭代次数)
+ *
+ * 用法: ./queuebench [每个生产者投递的任务数]
+ * 网络库的日志输出在stdout，测试结果输出在stderr:  ./queuebench > /dev/null
+ */
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static double nowSeconds()
+{
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    const long tasksPerProducer = argc > 1 ? atol(argv[1]) : 1000000;
+
+    EventLoopThread loopThread;
+    EventLoop *loop = loopThread.startLoop();
+
+    const int producerCounts[] = {1, 2, 4, 8, 16};
+    for (int numProducers : producerCounts)
+    {
+        const long total = tasksPerProducer * numProducers;
+        long executed = 0; // 只在loop线程中修改
+        std::atomic<bool> done(false);
+        int64_t iterationsBefore = loop->iteration();
+
+        double start = nowSeconds();
+        std::vector<std::thread> producers;
+        for (int i = 0; i < numProducers; ++i)
+        {
+            producers.emplace_back([&]() {
+                for (long j = 0; j < tasksPerProducer; ++j)
+                {
+                    loop->runInLoop([&]() {
+                        if (++executed == total)
+                        {
+                            done = true;
+                        }
+                    });
+                }
+            });
+        }
+        for (std::thread &t : producers)
+        {
+            t.join();
+        }
+        while (!done)
+        {
+            ::usleep(100);
+        }
+        double elapsed = nowSeconds() - start;
+
+        fprintf(stderr, "producers=%2d tasks=%ld time=%.3fs calls/s=%.0f wakeups=%ld\n",
+                numProducers, total, elapsed, total / elapsed,
+                loop->iteration() - iterationsBefore);
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+/**
+ * FunctorQueue多生产者压力测试
+ * 多个生产者线程同时push，消费者线程不停地drain，队列经常在空和非空之间切换，
+ * 容易碰到pop()把stub_放回队尾时生产者还没有链接上next的中间状态
+ * 生产者全部结束之后，消费者必须能在有限时间内执行完所有任务，否则说明有任务被滞留在队列里面
+ *
+ * 用法: ./queuestress [轮数] [每个生产者投递的任务数]
+ */
+#include <mymuduo/FunctorQueue.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static double nowSeconds()
+{
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    const int rounds = argc > 1 ? atoi(argv[1]) : 20;
+    const long tasksPerProducer = argc > 2 ? atol(argv[2]) : 100000;
+    const int numProducers = 4;
+    const long total = tasksPerProducer * numProducers;
+
+    for (int round = 0; round < rounds; ++round)
+    {
+        FunctorQueue queue;
+        long executed = 0; // 只在消费者线程中修改
+        std::atomic<int> running(numProducers);
+
+        std::vector<std::thread> producers;
+        for (int i = 0; i < numProducers; ++i)
+        {
+            producers.emplace_back([&]() {
+                for (long j = 0; j < tasksPerProducer; ++j)
+                {
+                    queue.push([&executed]() { ++executed; });
+                }
+                --running;
+            });
+        }
+
+        // 生产者结束之后最多再等2秒
+        double deadline = 0;
+        while (executed < total)
+        {
+            queue.drain();
+            if (running == 0)
+            {
+                if (deadline == 0)
+                {
+                    deadline = nowSeconds() + 2;
+                }
+                else if (nowSeconds() > deadline)
+                {
+                    break;
+                }
+            }
+        }
+
+        for (std::thread &t : producers)
+        {
+            t.join();
+        }
+        if (executed != total)
+        {
+            fprintf(stderr, "round %d: executed %ld of %ld tasks, the rest are stranded in the queue\n",
+                    round, executed, total);
+            return 1;
+        }
+    }
+    fprintf(stderr, "%d rounds x %d producers x %ld tasks: ok\n", rounds, numProducers, tasksPerProducer);
+    return 0;
+}
@@ -48,11 +48,15 @@ struct ConnectionStats {
     size_t total_requests;          // 总请求数
     size_t successful_requests;     // 成功请求数
     size_t failed_requests;         // 失败请求数
+    size_t ssl_handshakes;          // 成功的SSL握手数
+    size_t ssl_resumed_handshakes;  // 其中复用会话的握手数
+    uint64_t ssl_handshake_time_us; // SSL握手累计耗时（微秒）
     
     ConnectionStats() 
         : total_connections(0), active_connections(0), idle_connections(0)
         , failed_connections(0), total_requests(0), successful_requests(0)
-        , failed_requests(0) {}
+        , failed_requests(0), ssl_handshakes(0), ssl_resumed_handshakes(0)
+        , ssl_handshake_time_us(0) {}
 };
 
 /**
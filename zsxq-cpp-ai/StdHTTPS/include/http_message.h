@@ -330,6 +330,30 @@ public:
      * @return 参数值，如果不存在返回空字符串
      */
     std::string get_query_param(const std::string& name) const;
+    
+    /**
+     * @brief 路径参数类型（按模式中出现的顺序排列的名称和值）
+     */
+    using PathParams = std::vector<std::pair<std::string, std::string>>;
+    
+    /**
+     * @brief 设置路径参数
+     * @param params 路由匹配得到的路径参数
+     * @note 路径参数是路由匹配的结果而不是报文的一部分，所以可以在const请求上设置
+     */
+    void set_path_params(PathParams params) const { path_params_ = std::move(params); }
+    
+    /**
+     * @brief 获取全部路径参数
+     */
+    const PathParams& get_path_params() const { return path_params_; }
+    
+    /**
+     * @brief 获取指定路径参数值（路由模式中的 :name 或 *name）
+     * @param name 参数名称
+     * @return 参数值，如果不存在返回空字符串
+     */
+    std::string get_path_param(const std::string& name) const;
 
     // 便捷方法
     /**
@@ -372,6 +396,7 @@ private:
     std::string uri_;               // 完整URI
     std::string path_;              // URI路径部分
     std::string query_;             // URI查询参数部分
+    mutable PathParams path_params_; // 路由匹配得到的路径参数
 };
 
 /**
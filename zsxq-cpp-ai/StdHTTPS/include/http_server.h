@@ -23,6 +23,7 @@ namespace stdhttps {
 
 // 前向声明
 class HttpServerConnection;
+class HttpServerWorker;
 class HttpServer;
 
 /**
@@ -93,22 +94,30 @@ struct HttpServerStats {
 
 /**
  * @brief HTTP路由管理器
- * @details 管理URL路由和请求处理器的映射
+ * @details 管理URL路由和请求处理器的映射。
+ *          路由按HTTP方法分成多棵基数树（压缩前缀树），路径模式支持：
+ *          - 静态路径：/api/users
+ *          - 路径参数：/api/users/:id，匹配一个路径段（到下一个'/'为止）
+ *          - 通配符：*path，匹配剩余的全部路径，后面可以跟固定的后缀（如 *.png）
+ *          匹配优先级为 静态 > 参数 > 通配符，与添加顺序无关；完全相同的模式以先添加的为准。
+ *          路由表编译后不再修改，修改路由时重新编译并原子替换（RCU），
+ *          查找时不加锁，旧的路由表在所有读者离开之后释放。
  */
 class HttpRouter {
 public:
+    HttpRouter();
+    ~HttpRouter();
+    
     /**
-     * @brief 路由匹配函数类型
-     * @param method HTTP方法
-     * @param path URL路径
-     * @return 是否匹配
+     * @brief 禁用拷贝构造
      */
-    using RouteMatcher = std::function<bool(HttpMethod method, const std::string& path)>;
+    HttpRouter(const HttpRouter&) = delete;
+    HttpRouter& operator=(const HttpRouter&) = delete;
 
     /**
      * @brief 添加路由
      * @param method HTTP方法
-     * @param path URL路径（支持简单的通配符）
+     * @param path URL路径（支持 :param 和 *wildcard）
      * @param handler 请求处理器
      */
     void add_route(HttpMethod method, const std::string& path, RequestHandler handler);
@@ -157,43 +166,64 @@ public:
     
     /**
      * @brief 路由请求
-     * @param request HTTP请求
+     * @param request HTTP请求（匹配到的路径参数写入request的path_params）
      * @param response HTTP响应
      * @return 是否找到匹配的路由
      */
     bool route_request(const HttpRequest& request, HttpResponse& response);
+    
+    /**
+     * @brief 获取路由数量
+     */
+    size_t route_count() const;
 
 private:
+    using HandlerPtr = std::shared_ptr<const RequestHandler>;
+    
     struct Route {
         HttpMethod method;
         std::string path;
-        RequestHandler handler;
-        RouteMatcher matcher;
+        HandlerPtr handler;
         
-        Route(HttpMethod m, const std::string& p, RequestHandler h)
-            : method(m), path(p), handler(h) {
-            matcher = create_matcher(p);
-        }
+        Route(HttpMethod m, const std::string& p, HandlerPtr h)
+            : method(m), path(p), handler(h) {}
     };
     
-    static RouteMatcher create_matcher(const std::string& path);
-    static bool match_path(const std::string& pattern, const std::string& path);
+    struct RouteTable;
+    
+    /**
+     * @brief 读者计数，填充到一个缓存行，避免两个计数器互相干扰
+     */
+    struct ReaderCount {
+        std::atomic<size_t> count{0};
+        char padding[64 - sizeof(std::atomic<size_t>)];
+    };
+    
+    void publish_locked();
     
 private:
-    std::vector<Route> routes_;
-    RequestHandler default_handler_;
-    mutable std::mutex routes_mutex_;
+    std::vector<Route> routes_;         // 路由定义，只在写锁下修改
+    HandlerPtr default_handler_;        // 默认处理器
+    mutable std::mutex routes_mutex_;   // 写锁，只用于串行化路由修改
+    
+    // RCU：读者进入时在当前epoch对应的计数器上加一，写者替换路由表后等待两个计数器都归零
+    std::atomic<const RouteTable*> table_;
+    std::atomic<unsigned> epoch_;
+    ReaderCount readers_[2];
 };
 
 /**
  * @brief HTTP服务器连接类
- * @details 处理单个客户端连接的HTTP通信
+ * @details 非阻塞的连接状态机，由所属的工作线程在可读、可写和超时时驱动。
+ *          读到的数据先放入输入缓冲区，逐个解析出完整的请求（支持流水线），
+ *          响应追加到输出缓冲区，发送不完的部分等待下一次可写事件。
+ *          启用SSL时通过内存BIO的SSLHandler完成非阻塞握手和加解密。
  */
 class HttpServerConnection {
 public:
     /**
      * @brief 构造函数
-     * @param socket_fd 客户端socket
+     * @param socket_fd 客户端socket（非阻塞）
      * @param server 服务器实例
      */
     HttpServerConnection(int socket_fd, HttpServer* server);
@@ -210,15 +240,41 @@ public:
     HttpServerConnection& operator=(const HttpServerConnection&) = delete;
 
     /**
-     * @brief 处理连接
+     * @brief 处理可读事件：读取所有可用数据并处理其中完整的请求
+     * @return 连接是否继续保持，false表示应当关闭
      */
-    void handle_connection();
+    bool on_readable();
+    
+    /**
+     * @brief 处理可写事件：继续发送输出缓冲区中的数据
+     * @return 连接是否继续保持，false表示应当关闭
+     */
+    bool on_writable();
+    
+    /**
+     * @brief 检查超时
+     * @param now 当前时间
+     * @return 连接是否继续保持，false表示应当关闭
+     * @details 空闲连接超过keep_alive_timeout直接关闭，
+     *          请求接收不完整超过request_timeout回复408后关闭
+     */
+    bool check_timeout(std::chrono::steady_clock::time_point now);
+    
+    /**
+     * @brief 是否有数据等待发送（需要关注可写事件）
+     */
+    bool want_write() const { return !write_buffer_.empty(); }
     
     /**
      * @brief 关闭连接
      */
     void close();
     
+    /**
+     * @brief 获取socket
+     */
+    int get_socket() const { return socket_fd_; }
+    
     /**
      * @brief 获取客户端地址
      */
@@ -231,8 +287,11 @@ public:
 
 private:
     bool setup_ssl();
-    bool read_request(HttpRequest& request);
-    bool send_response(const HttpResponse& response);
+    bool read_input();
+    bool process_requests();
+    bool process_output();
+    bool flush_output();
+    void queue_response(const HttpResponse& response);
     void handle_request(const HttpRequest& request, HttpResponse& response);
     void send_error_response(int status_code, const std::string& message = "");
     
@@ -240,19 +299,103 @@ private:
     int socket_fd_;                     // 客户端socket
     HttpServer* server_;                // 服务器实例
     std::string client_address_;        // 客户端地址
-    std::atomic<bool> active_;          // 是否活跃
+    bool active_;                       // 是否活跃
+    bool close_after_write_;            // 输出缓冲区发送完之后关闭
+    uint32_t events_;                   // 当前在epoll中关注的事件（由工作线程维护）
+    std::chrono::steady_clock::time_point last_active_; // 最后一次收发数据的时间，用于keep-alive空闲超时
     
     // SSL相关
     std::unique_ptr<SSLHandler> ssl_handler_;
     
+    // 请求解析
+    HttpRequest request_;               // 正在解析的请求
+    bool request_started_;              // 当前请求是否已经收到部分数据
+    std::chrono::steady_clock::time_point request_start_; // 当前请求收到第一个字节的时间，用于请求超时
+    
     // 缓冲区
-    std::string read_buffer_;
-    static constexpr size_t BUFFER_SIZE = 8192;
+    std::string read_buffer_;           // 收到但还没有解析的明文数据
+    std::string write_buffer_;          // 等待发送的数据（SSL时为密文）
+    static constexpr size_t BUFFER_SIZE = 16384;
+    
+    friend class HttpServerWorker;
+};
+
+/**
+ * @brief HTTP服务器工作线程
+ * @details 每个工作线程拥有一个epoll实例，以非阻塞方式同时处理分配给它的所有连接。
+ *          接受线程通过add_connection投递新连接，并用eventfd唤醒工作线程。
+ */
+class HttpServerWorker {
+public:
+    /**
+     * @brief 构造函数
+     * @param server 服务器实例
+     */
+    explicit HttpServerWorker(HttpServer* server);
+    
+    /**
+     * @brief 析构函数
+     */
+    ~HttpServerWorker();
+    
+    /**
+     * @brief 禁用拷贝构造
+     */
+    HttpServerWorker(const HttpServerWorker&) = delete;
+    HttpServerWorker& operator=(const HttpServerWorker&) = delete;
+
+    /**
+     * @brief 创建epoll和唤醒用的eventfd，启动线程
+     * @return 是否成功
+     */
+    bool start();
+    
+    /**
+     * @brief 通知线程退出，线程退出时关闭所有连接
+     */
+    void stop();
+    
+    /**
+     * @brief 等待线程结束
+     */
+    void join();
+    
+    /**
+     * @brief 投递新连接（线程安全）
+     * @param socket_fd 已经接受的客户端socket
+     */
+    void add_connection(int socket_fd);
+
+private:
+    void run();
+    void accept_pending();
+    void handle_event(HttpServerConnection* connection, uint32_t events);
+    bool update_events(HttpServerConnection* connection);
+    void close_connection(HttpServerConnection* connection);
+    void check_timeouts();
+    
+private:
+    HttpServer* server_;                // 服务器实例
+    int epoll_fd_;                      // epoll实例
+    int wakeup_fd_;                     // 唤醒用的eventfd
+    std::atomic<bool> running_;         // 运行状态
+    std::thread thread_;                // 线程
+    
+    // 接受线程投递的新连接
+    std::vector<int> pending_sockets_;
+    std::mutex pending_mutex_;
+    
+    // 本线程管理的连接，只在本线程中访问
+    std::unordered_map<int, std::unique_ptr<HttpServerConnection>> connections_;
+    
+    static constexpr int MAX_EVENTS = 1024;
+    static constexpr int TIMEOUT_CHECK_INTERVAL_MS = 1000;
 };
 
 /**
  * @brief HTTP服务器类
- * @details 多线程HTTP/HTTPS服务器实现
+ * @details 多线程HTTP/HTTPS服务器实现：一个接受线程按轮询分配连接，
+ *          每个工作线程运行一个epoll反应堆，同时处理成千上万的keep-alive连接
  */
 class HttpServer {
 public:
@@ -363,10 +506,6 @@ private:
     bool initialize_socket();
     bool initialize_ssl();
     void accept_loop();
-    void worker_thread();
-    void add_connection(std::unique_ptr<HttpServerConnection> connection);
-    void remove_connection(HttpServerConnection* connection);
-    void cleanup_connections();
     std::string get_mime_type(const std::string& file_path) const;
     bool serve_file(const std::string& file_path, HttpResponse& response);
     
@@ -380,13 +519,8 @@ private:
     
     // 线程管理
     std::thread accept_thread_;         // 接受连接的线程
-    std::vector<std::thread> worker_threads_; // 工作线程
-    
-    // 连接管理
-    std::vector<std::unique_ptr<HttpServerConnection>> connections_; // 活跃连接
-    std::queue<std::unique_ptr<HttpServerConnection>> connection_queue_; // 连接队列
-    std::mutex connections_mutex_;      // 连接互斥锁
-    std::condition_variable connections_condition_; // 连接条件变量
+    std::vector<std::unique_ptr<HttpServerWorker>> workers_; // 工作线程
+    size_t next_worker_;                // 下一个分配连接的工作线程
     
     // 请求处理
     HttpRouter router_;                 // 路由管理器
@@ -397,6 +531,7 @@ private:
     HttpServerStats stats_;
     
     friend class HttpServerConnection;
+    friend class HttpServerWorker;
 };
 
 /**
@@ -11,10 +11,16 @@
 #include <functional>
 #include <vector>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <unordered_map>
+#include <cstdint>
 
 // 前向声明OpenSSL结构体
 typedef struct ssl_st SSL;
 typedef struct ssl_ctx_st SSL_CTX;
+typedef struct ssl_session_st SSL_SESSION;
 typedef struct bio_st BIO;
 typedef struct x509_st X509;
 typedef struct evp_pkey_st EVP_PKEY;
@@ -62,16 +68,143 @@ struct SSLConfig {
     bool verify_peer;               // 是否验证对端证书
     bool verify_hostname;           // 是否验证主机名
     int verify_depth;               // 证书链验证深度
+    bool enable_session_resumption; // 是否启用会话复用
+    bool enable_session_tickets;    // 服务器是否签发session ticket，关闭时只用会话缓存
+    std::chrono::seconds session_timeout;      // 会话（ticket）有效期
+    std::chrono::seconds ticket_key_rotation;  // ticket密钥轮换周期，0表示不自动轮换
+    size_t session_cache_size;      // 会话缓存最多保存的会话数
     
     SSLConfig() 
         : verify_peer(true)
         , verify_hostname(true) 
-        , verify_depth(9) {}
+        , verify_depth(9)
+        , enable_session_resumption(true)
+        , enable_session_tickets(true)
+        , session_timeout(7200)
+        , ticket_key_rotation(3600)
+        , session_cache_size(20480) {}
 };
 
+/**
+ * @brief SSL握手统计信息
+ * @details 握手耗时从开始握手算到握手完成，包含网络往返时间
+ */
+struct SSLHandshakeStats {
+    std::atomic<size_t> full_handshakes{0};        // 完整握手次数
+    std::atomic<size_t> resumed_handshakes{0};     // 复用会话的握手次数
+    std::atomic<size_t> failed_handshakes{0};      // 失败的握手次数
+    std::atomic<uint64_t> full_handshake_us{0};    // 完整握手累计耗时（微秒）
+    std::atomic<uint64_t> resumed_handshake_us{0}; // 复用握手累计耗时（微秒）
+    
+    SSLHandshakeStats() = default;
+    
+    // Copy constructor for atomic members
+    SSLHandshakeStats(const SSLHandshakeStats& other)
+        : full_handshakes(other.full_handshakes.load())
+        , resumed_handshakes(other.resumed_handshakes.load())
+        , failed_handshakes(other.failed_handshakes.load())
+        , full_handshake_us(other.full_handshake_us.load())
+        , resumed_handshake_us(other.resumed_handshake_us.load()) {
+    }
+    
+    /**
+     * @brief 成功的握手次数
+     */
+    size_t total_handshakes() const { return full_handshakes + resumed_handshakes; }
+    
+    /**
+     * @brief 会话复用率（0~1）
+     */
+    double resumption_rate() const {
+        size_t total = total_handshakes();
+        return total ? static_cast<double>(resumed_handshakes) / total : 0.0;
+    }
+};
+
+/**
+ * @brief SSL会话缓存
+ * @details 线程安全的LRU缓存，按字符串键保存SSL_SESSION（缓存持有一个引用），
+ *          过期的会话在查找时丢弃。
+ *          服务器端所有SSL上下文共用shared()这个进程内缓存，按会话ID查找；
+ *          客户端每个SSLContextManager有自己的缓存，按host:port查找，
+ *          避免验证设置不同的上下文之间复用未经验证的会话。
+ */
+class SSLSessionCache {
+public:
+    explicit SSLSessionCache(size_t capacity = 20480);
+    ~SSLSessionCache();
+    
+    SSLSessionCache(const SSLSessionCache&) = delete;
+    SSLSessionCache& operator=(const SSLSessionCache&) = delete;
+    
+    /**
+     * @brief 进程内共享的服务器端会话缓存
+     */
+    static SSLSessionCache& shared();
+    
+    /**
+     * @brief 保存会话，替换同一个键下原来的会话
+     * @param key 键
+     * @param session 会话，缓存会增加它的引用计数
+     */
+    void put(const std::string& key, SSL_SESSION* session);
+    
+    /**
+     * @brief 查找会话
+     * @param key 键
+     * @return 会话（已增加引用计数，调用者负责SSL_SESSION_free），没有或已过期返回nullptr
+     */
+    SSL_SESSION* get(const std::string& key);
+    
+    /**
+     * @brief 删除会话
+     */
+    void remove(const std::string& key);
+    
+    /**
+     * @brief 设置最多保存的会话数，超出时淘汰最久未使用的
+     */
+    void set_capacity(size_t capacity);
+    
+    /**
+     * @brief 容量至少为capacity，只增不减，多个使用者共享同一个缓存时使用
+     */
+    void grow_capacity(size_t capacity);
+    
+    /**
+     * @brief 当前保存的会话数
+     */
+    size_t size() const;
+    
+    /**
+     * @brief 清空缓存
+     */
+    void clear();
+
+private:
+    struct Entry {
+        SSL_SESSION* session;
+        std::list<std::string>::iterator pos;
+    };
+    
+    void erase_locked(std::unordered_map<std::string, Entry>::iterator it);
+    void evict_locked();
+    
+private:
+    mutable std::mutex mutex_;
+    std::list<std::string> lru_;                      // 最近使用的在前面
+    std::unordered_map<std::string, Entry> entries_;
+    size_t capacity_;
+};
+
+struct SSLSessionCallbacks;
+
 /**
  * @brief SSL上下文管理器
- * @details 管理SSL_CTX的生命周期和配置
+ * @details 管理SSL_CTX的生命周期和配置。
+ *          启用会话复用时，服务器端用定期轮换的密钥签发session ticket，
+ *          并把会话保存在进程内共享的会话缓存中；客户端按host:port保存服务器签发的会话，
+ *          重连时复用，省去完整握手。握手次数和耗时记录在握手统计中。
  */
 class SSLContextManager {
 public:
@@ -142,15 +275,76 @@ public:
      * @return 是否成功
      */
     bool set_cipher_list(const std::string& cipher_list);
+    
+    /**
+     * @brief 立即生成新的session ticket密钥
+     * @details 新签发的ticket使用新密钥；旧密钥签发的ticket在会话有效期内仍然可以复用，
+     *          复用时会换发新密钥的ticket
+     */
+    void rotate_ticket_keys();
+    
+    /**
+     * @brief 取出客户端为key保存的会话
+     * @param key 会话键（host:port）
+     * @return 会话（调用者负责SSL_SESSION_free），没有返回nullptr
+     */
+    SSL_SESSION* get_client_session(const std::string& key);
+    
+    /**
+     * @brief 保存客户端会话，替换key下原来的会话
+     * @param key 会话键（host:port）
+     * @param session 会话，管理器会增加它的引用计数
+     */
+    void set_client_session(const std::string& key, SSL_SESSION* session);
+    
+    /**
+     * @brief 记录一次握手的结果，由SSLHandler在握手结束时调用
+     * @param success 是否成功
+     * @param resumed 是否复用了会话
+     * @param elapsed 握手耗时
+     */
+    void record_handshake(bool success, bool resumed, std::chrono::microseconds elapsed);
+    
+    /**
+     * @brief 获取握手统计信息
+     */
+    SSLHandshakeStats get_handshake_stats() const;
+    
+    /**
+     * @brief 根据SSL_CTX找到所属的管理器
+     * @return 管理器，不是由SSLContextManager创建的上下文返回nullptr
+     */
+    static SSLContextManager* from_context(SSL_CTX* ssl_ctx);
 
 private:
+    friend struct SSLSessionCallbacks;
+    
+    /**
+     * @brief session ticket密钥
+     */
+    struct TicketKey {
+        unsigned char name[16];     // 密钥名，写在ticket开头用于查找密钥
+        unsigned char aes_key[32];  // AES-256-CBC加密密钥
+        unsigned char hmac_key[32]; // HMAC-SHA256密钥
+        std::chrono::steady_clock::time_point created;
+    };
+    
+    struct SessionState;
+    
     void cleanup();
     void set_error(const std::string& message);
+    bool setup_session_resumption(const SSLConfig& config);
+    bool compute_session_id_context(const SSLConfig& config, unsigned char* sid_ctx, unsigned int* sid_ctx_len);
+    bool current_ticket_key(TicketKey& key);
+    bool find_ticket_key(const unsigned char* name, TicketKey& key, bool& renew);
+    bool rotate_ticket_keys_locked(std::chrono::steady_clock::time_point now);
+    void prune_ticket_keys_locked(std::chrono::steady_clock::time_point now);
     
 private:
     SSL_CTX* ssl_ctx_;              // SSL上下文
     bool is_server_;                // 是否为服务器模式
     std::string error_message_;     // 错误信息
+    std::unique_ptr<SessionState> session_; // 会话复用的状态和握手统计，移动时只转移指针
 };
 
 /**
@@ -197,6 +391,24 @@ public:
      */
     void set_write_callback(WriteCallback callback);
     
+    /**
+     * @brief 设置客户端会话复用的键
+     * @details 在start_handshake之前调用。如果上下文中保存了这个键的会话就尝试复用，
+     *          握手后服务器签发的新会话也保存到这个键下
+     * @param key 会话键，通常为host:port
+     */
+    void set_session_key(const std::string& key);
+    
+    /**
+     * @brief 获取会话复用的键
+     */
+    const std::string& get_session_key() const { return session_key_; }
+    
+    /**
+     * @brief 握手是否复用了之前的会话
+     */
+    bool is_session_reused() const;
+    
     /**
      * @brief 开始SSL握手
      * @return 是否成功开始握手
@@ -273,6 +485,7 @@ private:
     void set_error(const std::string& message);
     SSLError handle_ssl_error(int ssl_error);
     void flush_bio_write();
+    void finish_handshake(bool success);
     
 private:
     SSL* ssl_;                      // SSL连接对象
@@ -282,6 +495,8 @@ private:
     bool is_server_;                // 是否为服务器模式
     WriteCallback write_callback_;  // 数据输出回调
     std::string last_error_;        // 最后的错误信息
+    std::string session_key_;       // 会话复用的键
+    std::chrono::steady_clock::time_point handshake_start_; // 开始握手的时间
     std::mutex mutex_;              // 线程安全锁
 };
 
@@ -391,6 +606,8 @@ public:
     SSLServerConfigBuilder& protocol_version(const std::string& version);
     SSLServerConfigBuilder& verify_peer(bool verify);
     SSLServerConfigBuilder& verify_depth(int depth);
+    SSLServerConfigBuilder& session_cache(size_t size, std::chrono::seconds timeout);
+    SSLServerConfigBuilder& session_tickets(bool enable, std::chrono::seconds key_rotation = std::chrono::seconds(3600));
     
     SSLConfig build() const { return config_; }
     
@@ -413,6 +630,7 @@ public:
     SSLClientConfigBuilder& verify_peer(bool verify);
     SSLClientConfigBuilder& verify_hostname(bool verify);
     SSLClientConfigBuilder& verify_depth(int depth);
+    SSLClientConfigBuilder& session_resumption(bool enable);
     
     SSLConfig build() const { return config_; }
     
@@ -68,6 +68,8 @@ bool HttpConnection::connect(std::chrono::seconds timeout) {
         ssl_handler_->set_write_callback([this](const void* data, size_t size) -> int {
             return ::send(socket_fd_, data, size, MSG_NOSIGNAL);
         });
+        // 同一个host:port复用之前的会话，省去完整握手
+        ssl_handler_->set_session_key(host_ + ":" + std::to_string(port_));
         
         if (!ssl_handler_->start_handshake()) {
             set_error("SSL握手失败: " + ssl_handler_->get_last_error());
@@ -108,10 +110,14 @@ bool HttpConnection::connect(std::chrono::seconds timeout) {
                 cleanup();
                 state_ = ConnectionState::ERROR;
                 return false;
+            } else {
+                // 等待服务器的握手消息，不要固定休眠，否则每次握手都至少多出一个休眠周期
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(timeout - (now - start_time));
+                struct pollfd pfd;
+                pfd.fd = socket_fd_;
+                pfd.events = POLLIN;
+                poll(&pfd, 1, std::max(1, static_cast<int>(remaining.count())));
             }
-            
-            // 短暂休眠，避免忙等待
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
     }
     
@@ -526,8 +532,19 @@ void ConnectionPool::cleanup_expired_connections() {
 }
 
 ConnectionStats ConnectionPool::get_stats() const {
-    std::lock_guard<std::mutex> lock(stats_mutex_);
-    return stats_;
+    ConnectionStats stats;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats = stats_;
+    }
+    
+    if (ssl_context_manager_) {
+        SSLHandshakeStats ssl_stats = ssl_context_manager_->get_handshake_stats();
+        stats.ssl_handshakes = ssl_stats.total_handshakes();
+        stats.ssl_resumed_handshakes = ssl_stats.resumed_handshakes;
+        stats.ssl_handshake_time_us = ssl_stats.full_handshake_us + ssl_stats.resumed_handshake_us;
+    }
+    return stats;
 }
 
 void ConnectionPool::set_ssl_context_manager(std::shared_ptr<SSLContextManager> ssl_context) {
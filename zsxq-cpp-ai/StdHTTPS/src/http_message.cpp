@@ -303,6 +303,15 @@ std::string HttpRequest::get_query_param(const std::string& name) const {
     return (it != params.end()) ? it->second : std::string();
 }
 
+std::string HttpRequest::get_path_param(const std::string& name) const {
+    for (const auto& param : path_params_) {
+        if (param.first == name) {
+            return param.second;
+        }
+    }
+    return std::string();
+}
+
 HttpRequest HttpRequest::create_get(const std::string& uri, const HttpVersion& version) {
     HttpRequest request(HttpMethod::GET, uri, version);
     request.update_content_length(); // GET通常没有body，Content-Length为0
@@ -371,6 +380,7 @@ void HttpRequest::reset() {
     uri_.clear();
     path_.clear();
     query_.clear();
+    path_params_.clear();
 }
 
 std::string HttpRequest::build_start_line() const {
@@ -10,7 +10,9 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
-#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/tcp.h>
 #include <signal.h>
 #include <errno.h>
 #include <cstring>
@@ -18,13 +20,271 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <cctype>
 
 namespace stdhttps {
 
 // HttpRouter实现
+namespace {
+
+const size_t METHOD_COUNT = static_cast<size_t>(HttpMethod::UNKNOWN) + 1;
+
+/**
+ * @brief 路由模式中的一段
+ */
+struct PatternToken {
+    enum Type { STATIC, PARAM, CATCH_ALL } type;
+    std::string text;   // STATIC为路径文本，PARAM和CATCH_ALL为参数名
+    std::string suffix; // CATCH_ALL之后的固定后缀
+};
+
+bool is_name_char(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+/**
+ * @brief 把路由模式拆分成静态文本、参数和通配符
+ */
+std::vector<PatternToken> parse_pattern(const std::string& pattern) {
+    std::vector<PatternToken> tokens;
+    std::string text;
+    size_t i = 0;
+    
+    while (i < pattern.size()) {
+        char c = pattern[i];
+        bool is_param = c == ':' && i + 1 < pattern.size() && is_name_char(pattern[i + 1]);
+        if (!is_param && c != '*') {
+            text += c;
+            ++i;
+            continue;
+        }
+        
+        if (!text.empty()) {
+            tokens.push_back(PatternToken{PatternToken::STATIC, text, ""});
+            text.clear();
+        }
+        
+        size_t name_end = i + 1;
+        while (name_end < pattern.size() && is_name_char(pattern[name_end])) {
+            ++name_end;
+        }
+        std::string name = pattern.substr(i + 1, name_end - i - 1);
+        
+        if (is_param) {
+            tokens.push_back(PatternToken{PatternToken::PARAM, name, ""});
+            i = name_end;
+        } else {
+            // 通配符匹配剩余的全部路径，模式中剩下的部分作为固定后缀
+            tokens.push_back(PatternToken{PatternToken::CATCH_ALL, name.empty() ? "*" : name,
+                                          pattern.substr(name_end)});
+            return tokens;
+        }
+    }
+    
+    if (!text.empty()) {
+        tokens.push_back(PatternToken{PatternToken::STATIC, text, ""});
+    }
+    return tokens;
+}
+
+} // namespace
+
+/**
+ * @brief 编译后的路由表，发布之后只读
+ */
+struct HttpRouter::RouteTable {
+    /**
+     * @brief 路由终点
+     */
+    struct Entry {
+        HandlerPtr handler;
+        std::vector<std::string> names; // 参数名，与匹配到的值按顺序对应
+    };
+    
+    /**
+     * @brief 通配符终点
+     */
+    struct CatchAll {
+        std::string suffix;
+        Entry entry;
+    };
+    
+    /**
+     * @brief 基数树节点
+     */
+    struct Node {
+        std::string prefix;                         // 压缩的静态路径片段
+        std::string indices;                        // 静态子节点的首字符，与children一一对应
+        std::vector<std::unique_ptr<Node>> children; // 静态子节点
+        std::unique_ptr<Node> param;                // 参数子节点，匹配一个路径段
+        std::vector<CatchAll> catch_alls;           // 通配符，匹配剩余的全部路径
+        std::unique_ptr<Entry> entry;               // 在这里结束的路由
+    };
+    
+    Node trees[METHOD_COUNT];                       // 每个HTTP方法一棵树
+    HandlerPtr default_handler;
+    
+    void insert(HttpMethod method, const std::string& pattern, const HandlerPtr& handler);
+    // 参数值以[起始, 结束)偏移的形式记录在spans中
+    using Spans = std::vector<std::pair<size_t, size_t>>;
+    const Entry* match(HttpMethod method, const std::string& path, Spans& spans) const;
+    
+    static Node* insert_static(Node* node, const std::string& text);
+    static const Entry* match_node(const Node* node, const char* begin, const char* p, const char* end,
+                                   Spans& spans);
+};
+
+void HttpRouter::RouteTable::insert(HttpMethod method, const std::string& pattern, const HandlerPtr& handler) {
+    Node* node = &trees[static_cast<size_t>(method)];
+    Entry entry;
+    entry.handler = handler;
+    
+    for (const auto& token : parse_pattern(pattern)) {
+        switch (token.type) {
+            case PatternToken::STATIC:
+                node = insert_static(node, token.text);
+                break;
+                
+            case PatternToken::PARAM:
+                // 同一位置的参数共用一个节点，参数名保存在各自的路由终点上
+                if (!node->param) {
+                    node->param.reset(new Node());
+                }
+                node = node->param.get();
+                entry.names.push_back(token.text);
+                break;
+                
+            case PatternToken::CATCH_ALL:
+                for (const auto& catch_all : node->catch_alls) {
+                    if (catch_all.suffix == token.suffix) {
+                        return; // 相同的模式以先添加的为准
+                    }
+                }
+                entry.names.push_back(token.text);
+                node->catch_alls.push_back(CatchAll{token.suffix, std::move(entry)});
+                // 后缀长的优先匹配
+                std::stable_sort(node->catch_alls.begin(), node->catch_alls.end(),
+                                 [](const CatchAll& a, const CatchAll& b) {
+                                     return a.suffix.size() > b.suffix.size();
+                                 });
+                return;
+        }
+    }
+    
+    if (!node->entry) {
+        node->entry.reset(new Entry(std::move(entry)));
+    }
+}
+
+HttpRouter::RouteTable::Node* HttpRouter::RouteTable::insert_static(Node* node, const std::string& text) {
+    size_t pos = 0;
+    
+    while (pos < text.size()) {
+        size_t index = node->indices.find(text[pos]);
+        if (index == std::string::npos) {
+            // 没有相同首字符的子节点，剩余部分作为一个新节点
+            std::unique_ptr<Node> child(new Node());
+            child->prefix = text.substr(pos);
+            node->indices += text[pos];
+            node->children.push_back(std::move(child));
+            return node->children.back().get();
+        }
+        
+        Node* child = node->children[index].get();
+        size_t common = 0;
+        while (common < child->prefix.size() && pos + common < text.size() &&
+               child->prefix[common] == text[pos + common]) {
+            ++common;
+        }
+        
+        if (common < child->prefix.size()) {
+            // 在公共前缀处拆分子节点
+            std::unique_ptr<Node> split(new Node());
+            split->prefix = child->prefix.substr(0, common);
+            child->prefix.erase(0, common);
+            split->indices += child->prefix[0];
+            split->children.push_back(std::move(node->children[index]));
+            node->children[index] = std::move(split);
+            child = node->children[index].get();
+        }
+        
+        node = child;
+        pos += common;
+    }
+    return node;
+}
+
+const HttpRouter::RouteTable::Entry* HttpRouter::RouteTable::match(
+    HttpMethod method, const std::string& path, Spans& spans) const {
+    size_t index = static_cast<size_t>(method);
+    if (index >= METHOD_COUNT) {
+        return nullptr;
+    }
+    const char* begin = path.data();
+    return match_node(&trees[index], begin, begin, begin + path.size(), spans);
+}
+
+const HttpRouter::RouteTable::Entry* HttpRouter::RouteTable::match_node(
+    const Node* node, const char* begin, const char* p, const char* end, Spans& spans) {
+    // node自己的前缀已经匹配，p指向剩余的路径
+    if (p == end && node->entry) {
+        return node->entry.get();
+    }
+    
+    if (p != end) {
+        // 静态子节点
+        size_t index = node->indices.find(*p);
+        if (index != std::string::npos) {
+            const Node* child = node->children[index].get();
+            size_t length = child->prefix.size();
+            if (static_cast<size_t>(end - p) >= length &&
+                std::memcmp(p, child->prefix.data(), length) == 0) {
+                const Entry* entry = match_node(child, begin, p + length, end, spans);
+                if (entry) {
+                    return entry;
+                }
+            }
+        }
+        
+        // 参数子节点，至少匹配一个字符
+        if (node->param && *p != '/') {
+            const char* segment_end = static_cast<const char*>(std::memchr(p, '/', end - p));
+            if (!segment_end) {
+                segment_end = end;
+            }
+            spans.emplace_back(p - begin, segment_end - begin);
+            const Entry* entry = match_node(node->param.get(), begin, segment_end, end, spans);
+            if (entry) {
+                return entry;
+            }
+            spans.pop_back();
+        }
+    }
+    
+    // 通配符
+    for (const auto& catch_all : node->catch_alls) {
+        size_t suffix_length = catch_all.suffix.size();
+        if (static_cast<size_t>(end - p) >= suffix_length &&
+            std::memcmp(end - suffix_length, catch_all.suffix.data(), suffix_length) == 0) {
+            spans.emplace_back(p - begin, end - suffix_length - begin);
+            return &catch_all.entry;
+        }
+    }
+    
+    return nullptr;
+}
+
+HttpRouter::HttpRouter() : table_(new RouteTable()), epoch_(0) {
+}
+
+HttpRouter::~HttpRouter() {
+    delete table_.load();
+}
+
 void HttpRouter::add_route(HttpMethod method, const std::string& path, RequestHandler handler) {
     std::unique_lock<std::mutex> lock(routes_mutex_);
-    routes_.emplace_back(method, path, handler);
+    routes_.emplace_back(method, path, std::make_shared<const RequestHandler>(std::move(handler)));
+    publish_locked();
 }
 
 void HttpRouter::add_route(const std::string& method, const std::string& path, RequestHandler handler) {
@@ -49,73 +309,79 @@ void HttpRouter::del(const std::string& path, RequestHandler handler) {
 
 void HttpRouter::set_default_handler(RequestHandler handler) {
     std::unique_lock<std::mutex> lock(routes_mutex_);
-    default_handler_ = handler;
+    default_handler_ = handler ? std::make_shared<const RequestHandler>(std::move(handler)) : nullptr;
+    publish_locked();
 }
 
-bool HttpRouter::route_request(const HttpRequest& request, HttpResponse& response) {
+size_t HttpRouter::route_count() const {
     std::unique_lock<std::mutex> lock(routes_mutex_);
+    return routes_.size();
+}
+
+bool HttpRouter::route_request(const HttpRequest& request, HttpResponse& response) {
+    // 每个线程复用自己的缓冲区记录参数位置，查找过程中不分配内存
+    static thread_local RouteTable::Spans spans;
+    spans.clear();
     
-    HttpMethod method = request.get_method();
-    std::string path = request.get_path();
+    const std::string& path = request.get_path();
+    HandlerPtr handler;
     
-    // 查找匹配的路由
-    for (const auto& route : routes_) {
-        if (route.method == method && route.matcher(method, path)) {
-            lock.unlock();
-            route.handler(request, response);
-            return true;
+    // 读侧临界区：只做查找，处理器的引用计数加一之后就离开，处理器中可以修改路由
+    unsigned slot = epoch_.load() & 1;
+    readers_[slot].count.fetch_add(1);
+    const RouteTable* table = table_.load();
+    const RouteTable::Entry* entry = table->match(request.get_method(), path, spans);
+    if (entry) {
+        handler = entry->handler;
+        if (!spans.empty()) {
+            HttpRequest::PathParams params;
+            params.reserve(spans.size());
+            for (size_t i = 0; i < spans.size(); ++i) {
+                params.emplace_back(entry->names[i],
+                                    path.substr(spans[i].first, spans[i].second - spans[i].first));
+            }
+            request.set_path_params(std::move(params));
         }
+    } else {
+        handler = table->default_handler;
     }
+    readers_[slot].count.fetch_sub(1);
     
-    // 使用默认处理器
-    if (default_handler_) {
-        lock.unlock();
-        default_handler_(request, response);
-        return true;
+    if (!handler) {
+        return false;
     }
-    
-    return false;
-}
-
-HttpRouter::RouteMatcher HttpRouter::create_matcher(const std::string& path) {
-    return [path](HttpMethod method, const std::string& request_path) -> bool {
-        return match_path(path, request_path);
-    };
+    (*handler)(request, response);
+    return true;
 }
 
-bool HttpRouter::match_path(const std::string& pattern, const std::string& path) {
-    // 简单的路径匹配，支持 * 通配符
-    if (pattern == path) {
-        return true;
+void HttpRouter::publish_locked() {
+    // 从路由定义重新编译整张路由表，先添加的路由在冲突时优先
+    RouteTable* table = new RouteTable();
+    for (const auto& route : routes_) {
+        size_t index = static_cast<size_t>(route.method);
+        if (index < METHOD_COUNT) {
+            table->insert(route.method, route.path, route.handler);
+        }
     }
+    table->default_handler = default_handler_;
     
-    if (pattern.find('*') != std::string::npos) {
-        // 处理通配符匹配
-        size_t star_pos = pattern.find('*');
-        std::string prefix = pattern.substr(0, star_pos);
-        
-        if (path.length() >= prefix.length() && 
-            path.substr(0, prefix.length()) == prefix) {
-            // 前缀匹配
-            if (star_pos == pattern.length() - 1) {
-                return true; // 末尾通配符
-            }
-            
-            // 检查后缀
-            std::string suffix = pattern.substr(star_pos + 1);
-            if (path.length() >= suffix.length() &&
-                path.substr(path.length() - suffix.length()) == suffix) {
-                return true;
-            }
+    const RouteTable* old_table = table_.exchange(table);
+    
+    // 等待可能还在使用旧表的读者：每次先切换epoch让新的读者进入另一个计数器，再等待旧的计数器归零
+    for (int i = 0; i < 2; ++i) {
+        unsigned slot = epoch_.fetch_add(1) & 1;
+        while (readers_[slot].count.load() != 0) {
+            std::this_thread::yield();
         }
     }
-    
-    return false;
+    delete old_table;
 }
 
 // HttpServerConnection实现
 HttpServerConnection::HttpServerConnection(int socket_fd, HttpServer* server)
-    : socket_fd_(socket_fd), server_(server), active_(true) {
+    : socket_fd_(socket_fd), server_(server), active_(true), close_after_write_(false)
+    , events_(0), last_active_(std::chrono::steady_clock::now()), request_started_(false)
+    , request_start_(last_active_) {
     
     // 获取客户端地址
     struct sockaddr_in client_addr;
@@ -129,8 +395,8 @@ HttpServerConnection::HttpServerConnection(int socket_fd, HttpServer* server)
     }
     
     // 如果启用SSL，设置SSL处理器
-    if (server_->get_config().enable_ssl) {
-        setup_ssl();
+    if (server_->get_config().enable_ssl && !setup_ssl()) {
+        active_ = false;
     }
 }
 
@@ -138,70 +404,91 @@ HttpServerConnection::~HttpServerConnection() {
     close();
 }
 
-void HttpServerConnection::handle_connection() {
-    try {
-        bool keep_alive = true;
-        auto& config = server_->get_config();
+bool HttpServerConnection::on_readable() {
+    if (!active_) {
+        return false;
+    }
+    
+    bool peer_open = read_input();
+    if (!active_) {
+        return false;
+    }
+    
+    // 对端已经关闭写方向时，仍然处理已经收到的完整请求，发送完响应后关闭
+    if (!peer_open) {
+        if (!process_requests()) {
+            return false;
+        }
+        close_after_write_ = true;
+    }
+    return process_output();
+}
+
+bool HttpServerConnection::on_writable() {
+    if (!active_) {
+        return false;
+    }
+    return process_output();
+}
+
+bool HttpServerConnection::process_output() {
+    while (true) {
+        size_t pending = read_buffer_.size();
+        bool blocked = !write_buffer_.empty();
+        if (!process_requests() || !flush_output()) {
+            return false;
+        }
         
-        while (active_ && keep_alive) {
-            HttpRequest request;
-            
-            // 读取请求
-            if (!read_request(request)) {
-                break;
-            }
-            
-            // 更新统计信息
-            server_->stats_.total_requests++;
-            
-            // 创建响应
-            HttpResponse response;
-            response.set_version(request.get_version());
-            
-            try {
-                // 处理请求
-                handle_request(request, response);
-                server_->stats_.successful_requests++;
-            } catch (const std::exception& e) {
-                // 处理异常
-                response = HttpResponse::create_error(500, "Internal Server Error");
-                server_->stats_.failed_requests++;
-            }
-            
-            // 检查是否keep-alive
-            keep_alive = request.is_keep_alive() && response.is_keep_alive() && 
-                        request.get_version().major >= 1 && request.get_version().minor >= 1;
-            
-            if (!keep_alive) {
-                response.set_keep_alive(false);
-            }
-            
-            // 发送响应
-            if (!send_response(response)) {
-                break;
-            }
-            
-            // 如果不是keep-alive，退出循环
-            if (!keep_alive) {
-                break;
-            }
+        // 输出（包括SSL握手消息）发送完之后，继续处理因为等待发送而暂停的流水线请求
+        if (!write_buffer_.empty() || read_buffer_.empty() || close_after_write_) {
+            return true;
         }
-    } catch (const std::exception& e) {
-        std::cerr << "连接处理异常: " << e.what() << std::endl;
+        if (!blocked && read_buffer_.size() == pending) {
+            return true; // 剩下的数据不构成完整的请求
+        }
+    }
+}
+
+bool HttpServerConnection::check_timeout(std::chrono::steady_clock::time_point now) {
+    if (!active_) {
+        return false;
     }
     
-    active_ = false;
+    auto& config = server_->get_config();
+    auto idle = now - last_active_;
+    
+    if (close_after_write_ || !write_buffer_.empty()) {
+        // 对端长时间不读取响应
+        return idle <= config.request_timeout;
+    }
+    if (request_started_ || !read_buffer_.empty()) {
+        // 请求接收了一部分，从请求开始计时，客户端一个字节一个字节地发送也会超时
+        auto elapsed = request_started_ ? now - request_start_ : idle;
+        if (elapsed > config.request_timeout) {
+            send_error_response(408, "Request Timeout");
+            return flush_output();
+        }
+        return true;
+    }
+    // 空闲的keep-alive连接
+    return idle <= config.keep_alive_timeout;
 }
 
 void HttpServerConnection::close() {
     if (socket_fd_ >= 0) {
         if (ssl_handler_) {
+            // close_notify写入输出缓冲区，尽量发送出去，不等待
             ssl_handler_->shutdown();
+            if (!write_buffer_.empty()) {
+                ::send(socket_fd_, write_buffer_.data(), write_buffer_.size(), MSG_NOSIGNAL);
+            }
             ssl_handler_.reset();
         }
         ::close(socket_fd_);
         socket_fd_ = -1;
     }
+    write_buffer_.clear();
+    read_buffer_.clear();
     active_ = false;
 }
 
@@ -211,143 +498,388 @@ bool HttpServerConnection::setup_ssl() {
         return false;
     }
     
+    // 加密后的数据只追加到输出缓冲区，由flush_output在socket可写时发送
     ssl_handler_ = std::unique_ptr<SSLHandler>(new SSLHandler(ssl_ctx->get_context(), true));
     ssl_handler_->set_write_callback([this](const void* data, size_t size) -> int {
-        return ::send(socket_fd_, data, size, MSG_NOSIGNAL);
+        write_buffer_.append(static_cast<const char*>(data), size);
+        return static_cast<int>(size);
     });
     
     return ssl_handler_->start_handshake();
 }
 
-bool HttpServerConnection::read_request(HttpRequest& request) {
+bool HttpServerConnection::read_input() {
     char buffer[BUFFER_SIZE];
-    auto timeout = server_->get_config().request_timeout;
-    auto start_time = std::chrono::steady_clock::now();
     
-    request.reset();
-    
-    while (!request.is_complete() && active_) {
-        // 检查超时
-        auto now = std::chrono::steady_clock::now();
-        if (now - start_time > timeout) {
-            send_error_response(408, "Request Timeout");
+    while (active_) {
+        ssize_t bytes_read = ::recv(socket_fd_, buffer, sizeof(buffer), 0);
+        if (bytes_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                active_ = false;
+            }
+            return active_;
+        }
+        if (bytes_read == 0) {
             return false;
         }
         
-        // 使用poll检查数据可用性
-        struct pollfd pfd;
-        pfd.fd = socket_fd_;
-        pfd.events = POLLIN;
+        last_active_ = std::chrono::steady_clock::now();
+        server_->stats_.bytes_received += bytes_read;
         
-        int poll_result = poll(&pfd, 1, 1000); // 1秒超时
-        if (poll_result == 0) {
-            continue; // 超时，继续循环
-        } else if (poll_result < 0) {
-            return false; // poll错误
+        if (!ssl_handler_) {
+            read_buffer_.append(buffer, bytes_read);
+            continue;
         }
         
-        // 读取数据
-        ssize_t bytes_read;
-        if (ssl_handler_) {
-            // SSL连接
-            bytes_read = ::recv(socket_fd_, buffer, sizeof(buffer), MSG_DONTWAIT);
-            if (bytes_read > 0) {
-                auto error = ssl_handler_->handle_input(buffer, bytes_read);
-                if (error != SSLError::NONE && error != SSLError::WANT_READ) {
-                    return false;
-                }
-                
-                // 从SSL读取解密数据
-                size_t ssl_bytes_read;
-                error = ssl_handler_->receive_data(buffer, sizeof(buffer), ssl_bytes_read);
-                if (error == SSLError::NONE) {
-                    bytes_read = static_cast<ssize_t>(ssl_bytes_read);
-                } else if (error == SSLError::WANT_READ) {
-                    continue; // 需要更多数据
-                } else {
-                    return false;
-                }
+        // SSL连接：密文交给SSLHandler，握手期间它会把握手消息写入输出缓冲区
+        auto error = ssl_handler_->handle_input(buffer, bytes_read);
+        if (error != SSLError::NONE && error != SSLError::WANT_READ) {
+            active_ = false;
+            return false;
+        }
+        if (!ssl_handler_->is_handshake_completed()) {
+            continue;
+        }
+        
+        // 取出所有已经解密的数据
+        while (true) {
+            char plain[BUFFER_SIZE];
+            size_t ssl_bytes_read = 0;
+            error = ssl_handler_->receive_data(plain, sizeof(plain), ssl_bytes_read);
+            if (error == SSLError::NONE) {
+                read_buffer_.append(plain, ssl_bytes_read);
+            } else if (error == SSLError::WANT_READ || error == SSLError::WANT_WRITE) {
+                break;
+            } else if (error == SSLError::CONNECTION_CLOSED) {
+                return false;
+            } else {
+                active_ = false;
+                return false;
             }
-        } else {
-            // 普通连接
-            bytes_read = ::recv(socket_fd_, buffer, sizeof(buffer), 0);
+        }
+    }
+    return active_;
+}
+
+bool HttpServerConnection::process_requests() {
+    auto& config = server_->get_config();
+    size_t offset = 0;
+    
+    // 上一个响应还没有发送完时不处理下一个请求，避免慢客户端让输出缓冲区无限增长
+    while (active_ && !close_after_write_ && write_buffer_.empty() && offset < read_buffer_.size()) {
+        int parsed = request_.parse(read_buffer_.data() + offset, read_buffer_.size() - offset);
+        if (parsed < 0 || request_.has_error()) {
+            send_error_response(400, "Bad Request");
+            break;
+        }
+        offset += parsed;
+        if (!request_started_) {
+            request_started_ = true;
+            request_start_ = std::chrono::steady_clock::now();
         }
         
-        if (bytes_read <= 0) {
-            return false;
+        // 检查请求大小限制
+        if (request_.get_body_size() > config.max_request_size) {
+            send_error_response(413, "Payload Too Large");
+            break;
+        }
+        
+        if (!request_.is_complete()) {
+            if (parsed == 0) {
+                break;
+            }
+            continue;
         }
         
         // 更新统计信息
-        server_->stats_.bytes_received += bytes_read;
+        server_->stats_.total_requests++;
         
-        // 解析数据
-        int parsed = request.parse(buffer, bytes_read);
-        if (parsed < 0) {
-            send_error_response(400, "Bad Request");
-            return false;
+        // 创建响应
+        HttpResponse response;
+        response.set_version(request_.get_version());
+        
+        try {
+            // 处理请求
+            handle_request(request_, response);
+            server_->stats_.successful_requests++;
+        } catch (const std::exception& e) {
+            // 处理异常
+            response = HttpResponse::create_error(500, "Internal Server Error");
+            server_->stats_.failed_requests++;
         }
         
-        // 检查请求大小限制
-        if (request.get_body_size() > server_->get_config().max_request_size) {
-            send_error_response(413, "Payload Too Large");
+        // 检查是否keep-alive
+        bool keep_alive = request_.is_keep_alive() && response.is_keep_alive() && 
+                          request_.get_version().major >= 1 && request_.get_version().minor >= 1;
+        
+        if (!keep_alive) {
+            response.set_keep_alive(false);
+            close_after_write_ = true;
+        }
+        
+        queue_response(response);
+        request_.reset();
+        request_started_ = false;
+    }
+    
+    read_buffer_.erase(0, offset);
+    return active_;
+}
+
+bool HttpServerConnection::flush_output() {
+    while (!write_buffer_.empty()) {
+        ssize_t bytes_sent = ::send(socket_fd_, write_buffer_.data(), write_buffer_.size(), MSG_NOSIGNAL);
+        if (bytes_sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true; // 等待可写事件
+            }
+            active_ = false;
             return false;
         }
+        write_buffer_.erase(0, bytes_sent);
+        last_active_ = std::chrono::steady_clock::now();
     }
     
-    return request.is_complete() && !request.has_error();
+    return !close_after_write_;
 }
 
-bool HttpServerConnection::send_response(const HttpResponse& response) {
+void HttpServerConnection::queue_response(const HttpResponse& response) {
     std::string response_data = response.to_string();
     
     // 更新统计信息
     server_->stats_.bytes_sent += response_data.size();
     
-    const char* data = response_data.data();
-    size_t total_size = response_data.size();
+    if (!ssl_handler_) {
+        write_buffer_.append(response_data);
+        return;
+    }
+    
+    // SSL连接：加密后的数据通过写回调追加到输出缓冲区
     size_t sent = 0;
+    while (sent < response_data.size()) {
+        size_t ssl_bytes_sent = 0;
+        auto error = ssl_handler_->send_data(response_data.data() + sent, 
+                                             response_data.size() - sent, ssl_bytes_sent);
+        if (error != SSLError::NONE || ssl_bytes_sent == 0) {
+            active_ = false;
+            return;
+        }
+        sent += ssl_bytes_sent;
+    }
+}
+
+void HttpServerConnection::handle_request(const HttpRequest& request, HttpResponse& response) {
+    // 委托给服务器处理
+    server_->handle_request(request, response);
+}
+
+void HttpServerConnection::send_error_response(int status_code, const std::string& message) {
+    HttpResponse error_response = HttpResponse::create_error(status_code, message);
+    error_response.set_keep_alive(false);
+    queue_response(error_response);
+    close_after_write_ = true;
+}
+
+// HttpServerWorker实现
+HttpServerWorker::HttpServerWorker(HttpServer* server)
+    : server_(server), epoll_fd_(-1), wakeup_fd_(-1), running_(false) {
+}
+
+HttpServerWorker::~HttpServerWorker() {
+    stop();
+    join();
+    
+    // 线程没有启动时，投递过来的连接还没有被接管，接受连接时已经计入了活跃连接数
+    for (int socket_fd : pending_sockets_) {
+        ::close(socket_fd);
+    }
+    server_->stats_.active_connections -= pending_sockets_.size();
+    pending_sockets_.clear();
+    if (wakeup_fd_ >= 0) {
+        ::close(wakeup_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        ::close(epoll_fd_);
+    }
+}
+
+bool HttpServerWorker::start() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        std::cerr << "创建epoll失败: " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeup_fd_ < 0) {
+        std::cerr << "创建eventfd失败: " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr; // 唤醒事件
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &ev) < 0) {
+        std::cerr << "添加eventfd失败: " << strerror(errno) << std::endl;
+        return false;
+    }
     
-    while (sent < total_size && active_) {
-        ssize_t bytes_sent;
+    running_ = true;
+    thread_ = std::thread(&HttpServerWorker::run, this);
+    return true;
+}
+
+void HttpServerWorker::stop() {
+    running_ = false;
+    if (wakeup_fd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t ret = ::write(wakeup_fd_, &one, sizeof(one));
+        (void)ret;
+    }
+}
+
+void HttpServerWorker::join() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void HttpServerWorker::add_connection(int socket_fd) {
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_sockets_.push_back(socket_fd);
+    }
+    
+    // 唤醒epoll_wait
+    uint64_t one = 1;
+    ssize_t ret = ::write(wakeup_fd_, &one, sizeof(one));
+    (void)ret;
+}
+
+void HttpServerWorker::run() {
+    struct epoll_event events[MAX_EVENTS];
+    auto last_check = std::chrono::steady_clock::now();
+    
+    while (running_) {
+        int count = epoll_wait(epoll_fd_, events, MAX_EVENTS, TIMEOUT_CHECK_INTERVAL_MS);
+        if (count < 0 && errno != EINTR) {
+            std::cerr << "epoll_wait失败: " << strerror(errno) << std::endl;
+            break;
+        }
         
-        if (ssl_handler_) {
-            // SSL连接
-            size_t ssl_bytes_sent;
-            auto error = ssl_handler_->send_data(data + sent, total_size - sent, ssl_bytes_sent);
-            if (error == SSLError::NONE) {
-                bytes_sent = static_cast<ssize_t>(ssl_bytes_sent);
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.ptr == nullptr) {
+                accept_pending();
             } else {
-                return false;
+                handle_event(static_cast<HttpServerConnection*>(events[i].data.ptr), events[i].events);
             }
-        } else {
-            // 普通连接
-            bytes_sent = ::send(socket_fd_, data + sent, total_size - sent, MSG_NOSIGNAL);
         }
         
-        if (bytes_sent <= 0) {
-            return false;
+        // 超时检查不需要太精确，每秒扫描一次
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_check >= std::chrono::milliseconds(TIMEOUT_CHECK_INTERVAL_MS)) {
+            last_check = now;
+            check_timeouts();
         }
-        
-        sent += bytes_sent;
     }
     
-    return sent == total_size;
+    // 退出时关闭所有连接
+    server_->stats_.active_connections -= connections_.size();
+    connections_.clear();
 }
 
-void HttpServerConnection::handle_request(const HttpRequest& request, HttpResponse& response) {
-    // 委托给服务器处理
-    server_->handle_request(request, response);
+void HttpServerWorker::accept_pending() {
+    uint64_t value;
+    ssize_t ret = ::read(wakeup_fd_, &value, sizeof(value));
+    (void)ret;
+    
+    std::vector<int> sockets;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        sockets.swap(pending_sockets_);
+    }
+    
+    for (int socket_fd : sockets) {
+        std::unique_ptr<HttpServerConnection> connection(new HttpServerConnection(socket_fd, server_));
+        HttpServerConnection* conn = connection.get();
+        connections_[socket_fd] = std::move(connection);
+        if (!conn->is_active() || !update_events(conn)) {
+            close_connection(conn);
+        }
+    }
 }
 
-void HttpServerConnection::send_error_response(int status_code, const std::string& message) {
-    HttpResponse error_response = HttpResponse::create_error(status_code, message);
-    error_response.set_keep_alive(false);
-    send_response(error_response);
+void HttpServerWorker::handle_event(HttpServerConnection* connection, uint32_t events) {
+    bool keep = true;
+    
+    // 错误和挂断当作可读处理，recv会返回具体的结果
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        keep = connection->on_readable();
+    }
+    if (keep && (events & EPOLLOUT)) {
+        keep = connection->on_writable();
+    }
+    
+    if (!keep || !update_events(connection)) {
+        close_connection(connection);
+    }
+}
+
+bool HttpServerWorker::update_events(HttpServerConnection* connection) {
+    // 有数据等待发送时只关注可写，发送完之后再读取新的请求
+    uint32_t events = connection->want_write() ? EPOLLOUT : EPOLLIN;
+    if (events == connection->events_) {
+        return true;
+    }
+    
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = connection;
+    int op = connection->events_ == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+    if (epoll_ctl(epoll_fd_, op, connection->get_socket(), &ev) < 0) {
+        std::cerr << "epoll_ctl失败: " << strerror(errno) << std::endl;
+        return false;
+    }
+    connection->events_ = events;
+    return true;
+}
+
+void HttpServerWorker::close_connection(HttpServerConnection* connection) {
+    int socket_fd = connection->get_socket();
+    if (connection->events_ != 0) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, socket_fd, nullptr);
+    }
+    connections_.erase(socket_fd);
+    server_->stats_.active_connections--;
+}
+
+void HttpServerWorker::check_timeouts() {
+    auto now = std::chrono::steady_clock::now();
+    std::vector<HttpServerConnection*> expired;
+    
+    for (auto& item : connections_) {
+        HttpServerConnection* connection = item.second.get();
+        if (!connection->check_timeout(now) || !update_events(connection)) {
+            expired.push_back(connection);
+        }
+    }
+    
+    for (auto* connection : expired) {
+        close_connection(connection);
+    }
 }
 
 // HttpServer实现
 HttpServer::HttpServer(const HttpServerConfig& config)
-    : config_(config), running_(false), listen_socket_(-1) {
+    : config_(config), running_(false), listen_socket_(-1), next_worker_(0) {
     
     // 忽略SIGPIPE信号
     signal(SIGPIPE, SIG_IGN);
@@ -375,9 +907,15 @@ bool HttpServer::start() {
     running_ = true;
     stats_.start_time = std::chrono::steady_clock::now();
     
-    // 启动工作线程
-    for (size_t i = 0; i < config_.worker_threads; ++i) {
-        worker_threads_.emplace_back(&HttpServer::worker_thread, this);
+    // 启动工作线程，每个线程一个epoll反应堆
+    size_t worker_count = std::max<size_t>(config_.worker_threads, 1);
+    for (size_t i = 0; i < worker_count; ++i) {
+        std::unique_ptr<HttpServerWorker> worker(new HttpServerWorker(this));
+        if (!worker->start()) {
+            stop();
+            return false;
+        }
+        workers_.push_back(std::move(worker));
     }
     
     // 启动接受连接的线程
@@ -396,29 +934,30 @@ void HttpServer::stop() {
     
     running_ = false;
     
-    // 关闭监听socket
+    // 唤醒阻塞在accept中的接受线程
     if (listen_socket_ >= 0) {
-        ::close(listen_socket_);
-        listen_socket_ = -1;
+        ::shutdown(listen_socket_, SHUT_RDWR);
     }
     
-    // 通知所有等待的线程
-    connections_condition_.notify_all();
-    
     // 等待接受线程结束
     if (accept_thread_.joinable()) {
         accept_thread_.join();
     }
     
-    // 等待工作线程结束
-    for (auto& thread : worker_threads_) {
-        if (thread.joinable()) {
-            thread.join();
-        }
+    // 关闭监听socket
+    if (listen_socket_ >= 0) {
+        ::close(listen_socket_);
+        listen_socket_ = -1;
     }
     
-    // 清理连接
-    cleanup_connections();
+    // 通知工作线程退出，工作线程退出时关闭各自的连接
+    for (auto& worker : workers_) {
+        worker->stop();
+    }
+    for (auto& worker : workers_) {
+        worker->join();
+    }
+    workers_.clear();
     
     std::cout << "HTTP服务器已停止" << std::endl;
 }
@@ -428,10 +967,8 @@ void HttpServer::wait_for_shutdown() {
         accept_thread_.join();
     }
     
-    for (auto& thread : worker_threads_) {
-        if (thread.joinable()) {
-            thread.join();
-        }
+    for (auto& worker : workers_) {
+        worker->join();
     }
 }
 
@@ -579,13 +1116,22 @@ void HttpServer::accept_loop() {
         struct sockaddr_in client_addr;
         socklen_t addr_len = sizeof(client_addr);
         
-        int client_socket = accept(listen_socket_, 
-                                 reinterpret_cast<struct sockaddr*>(&client_addr), 
-                                 &addr_len);
+        // 客户端socket设置为非阻塞，由工作线程的epoll驱动
+        int client_socket = accept4(listen_socket_, 
+                                    reinterpret_cast<struct sockaddr*>(&client_addr), 
+                                    &addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
         
         if (client_socket < 0) {
-            if (running_) {
-                std::cerr << "接受连接失败: " << strerror(errno) << std::endl;
+            if (!running_) {
+                break;
+            }
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            std::cerr << "接受连接失败: " << strerror(errno) << std::endl;
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                // 资源耗尽，稍后重试，避免空转
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
             }
             continue;
         }
@@ -596,78 +1142,19 @@ void HttpServer::accept_loop() {
             continue;
         }
         
-        // 创建连接对象
-        auto connection = std::unique_ptr<HttpServerConnection>(new HttpServerConnection(client_socket, this));
+        // 响应通常一次写完，关闭Nagle算法避免与对端的延迟确认相互等待
+        int opt = 1;
+        setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+        
         stats_.total_connections++;
         stats_.active_connections++;
         
-        add_connection(std::move(connection));
-    }
-}
-
-void HttpServer::worker_thread() {
-    while (running_) {
-        std::unique_ptr<HttpServerConnection> connection;
-        
-        {
-            std::unique_lock<std::mutex> lock(connections_mutex_);
-            connections_condition_.wait(lock, [this] {
-                return !connection_queue_.empty() || !running_;
-            });
-            
-            if (!running_) {
-                break;
-            }
-            
-            if (!connection_queue_.empty()) {
-                connection = std::move(connection_queue_.front());
-                connection_queue_.pop();
-            }
-        }
-        
-        if (connection) {
-            connection->handle_connection();
-            remove_connection(connection.get());
-        }
+        // 轮询分配给工作线程
+        workers_[next_worker_]->add_connection(client_socket);
+        next_worker_ = (next_worker_ + 1) % workers_.size();
     }
 }
 
-void HttpServer::add_connection(std::unique_ptr<HttpServerConnection> connection) {
-    std::lock_guard<std::mutex> lock(connections_mutex_);
-    connection_queue_.push(std::move(connection));
-    connections_condition_.notify_one();
-}
-
-void HttpServer::remove_connection(HttpServerConnection* connection) {
-    stats_.active_connections--;
-    
-    std::lock_guard<std::mutex> lock(connections_mutex_);
-    connections_.erase(
-        std::remove_if(connections_.begin(), connections_.end(),
-                      [connection](const std::unique_ptr<HttpServerConnection>& conn) {
-                          return conn.get() == connection;
-                      }),
-        connections_.end()
-    );
-}
-
-void HttpServer::cleanup_connections() {
-    std::lock_guard<std::mutex> lock(connections_mutex_);
-    
-    // 清理连接队列
-    while (!connection_queue_.empty()) {
-        connection_queue_.pop();
-    }
-    
-    // 关闭所有活跃连接
-    for (auto& connection : connections_) {
-        connection->close();
-    }
-    connections_.clear();
-    
-    stats_.active_connections = 0;
-}
-
 std::string HttpServer::get_mime_type(const std::string& file_path) const {
     size_t dot_pos = file_path.find_last_of('.');
     if (dot_pos == std::string::npos) {
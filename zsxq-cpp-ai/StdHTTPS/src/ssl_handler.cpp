@@ -15,9 +15,17 @@
 #include <openssl/evp.h>
 #include <openssl/rand.h>
 #include <openssl/opensslv.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#else
+#include <openssl/hmac.h>
+#endif
 #include <sstream>
 #include <fstream>
 #include <cstring>
+#include <ctime>
+#include <deque>
+#include <algorithm>
 
 namespace stdhttps {
 
@@ -27,9 +35,206 @@ std::mutex SSLUtils::init_mutex_;
 int SSLInitializer::instance_count_ = 0;
 std::mutex SSLInitializer::count_mutex_;
 
+// SSLSessionCache实现
+SSLSessionCache::SSLSessionCache(size_t capacity) : capacity_(capacity) {
+}
+
+SSLSessionCache::~SSLSessionCache() {
+    clear();
+}
+
+SSLSessionCache& SSLSessionCache::shared() {
+    static SSLSessionCache cache;
+    return cache;
+}
+
+void SSLSessionCache::put(const std::string& key, SSL_SESSION* session) {
+    if (!session) {
+        return;
+    }
+    SSL_SESSION_up_ref(session);
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        erase_locked(it);
+    }
+    lru_.push_front(key);
+    entries_[key] = Entry{session, lru_.begin()};
+    evict_locked();
+}
+
+SSL_SESSION* SSLSessionCache::get(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        return nullptr;
+    }
+    
+    SSL_SESSION* session = it->second.session;
+    if (SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session) <= std::time(nullptr)) {
+        erase_locked(it);
+        return nullptr;
+    }
+    
+    lru_.splice(lru_.begin(), lru_, it->second.pos);
+    SSL_SESSION_up_ref(session);
+    return session;
+}
+
+void SSLSessionCache::remove(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        erase_locked(it);
+    }
+}
+
+void SSLSessionCache::set_capacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    evict_locked();
+}
+
+void SSLSessionCache::grow_capacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = std::max(capacity_, capacity);
+}
+
+size_t SSLSessionCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void SSLSessionCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : entries_) {
+        SSL_SESSION_free(entry.second.session);
+    }
+    entries_.clear();
+    lru_.clear();
+}
+
+void SSLSessionCache::erase_locked(std::unordered_map<std::string, Entry>::iterator it) {
+    SSL_SESSION_free(it->second.session);
+    lru_.erase(it->second.pos);
+    entries_.erase(it);
+}
+
+void SSLSessionCache::evict_locked() {
+    while (entries_.size() > capacity_ && !lru_.empty()) {
+        erase_locked(entries_.find(lru_.back()));
+    }
+}
+
+/**
+ * @brief 会话复用相关的状态
+ */
+struct SSLContextManager::SessionState {
+    std::mutex ticket_mutex;
+    std::deque<TicketKey> ticket_keys;         // 最前面的是当前密钥
+    std::chrono::seconds session_timeout{7200};
+    std::chrono::seconds ticket_key_rotation{3600};
+    SSLSessionCache client_sessions;           // 客户端：host:port -> 会话
+    SSLHandshakeStats stats;
+};
+
+/**
+ * @brief 注册给OpenSSL的会话回调，通过SSL_CTX的app data找到所属的管理器
+ */
+struct SSLSessionCallbacks {
+    // 服务器：新会话放进共享缓存，缓存自己增加引用计数，返回0让OpenSSL照常释放
+    static int server_new_session(SSL*, SSL_SESSION* session) {
+        unsigned int length = 0;
+        const unsigned char* id = SSL_SESSION_get_id(session, &length);
+        SSLSessionCache::shared().put(std::string(reinterpret_cast<const char*>(id), length), session);
+        return 0;
+    }
+    
+    // 服务器：按会话ID查找，返回的会话已经增加了引用计数
+    static SSL_SESSION* server_get_session(SSL*, const unsigned char* id, int length, int* copy) {
+        *copy = 0;
+        return SSLSessionCache::shared().get(std::string(reinterpret_cast<const char*>(id), length));
+    }
+    
+    static void server_remove_session(SSL_CTX*, SSL_SESSION* session) {
+        unsigned int length = 0;
+        const unsigned char* id = SSL_SESSION_get_id(session, &length);
+        SSLSessionCache::shared().remove(std::string(reinterpret_cast<const char*>(id), length));
+    }
+    
+    // 客户端：服务器签发的会话（TLS 1.3在握手之后才收到）保存到连接的会话键下
+    static int client_new_session(SSL* ssl, SSL_SESSION* session) {
+        auto* handler = static_cast<SSLHandler*>(SSL_get_app_data(ssl));
+        auto* manager = SSLContextManager::from_context(SSL_get_SSL_CTX(ssl));
+        if (handler && manager && !handler->get_session_key().empty() && SSL_SESSION_is_resumable(session)) {
+            manager->set_client_session(handler->get_session_key(), session);
+        }
+        return 0;
+    }
+    
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    using MacContext = EVP_MAC_CTX;
+    
+    static bool init_mac(EVP_MAC_CTX* mac_ctx, unsigned char* key, size_t key_size) {
+        char digest[] = "SHA256";
+        OSSL_PARAM params[] = {
+            OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key, key_size),
+            OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+            OSSL_PARAM_construct_end()
+        };
+        return EVP_MAC_CTX_set_params(mac_ctx, params) == 1;
+    }
+#else
+    using MacContext = HMAC_CTX;
+    
+    static bool init_mac(HMAC_CTX* mac_ctx, unsigned char* key, size_t key_size) {
+        return HMAC_Init_ex(mac_ctx, key, static_cast<int>(key_size), EVP_sha256(), nullptr) == 1;
+    }
+#endif
+    
+    /**
+     * @brief session ticket加解密密钥回调
+     * @return 加密时1表示签发ticket、0表示不签发；
+     *         解密时1表示成功、2表示成功但需要换发新ticket、0表示密钥未知（完整握手）、-1表示出错
+     */
+    static int ticket_key(SSL* ssl, unsigned char* key_name, unsigned char* iv,
+                          EVP_CIPHER_CTX* cipher_ctx, MacContext* mac_ctx, int enc) {
+        auto* manager = SSLContextManager::from_context(SSL_get_SSL_CTX(ssl));
+        if (!manager) {
+            return 0;
+        }
+        
+        SSLContextManager::TicketKey key;
+        const EVP_CIPHER* cipher = EVP_aes_256_cbc();
+        if (enc) {
+            if (!manager->current_ticket_key(key) || RAND_bytes(iv, EVP_CIPHER_iv_length(cipher)) != 1) {
+                return 0;
+            }
+            std::memcpy(key_name, key.name, sizeof(key.name));
+            if (EVP_EncryptInit_ex(cipher_ctx, cipher, nullptr, key.aes_key, iv) != 1 ||
+                !init_mac(mac_ctx, key.hmac_key, sizeof(key.hmac_key))) {
+                return -1;
+            }
+            return 1;
+        }
+        
+        // TLS 1.3的客户端每个ticket只用一次，复用时总是换发新ticket
+        bool renew = false;
+        if (!manager->find_ticket_key(key_name, key, renew)) {
+            return 0;
+        }
+        if (EVP_DecryptInit_ex(cipher_ctx, cipher, nullptr, key.aes_key, iv) != 1 ||
+            !init_mac(mac_ctx, key.hmac_key, sizeof(key.hmac_key))) {
+            return -1;
+        }
+        return (renew || SSL_version(ssl) == TLS1_3_VERSION) ? 2 : 1;
+    }
+};
+
 // SSLContextManager实现
 SSLContextManager::SSLContextManager(bool is_server) 
-    : ssl_ctx_(nullptr), is_server_(is_server) {
+    : ssl_ctx_(nullptr), is_server_(is_server), session_(new SessionState()) {
     SSLUtils::initialize_openssl();
 }
 
@@ -40,8 +245,13 @@ SSLContextManager::~SSLContextManager() {
 SSLContextManager::SSLContextManager(SSLContextManager&& other) noexcept
     : ssl_ctx_(other.ssl_ctx_)
     , is_server_(other.is_server_)
-    , error_message_(std::move(other.error_message_)) {
+    , error_message_(std::move(other.error_message_))
+    , session_(std::move(other.session_)) {
     other.ssl_ctx_ = nullptr;
+    other.session_.reset(new SessionState());
+    if (ssl_ctx_) {
+        SSL_CTX_set_app_data(ssl_ctx_, this);
+    }
 }
 
 SSLContextManager& SSLContextManager::operator=(SSLContextManager&& other) noexcept {
@@ -50,7 +260,12 @@ SSLContextManager& SSLContextManager::operator=(SSLContextManager&& other) noexc
         ssl_ctx_ = other.ssl_ctx_;
         is_server_ = other.is_server_;
         error_message_ = std::move(other.error_message_);
+        session_ = std::move(other.session_);
         other.ssl_ctx_ = nullptr;
+        other.session_.reset(new SessionState());
+        if (ssl_ctx_) {
+            SSL_CTX_set_app_data(ssl_ctx_, this);
+        }
     }
     return *this;
 }
@@ -71,6 +286,7 @@ bool SSLContextManager::initialize(const SSLConfig& config) {
         set_error("无法创建SSL上下文: " + SSLUtils::get_openssl_error_string());
         return false;
     }
+    SSL_CTX_set_app_data(ssl_ctx_, this);
     
     // 设置协议版本
     if (!config.protocol_version.empty()) {
@@ -116,9 +332,184 @@ bool SSLContextManager::initialize(const SSLConfig& config) {
     SSL_CTX_set_verify(ssl_ctx_, verify_mode, nullptr);
     SSL_CTX_set_verify_depth(ssl_ctx_, config.verify_depth);
     
+    if (!setup_session_resumption(config)) {
+        return false;
+    }
+    
+    return true;
+}
+
+bool SSLContextManager::setup_session_resumption(const SSLConfig& config) {
+    if (!config.enable_session_resumption) {
+        SSL_CTX_set_session_cache_mode(ssl_ctx_, SSL_SESS_CACHE_OFF);
+        if (is_server_) {
+            SSL_CTX_set_options(ssl_ctx_, SSL_OP_NO_TICKET);
+        }
+        return true;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(session_->ticket_mutex);
+        session_->session_timeout = config.session_timeout;
+        session_->ticket_key_rotation = config.ticket_key_rotation;
+        session_->ticket_keys.clear();
+    }
+    SSL_CTX_set_timeout(ssl_ctx_, static_cast<long>(config.session_timeout.count()));
+    
+    if (!is_server_) {
+        // 客户端会话只保存在自己的缓存中，由SSLHandler按会话键取出
+        session_->client_sessions.set_capacity(config.session_cache_size);
+        SSL_CTX_set_session_cache_mode(ssl_ctx_, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(ssl_ctx_, SSLSessionCallbacks::client_new_session);
+        return true;
+    }
+    
+    // 服务器：会话保存在进程内共享的缓存中，验证客户端证书时复用会话必须设置会话ID上下文。
+    // 会话ID上下文由证书和验证配置算出来，不验证客户端的上下文建立的会话不能在验证客户端的上下文中复用
+    unsigned char sid_ctx[SSL_MAX_SID_CTX_LENGTH];
+    unsigned int sid_ctx_len = 0;
+    if (!compute_session_id_context(config, sid_ctx, &sid_ctx_len)) {
+        set_error("无法计算会话ID上下文: " + SSLUtils::get_openssl_error_string());
+        return false;
+    }
+    SSL_CTX_set_session_id_context(ssl_ctx_, sid_ctx, sid_ctx_len);
+    // 共享缓存的容量取所有上下文配置中最大的
+    SSLSessionCache::shared().grow_capacity(config.session_cache_size);
+    SSL_CTX_set_session_cache_mode(ssl_ctx_, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_sess_set_new_cb(ssl_ctx_, SSLSessionCallbacks::server_new_session);
+    SSL_CTX_sess_set_get_cb(ssl_ctx_, SSLSessionCallbacks::server_get_session);
+    SSL_CTX_sess_set_remove_cb(ssl_ctx_, SSLSessionCallbacks::server_remove_session);
+    
+    if (!config.enable_session_tickets) {
+        SSL_CTX_set_options(ssl_ctx_, SSL_OP_NO_TICKET);
+        return true;
+    }
+    
+    // ticket用自己管理的密钥加密，多个进程或者重启之后也可以换成同一组密钥
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    SSL_CTX_set_tlsext_ticket_key_evp_cb(ssl_ctx_, SSLSessionCallbacks::ticket_key);
+#else
+    SSL_CTX_set_tlsext_ticket_key_cb(ssl_ctx_, SSLSessionCallbacks::ticket_key);
+#endif
+    return true;
+}
+
+bool SSLContextManager::compute_session_id_context(const SSLConfig& config, unsigned char* sid_ctx,
+                                                   unsigned int* sid_ctx_len) {
+    // SHA256(证书的SHA256 | 验证模式 | 验证深度 | CA文件 | CA目录)，正好是会话ID上下文的最大长度32字节
+    unsigned char cert_digest[EVP_MAX_MD_SIZE];
+    unsigned int cert_digest_len = 0;
+    X509* cert = SSL_CTX_get0_certificate(ssl_ctx_);
+    if (cert && !X509_digest(cert, EVP_sha256(), cert_digest, &cert_digest_len)) {
+        return false;
+    }
+    int verify_mode = SSL_CTX_get_verify_mode(ssl_ctx_);
+    int verify_depth = SSL_CTX_get_verify_depth(ssl_ctx_);
+    
+    EVP_MD_CTX* md = EVP_MD_CTX_new();
+    if (!md) {
+        return false;
+    }
+    bool ok = EVP_DigestInit_ex(md, EVP_sha256(), nullptr)
+        && EVP_DigestUpdate(md, cert_digest, cert_digest_len)
+        && EVP_DigestUpdate(md, &verify_mode, sizeof(verify_mode))
+        && EVP_DigestUpdate(md, &verify_depth, sizeof(verify_depth))
+        && EVP_DigestUpdate(md, config.ca_file.c_str(), config.ca_file.size() + 1)
+        && EVP_DigestUpdate(md, config.ca_path.c_str(), config.ca_path.size() + 1)
+        && EVP_DigestFinal_ex(md, sid_ctx, sid_ctx_len);
+    EVP_MD_CTX_free(md);
+    return ok;
+}
+
+void SSLContextManager::rotate_ticket_keys() {
+    std::lock_guard<std::mutex> lock(session_->ticket_mutex);
+    rotate_ticket_keys_locked(std::chrono::steady_clock::now());
+}
+
+SSL_SESSION* SSLContextManager::get_client_session(const std::string& key) {
+    return session_->client_sessions.get(key);
+}
+
+void SSLContextManager::set_client_session(const std::string& key, SSL_SESSION* session) {
+    session_->client_sessions.put(key, session);
+}
+
+void SSLContextManager::record_handshake(bool success, bool resumed, std::chrono::microseconds elapsed) {
+    SSLHandshakeStats& stats = session_->stats;
+    if (!success) {
+        stats.failed_handshakes++;
+    } else if (resumed) {
+        stats.resumed_handshakes++;
+        stats.resumed_handshake_us += static_cast<uint64_t>(elapsed.count());
+    } else {
+        stats.full_handshakes++;
+        stats.full_handshake_us += static_cast<uint64_t>(elapsed.count());
+    }
+}
+
+SSLHandshakeStats SSLContextManager::get_handshake_stats() const {
+    return session_->stats;
+}
+
+SSLContextManager* SSLContextManager::from_context(SSL_CTX* ssl_ctx) {
+    return ssl_ctx ? static_cast<SSLContextManager*>(SSL_CTX_get_app_data(ssl_ctx)) : nullptr;
+}
+
+bool SSLContextManager::current_ticket_key(TicketKey& key) {
+    std::lock_guard<std::mutex> lock(session_->ticket_mutex);
+    auto now = std::chrono::steady_clock::now();
+    auto& keys = session_->ticket_keys;
+    
+    // 第一次签发时生成密钥，之后到了轮换周期再生成新密钥
+    bool expired = !keys.empty() && session_->ticket_key_rotation.count() > 0 &&
+                   now - keys.front().created >= session_->ticket_key_rotation;
+    if ((keys.empty() || expired) && !rotate_ticket_keys_locked(now)) {
+        return false;
+    }
+    prune_ticket_keys_locked(now);
+    key = keys.front();
+    return true;
+}
+
+bool SSLContextManager::find_ticket_key(const unsigned char* name, TicketKey& key, bool& renew) {
+    std::lock_guard<std::mutex> lock(session_->ticket_mutex);
+    auto& keys = session_->ticket_keys;
+    prune_ticket_keys_locked(std::chrono::steady_clock::now());
+    
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (std::memcmp(keys[i].name, name, sizeof(keys[i].name)) == 0) {
+            key = keys[i];
+            renew = i != 0; // 旧密钥签发的ticket，换发当前密钥的ticket
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SSLContextManager::rotate_ticket_keys_locked(std::chrono::steady_clock::time_point now) {
+    TicketKey key;
+    if (RAND_bytes(key.name, sizeof(key.name)) != 1 ||
+        RAND_bytes(key.aes_key, sizeof(key.aes_key)) != 1 ||
+        RAND_bytes(key.hmac_key, sizeof(key.hmac_key)) != 1) {
+        return false;
+    }
+    key.created = now;
+    session_->ticket_keys.push_front(key);
+    prune_ticket_keys_locked(now);
     return true;
 }
 
+void SSLContextManager::prune_ticket_keys_locked(std::chrono::steady_clock::time_point now) {
+    // 密钥i在密钥i-1生成时停止签发，它签发的最后一个ticket在session_timeout之后过期
+    auto& keys = session_->ticket_keys;
+    for (size_t i = 1; i < keys.size(); ++i) {
+        if (now - keys[i - 1].created > session_->session_timeout) {
+            keys.erase(keys.begin() + i, keys.end());
+            break;
+        }
+    }
+}
+
 bool SSLContextManager::load_certificate(const std::string& cert_file, const std::string& key_file) {
     if (!ssl_ctx_) {
         set_error("SSL上下文未初始化");
@@ -179,6 +570,8 @@ bool SSLContextManager::set_cipher_list(const std::string& cipher_list) {
 
 void SSLContextManager::cleanup() {
     if (ssl_ctx_) {
+        // 连接还持有SSL_CTX的引用，回调中不能再找到这个管理器
+        SSL_CTX_set_app_data(ssl_ctx_, nullptr);
         SSL_CTX_free(ssl_ctx_);
         ssl_ctx_ = nullptr;
     }
@@ -221,6 +614,9 @@ SSLHandler::SSLHandler(SSL_CTX* ssl_ctx, bool is_server)
     // 设置BIO到SSL对象
     SSL_set_bio(ssl_, read_bio_, write_bio_);
     
+    // 会话回调通过app data找到连接
+    SSL_set_app_data(ssl_, this);
+    
     // 设置SSL模式
     if (is_server_) {
         SSL_set_accept_state(ssl_);
@@ -240,8 +636,13 @@ SSLHandler::SSLHandler(SSLHandler&& other) noexcept
     , state_(other.state_)
     , is_server_(other.is_server_)
     , write_callback_(std::move(other.write_callback_))
-    , last_error_(std::move(other.last_error_)) {
+    , last_error_(std::move(other.last_error_))
+    , session_key_(std::move(other.session_key_))
+    , handshake_start_(other.handshake_start_) {
     
+    if (ssl_) {
+        SSL_set_app_data(ssl_, this);
+    }
     other.ssl_ = nullptr;
     other.read_bio_ = nullptr;
     other.write_bio_ = nullptr;
@@ -259,6 +660,11 @@ SSLHandler& SSLHandler::operator=(SSLHandler&& other) noexcept {
         is_server_ = other.is_server_;
         write_callback_ = std::move(other.write_callback_);
         last_error_ = std::move(other.last_error_);
+        session_key_ = std::move(other.session_key_);
+        handshake_start_ = other.handshake_start_;
+        if (ssl_) {
+            SSL_set_app_data(ssl_, this);
+        }
         
         other.ssl_ = nullptr;
         other.read_bio_ = nullptr;
@@ -272,6 +678,28 @@ void SSLHandler::set_write_callback(WriteCallback callback) {
     write_callback_ = callback;
 }
 
+void SSLHandler::set_session_key(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    session_key_ = key;
+    if (!ssl_ || is_server_ || state_ != SSLState::INIT || key.empty()) {
+        return;
+    }
+    
+    auto* manager = SSLContextManager::from_context(SSL_get_SSL_CTX(ssl_));
+    if (!manager) {
+        return;
+    }
+    SSL_SESSION* session = manager->get_client_session(key);
+    if (session) {
+        SSL_set_session(ssl_, session); // SSL对象持有自己的引用
+        SSL_SESSION_free(session);
+    }
+}
+
+bool SSLHandler::is_session_reused() const {
+    return ssl_ && state_ == SSLState::CONNECTED && SSL_session_reused(ssl_) == 1;
+}
+
 bool SSLHandler::start_handshake() {
     std::lock_guard<std::mutex> lock(mutex_);
     
@@ -281,6 +709,7 @@ bool SSLHandler::start_handshake() {
     }
     
     state_ = SSLState::HANDSHAKING;
+    handshake_start_ = std::chrono::steady_clock::now();
     
     int ret;
     if (is_server_) {
@@ -291,6 +720,7 @@ bool SSLHandler::start_handshake() {
     
     if (ret == 1) {
         state_ = SSLState::CONNECTED;
+        finish_handshake(true);
         flush_bio_write();
         return true;
     } else {
@@ -301,6 +731,7 @@ bool SSLHandler::start_handshake() {
         } else {
             handle_ssl_error(ssl_error);
             state_ = SSLState::ERROR;
+            finish_handshake(false);
             return false;
         }
     }
@@ -331,11 +762,13 @@ SSLError SSLHandler::handle_input(const void* data, size_t size) {
         
         if (ret == 1) {
             state_ = SSLState::CONNECTED;
+            finish_handshake(true);
         } else {
             int ssl_error = SSL_get_error(ssl_, ret);
             if (ssl_error != SSL_ERROR_WANT_READ && ssl_error != SSL_ERROR_WANT_WRITE) {
                 handle_ssl_error(ssl_error);
                 state_ = SSLState::ERROR;
+                finish_handshake(false);
                 return handle_ssl_error(ssl_error);
             }
         }
@@ -386,7 +819,11 @@ SSLError SSLHandler::receive_data(void* buffer, size_t buffer_size, size_t& byte
 bool SSLHandler::shutdown() {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    if (state_ == SSLState::CLOSED || state_ == SSLState::ERROR) {
+    if (!ssl_ || state_ == SSLState::ERROR) {
+        return true;
+    }
+    // 对端先发送了close_notify时也要回复，没有发送close_notify就释放的会话会被移出会话缓存
+    if (state_ == SSLState::CLOSED && (SSL_get_shutdown(ssl_) & SSL_SENT_SHUTDOWN)) {
         return true;
     }
     
@@ -507,6 +944,23 @@ void SSLHandler::flush_bio_write() {
     }
 }
 
+void SSLHandler::finish_handshake(bool success) {
+    auto* manager = SSLContextManager::from_context(SSL_get_SSL_CTX(ssl_));
+    if (!manager) {
+        return;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - handshake_start_);
+    bool resumed = success && SSL_session_reused(ssl_) == 1;
+    manager->record_handshake(success, resumed, elapsed);
+    
+    // TLS 1.2复用会话时服务器换发的ticket在新的会话对象中，不会触发新会话回调，
+    // 原来的会话已经不能再复用，保存当前的会话
+    if (resumed && !is_server_ && !session_key_.empty() && SSL_version(ssl_) != TLS1_3_VERSION) {
+        manager->set_client_session(session_key_, SSL_get_session(ssl_));
+    }
+}
+
 // SSLUtils实现
 void SSLUtils::initialize_openssl() {
     std::lock_guard<std::mutex> lock(init_mutex_);
@@ -785,6 +1239,19 @@ SSLServerConfigBuilder& SSLServerConfigBuilder::verify_depth(int depth) {
     return *this;
 }
 
+SSLServerConfigBuilder& SSLServerConfigBuilder::session_cache(size_t size, std::chrono::seconds timeout) {
+    config_.enable_session_resumption = size > 0;
+    config_.session_cache_size = size;
+    config_.session_timeout = timeout;
+    return *this;
+}
+
+SSLServerConfigBuilder& SSLServerConfigBuilder::session_tickets(bool enable, std::chrono::seconds key_rotation) {
+    config_.enable_session_tickets = enable;
+    config_.ticket_key_rotation = key_rotation;
+    return *this;
+}
+
 SSLClientConfigBuilder::SSLClientConfigBuilder() {
     // 客户端默认配置
     config_.verify_peer = true;      // 客户端默认验证服务器证书
@@ -828,4 +1295,9 @@ SSLClientConfigBuilder& SSLClientConfigBuilder::verify_depth(int depth) {
     return *this;
 }
 
+SSLClientConfigBuilder& SSLClientConfigBuilder::session_resumption(bool enable) {
+    config_.enable_session_resumption = enable;
+    return *this;
+}
+
 } // namespace stdhttps
\ No newline at end of file
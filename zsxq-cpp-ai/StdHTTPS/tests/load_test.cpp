@@ -0,0 +1,561 @@
+/**
+ * @file load_test.cpp
+ * @brief HTTP服务器并发负载测试程序
+ * @details 服务器运行在子进程中，父进程用一个epoll线程模拟大量keep-alive客户端：
+ *          先让所有客户端同时建立连接并各完成一个请求，确认服务器同时保持着全部连接，
+ *          再在这些连接上继续发送请求并统计吞吐量。
+ *          用法: ./load_test [客户端数量=10000] [每个客户端的请求数=5] [--ssl]
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <cstdlib>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <errno.h>
+#include "http_server.h"
+#include "ssl_handler.h"
+
+using namespace stdhttps;
+
+static const char* kCertFile = "load_test.crt";
+static const char* kKeyFile = "load_test.key";
+static const std::chrono::seconds kDeadline(120);
+
+/**
+ * @brief 模拟的客户端连接
+ */
+struct LoadClient {
+    int fd = -1;
+    bool connected = false;
+    int responses = 0;                      // 已经收到的响应数
+    int target = 0;                         // 当前阶段需要收到的响应数
+    bool waiting = false;                   // 是否有请求在等待响应
+    std::unique_ptr<SSLHandler> ssl;
+    std::string out;                        // 等待发送的数据（SSL时为密文）
+    HttpResponse response;
+    uint32_t events = 0;
+};
+
+/**
+ * @brief 尽量提高文件描述符上限
+ * @return 当前上限
+ */
+static long raise_fd_limit() {
+    struct rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    getrlimit(RLIMIT_NOFILE, &limit);
+    return static_cast<long>(limit.rlim_cur);
+}
+
+/**
+ * @brief 子进程：运行服务器，直到父进程关闭控制管道
+ */
+static void run_server(int port, size_t clients, bool use_ssl, int ready_fd, int control_fd) {
+    raise_fd_limit();
+
+    HttpServerConfig config;
+    config.bind_address = "127.0.0.1";
+    config.port = port;
+    config.worker_threads = 4;
+    config.max_connections = clients + 16;
+    if (use_ssl) {
+        config.enable_ssl = true;
+        config.ssl_config.cert_file = kCertFile;
+        config.ssl_config.key_file = kKeyFile;
+        config.ssl_config.verify_peer = false;
+    }
+
+    HttpServer server(config);
+    server.get("/ping", [](const HttpRequest&, HttpResponse& response) {
+        response = HttpResponse::create_ok("pong", "text/plain");
+    });
+    server.get("/stats", [&server](const HttpRequest&, HttpResponse& response) {
+        response = HttpResponse::create_ok(
+            std::to_string(server.get_stats().active_connections.load()), "text/plain");
+    });
+
+    char status = server.start() ? 'y' : 'n';
+    ssize_t ret = write(ready_fd, &status, 1);
+    (void)ret;
+
+    // 父进程退出或者关闭管道时读到EOF
+    char byte;
+    while (read(control_fd, &byte, 1) > 0) {
+    }
+    server.stop();
+    _exit(0);
+}
+
+/**
+ * @brief 父进程中的负载生成器
+ */
+class LoadGenerator {
+public:
+    LoadGenerator(int port, size_t clients, bool use_ssl)
+        : port_(port), clients_(clients), use_ssl_(use_ssl), ssl_context_(false) {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (use_ssl_) {
+            SSLConfig ssl_config;
+            ssl_config.verify_peer = false;
+            ssl_context_.initialize(ssl_config);
+        }
+    }
+
+    ~LoadGenerator() {
+        for (auto& client : clients_list_) {
+            if (client->fd >= 0) {
+                close(client->fd);
+            }
+        }
+        close(epoll_fd_);
+    }
+
+    /**
+     * @brief 建立所有连接，每个客户端完成一个请求
+     */
+    bool connect_all() {
+        auto deadline = std::chrono::steady_clock::now() + kDeadline;
+        size_t failed = 0;
+
+        // 分批发起连接，避免超过监听队列长度导致SYN重传
+        const size_t batch = 512;
+        while (clients_list_.size() < clients_) {
+            size_t end = std::min(clients_, clients_list_.size() + batch);
+            while (clients_list_.size() < end) {
+                std::unique_ptr<LoadClient> client(new LoadClient());
+                client->target = 1;
+                if (!start_connect(client.get())) {
+                    ++failed;
+                }
+                clients_list_.push_back(std::move(client));
+            }
+            if (!run_until(end, deadline)) {
+                return false;
+            }
+        }
+
+        if (failed > 0) {
+            std::cerr << failed << " 个连接建立失败" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 所有客户端在已有的keep-alive连接上各自再发送rounds个请求
+     */
+    bool run_rounds(int rounds) {
+        auto deadline = std::chrono::steady_clock::now() + kDeadline;
+        for (auto& client : clients_list_) {
+            client->target += rounds;
+            send_request(client.get());
+            update_events(client.get());
+        }
+        return run_until(clients_list_.size(), deadline);
+    }
+
+    size_t total_responses() const {
+        size_t total = 0;
+        for (auto& client : clients_list_) {
+            total += client->responses;
+        }
+        return total;
+    }
+
+    size_t open_connections() const {
+        size_t open = 0;
+        for (auto& client : clients_list_) {
+            if (client->fd >= 0) {
+                ++open;
+            }
+        }
+        return open;
+    }
+
+private:
+    bool start_connect(LoadClient* client) {
+        client->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (client->fd < 0) {
+            std::cerr << "创建socket失败: " << strerror(errno) << std::endl;
+            return false;
+        }
+        int opt = 1;
+        setsockopt(client->fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port_);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(client->fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 &&
+            errno != EINPROGRESS) {
+            std::cerr << "连接失败: " << strerror(errno) << std::endl;
+            close(client->fd);
+            client->fd = -1;
+            return false;
+        }
+
+        // 等待连接建立（可写）
+        client->events = EPOLLOUT;
+        struct epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = client->events;
+        ev.data.ptr = client;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client->fd, &ev);
+        return true;
+    }
+
+    void on_connected(LoadClient* client) {
+        client->connected = true;
+        if (!use_ssl_) {
+            send_request(client);
+            return;
+        }
+
+        // 客户端同样使用内存BIO，握手消息追加到输出缓冲区
+        client->ssl.reset(new SSLHandler(ssl_context_.get_context(), false));
+        client->ssl->set_write_callback([client](const void* data, size_t size) -> int {
+            client->out.append(static_cast<const char*>(data), size);
+            return static_cast<int>(size);
+        });
+        client->ssl->start_handshake();
+    }
+
+    void send_request(LoadClient* client) {
+        if (client->waiting || client->responses >= client->target || client->fd < 0) {
+            return;
+        }
+        if (client->ssl && !client->ssl->is_handshake_completed()) {
+            return;
+        }
+
+        static const std::string request =
+            "GET /ping HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: keep-alive\r\n\r\n";
+        if (client->ssl) {
+            size_t sent = 0;
+            client->ssl->send_data(request.data(), request.size(), sent);
+        } else {
+            client->out.append(request);
+        }
+        client->waiting = true;
+    }
+
+    /**
+     * @brief 发送输出缓冲区
+     * @return 是否出错
+     */
+    bool flush(LoadClient* client) {
+        while (!client->out.empty()) {
+            ssize_t n = send(client->fd, client->out.data(), client->out.size(), MSG_NOSIGNAL);
+            if (n < 0) {
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            client->out.erase(0, n);
+        }
+        return true;
+    }
+
+    /**
+     * @brief 读取响应
+     * @return 是否出错
+     */
+    bool receive(LoadClient* client) {
+        char buffer[16384];
+        while (true) {
+            ssize_t n = recv(client->fd, buffer, sizeof(buffer), 0);
+            if (n < 0) {
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            if (n == 0) {
+                return false;
+            }
+
+            if (!client->ssl) {
+                if (!parse_response(client, buffer, n)) {
+                    return false;
+                }
+                continue;
+            }
+
+            auto error = client->ssl->handle_input(buffer, n);
+            if (error != SSLError::NONE && error != SSLError::WANT_READ) {
+                return false;
+            }
+            if (!client->ssl->is_handshake_completed()) {
+                continue;
+            }
+            send_request(client);
+
+            char plain[16384];
+            size_t plain_size = 0;
+            while (client->ssl->receive_data(plain, sizeof(plain), plain_size) == SSLError::NONE) {
+                if (!parse_response(client, plain, plain_size)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    bool parse_response(LoadClient* client, const char* data, size_t size) {
+        if (client->response.parse(data, size) < 0) {
+            return false;
+        }
+        if (!client->response.is_complete()) {
+            return true;
+        }
+        if (client->response.get_status_code() != 200 || client->response.get_body() != "pong") {
+            std::cerr << "响应错误: " << client->response.get_status_code() << std::endl;
+            return false;
+        }
+        client->response.reset();
+        client->waiting = false;
+        client->responses++;
+        if (client->responses == client->target) {
+            ++finished_;
+        }
+        send_request(client);
+        return true;
+    }
+
+    void update_events(LoadClient* client) {
+        uint32_t events = client->out.empty() ? EPOLLIN : (EPOLLIN | EPOLLOUT);
+        if (client->fd < 0 || events == client->events) {
+            return;
+        }
+        struct epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.ptr = client;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, client->fd, &ev);
+        client->events = events;
+    }
+
+    void fail(LoadClient* client) {
+        std::cerr << "连接异常断开，已收到 " << client->responses << " 个响应" << std::endl;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, client->fd, nullptr);
+        close(client->fd);
+        client->fd = -1;
+        ++errors_;
+    }
+
+    /**
+     * @brief 驱动事件循环，直到前count个客户端都收到了目标数量的响应
+     */
+    bool run_until(size_t count, std::chrono::steady_clock::time_point deadline) {
+        struct epoll_event events[1024];
+        finished_ = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (clients_list_[i]->responses >= clients_list_[i]->target) {
+                ++finished_;
+            }
+        }
+
+        while (finished_ < count) {
+            if (errors_ > 0) {
+                return false;
+            }
+            if (std::chrono::steady_clock::now() > deadline) {
+                std::cerr << "超时: " << finished_ << "/" << count << " 个客户端完成" << std::endl;
+                return false;
+            }
+
+            int n = epoll_wait(epoll_fd_, events, 1024, 100);
+            for (int i = 0; i < n; ++i) {
+                LoadClient* client = static_cast<LoadClient*>(events[i].data.ptr);
+                if (client->fd < 0) {
+                    continue;
+                }
+                if (!client->connected) {
+                    int error = 0;
+                    socklen_t len = sizeof(error);
+                    getsockopt(client->fd, SOL_SOCKET, SO_ERROR, &error, &len);
+                    if (error != 0) {
+                        std::cerr << "连接失败: " << strerror(error) << std::endl;
+                        fail(client);
+                        continue;
+                    }
+                    on_connected(client);
+                }
+                if ((events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) && !receive(client)) {
+                    fail(client);
+                    continue;
+                }
+                if (!flush(client)) {
+                    fail(client);
+                    continue;
+                }
+                update_events(client);
+            }
+        }
+        return errors_ == 0;
+    }
+
+private:
+    int port_;
+    size_t clients_;
+    bool use_ssl_;
+    int epoll_fd_;
+    SSLContextManager ssl_context_;
+    std::vector<std::unique_ptr<LoadClient>> clients_list_;
+    size_t finished_ = 0;
+    size_t errors_ = 0;
+};
+
+/**
+ * @brief 通过一个单独的连接查询服务器当前的活跃连接数
+ */
+static long query_active_connections(int port, bool use_ssl) {
+    if (use_ssl) {
+        return -1; // SSL模式下只检查所有客户端都在线
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    std::string request = "GET /stats HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+
+    HttpResponse response;
+    char buffer[4096];
+    ssize_t n;
+    while (!response.is_complete() && (n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        response.parse(buffer, n);
+    }
+    close(fd);
+    return response.is_complete() ? std::atol(response.get_body().c_str()) : -1;
+}
+
+int main(int argc, char* argv[]) {
+    size_t clients = 10000;
+    int rounds = 5;
+    bool use_ssl = false;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--ssl") {
+            use_ssl = true;
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    if (args.size() > 0) {
+        clients = std::strtoul(args[0].c_str(), nullptr, 10);
+    }
+    if (args.size() > 1) {
+        rounds = std::max(1, std::atoi(args[1].c_str()));
+    }
+
+    // 客户端和服务器各自在自己的进程中占用一个文件描述符
+    long limit = raise_fd_limit();
+    if (limit < static_cast<long>(clients) + 64) {
+        size_t reduced = limit > 128 ? static_cast<size_t>(limit - 64) : 64;
+        std::cout << "文件描述符上限为 " << limit << "，客户端数量从 " << clients
+                  << " 减少到 " << reduced << std::endl;
+        clients = reduced;
+    }
+
+    std::cout << "运行负载测试: " << clients << " 个keep-alive客户端，每个 " << rounds
+              << " 个请求" << (use_ssl ? "（SSL）" : "") << std::endl;
+
+    if (use_ssl && !SSLUtils::generate_self_signed_cert(kCertFile, kKeyFile)) {
+        std::cerr << "生成测试证书失败" << std::endl;
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    // 端口选在临时端口范围（32768起）之下，避免和客户端连接冲突
+    int port = 10000 + getpid() % 20000;
+    int ready_pipe[2];
+    int control_pipe[2];
+    if (pipe(ready_pipe) < 0 || pipe(control_pipe) < 0) {
+        std::cerr << "创建管道失败" << std::endl;
+        return 1;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(ready_pipe[0]);
+        close(control_pipe[1]);
+        run_server(port, clients, use_ssl, ready_pipe[1], control_pipe[0]);
+    }
+    close(ready_pipe[1]);
+    close(control_pipe[0]);
+
+    char status = 'n';
+    if (read(ready_pipe[0], &status, 1) != 1 || status != 'y') {
+        std::cerr << "服务器启动失败" << std::endl;
+        close(control_pipe[1]);
+        waitpid(pid, nullptr, 0);
+        return 1;
+    }
+
+    int result = 1;
+    {
+        LoadGenerator generator(port, clients, use_ssl);
+
+        // 第一阶段：所有客户端同时在线
+        auto start = std::chrono::steady_clock::now();
+        bool ok = generator.connect_all();
+        double connect_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        long active = ok ? query_active_connections(port, use_ssl) : -1;
+        if (ok) {
+            std::cout << "建立 " << generator.open_connections() << " 个连接并各完成一个请求，用时 "
+                      << connect_seconds << " 秒" << std::endl;
+            if (active >= 0) {
+                std::cout << "服务器当前活跃连接数: " << active << std::endl;
+            }
+            if (active >= 0 && active < static_cast<long>(clients)) {
+                std::cerr << "服务器没有同时保持所有连接" << std::endl;
+                ok = false;
+            }
+        }
+
+        // 第二阶段：在已有的连接上继续请求
+        if (ok && rounds > 1) {
+            start = std::chrono::steady_clock::now();
+            ok = generator.run_rounds(rounds - 1);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (ok) {
+                size_t requests = clients * (rounds - 1);
+                std::cout << "keep-alive请求 " << requests << " 个，用时 " << seconds << " 秒，"
+                          << static_cast<long>(requests / seconds) << " 请求/秒" << std::endl;
+            }
+        }
+
+        if (ok && generator.total_responses() == clients * rounds &&
+            generator.open_connections() == clients) {
+            std::cout << "负载测试通过！" << std::endl;
+            result = 0;
+        } else {
+            std::cerr << "负载测试失败" << std::endl;
+        }
+    }
+
+    close(control_pipe[1]);
+    waitpid(pid, nullptr, 0);
+    return result;
+}
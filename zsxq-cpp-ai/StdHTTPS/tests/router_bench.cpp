@@ -0,0 +1,196 @@
+/**
+ * @file router_bench.cpp
+ * @brief HTTP路由性能测试程序
+ * @details 注册一组类似REST API的路由（静态路径、路径参数和通配符混合），
+ *          测量单线程和多线程下每次路由查找的耗时，
+ *          并与逐条扫描路由的线性匹配（加锁）做对比。
+ *          用法: ./router_bench [路由数量=1000] [查找次数=1000000] [线程数=4]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <cstdlib>
+#include "http_server.h"
+
+using namespace stdhttps;
+
+/**
+ * @brief 线性匹配：逐条比较路由模式，与原来的路由实现相同
+ */
+class LinearRouter {
+public:
+    void add_route(HttpMethod method, const std::string& path, RequestHandler handler) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        routes_.push_back(Route{method, path, handler});
+    }
+
+    bool route_request(const HttpRequest& request, HttpResponse& response) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (const auto& route : routes_) {
+            if (route.method == request.get_method() && match_path(route.path, request.get_path())) {
+                lock.unlock();
+                route.handler(request, response);
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Route {
+        HttpMethod method;
+        std::string path;
+        RequestHandler handler;
+    };
+
+    static bool match_path(const std::string& pattern, const std::string& path) {
+        if (pattern == path) {
+            return true;
+        }
+        size_t star_pos = pattern.find('*');
+        if (star_pos == std::string::npos) {
+            return false;
+        }
+        std::string prefix = pattern.substr(0, star_pos);
+        if (path.compare(0, prefix.size(), prefix) != 0) {
+            return false;
+        }
+        std::string suffix = pattern.substr(star_pos + 1);
+        return path.size() >= suffix.size() &&
+               path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    std::vector<Route> routes_;
+    std::mutex mutex_;
+};
+
+static const char* kResources[] = {
+    "users", "orders", "products", "invoices", "payments", "shipments", "reviews", "carts",
+    "coupons", "stores", "employees", "reports", "tickets", "messages", "files", "events"
+};
+
+/**
+ * @brief 生成路由：第i条路由形如 /api/v{n}/{resource}{k}[/:id[/items[/:item_id]]]
+ * @param count 路由数量
+ * @param radix_patterns 基数树版本使用 :param，线性版本只能用静态路径和*代替
+ * @param requests 输出：能命中每条路由的请求路径
+ */
+static std::vector<std::pair<HttpMethod, std::string>> make_routes(
+    size_t count, bool radix_patterns, std::vector<std::pair<HttpMethod, std::string>>* requests) {
+    static const HttpMethod methods[] = { HttpMethod::GET, HttpMethod::POST, HttpMethod::PUT, HttpMethod::DELETE };
+    std::vector<std::pair<HttpMethod, std::string>> routes;
+
+    for (size_t i = 0; i < count; ++i) {
+        std::string base = "/api/v" + std::to_string(i % 3 + 1) + "/" +
+                           kResources[i % 16] + std::to_string(i / 48);
+        HttpMethod method = methods[(i / 16) % 4];
+        std::string pattern;
+        std::string request;
+
+        switch (i % 4) {
+            case 0:
+                pattern = base;
+                request = base;
+                break;
+            case 1:
+                pattern = radix_patterns ? base + "/:id" : base + "/*";
+                request = base + "/12345";
+                break;
+            case 2:
+                pattern = radix_patterns ? base + "/:id/items/:item_id" : base + "/*";
+                request = base + "/12345/items/678";
+                break;
+            default:
+                pattern = radix_patterns ? base + "/files/*path" : base + "/files/*";
+                request = base + "/files/2024/report.pdf";
+                break;
+        }
+        routes.emplace_back(method, pattern);
+        if (requests) {
+            requests->emplace_back(method, request);
+        }
+    }
+    return routes;
+}
+
+/**
+ * @brief 多个线程同时查找，返回平均每次查找的纳秒数
+ * @details 路由时会把路径参数写入请求，每个线程使用自己的请求对象
+ */
+template <typename Router>
+static double run(Router& router, const std::vector<std::pair<HttpMethod, std::string>>& targets,
+                  size_t lookups, size_t threads) {
+    std::vector<std::vector<HttpRequest>> requests(threads);
+    for (auto& thread_requests : requests) {
+        thread_requests.reserve(targets.size());
+        for (const auto& target : targets) {
+            thread_requests.emplace_back(target.first, target.second);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&router, &requests, lookups, threads, t]() {
+            const std::vector<HttpRequest>& thread_requests = requests[t];
+            HttpResponse response;
+            size_t per_thread = lookups / threads;
+            size_t index = t * 7919;
+            for (size_t i = 0; i < per_thread; ++i) {
+                index = (index + 104729) % thread_requests.size();
+                if (!router.route_request(thread_requests[index], response)) {
+                    std::cerr << "没有匹配: " << thread_requests[index].get_path() << std::endl;
+                    std::exit(1);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return ns / lookups * threads; // 每个线程看到的单次查找耗时
+}
+
+int main(int argc, char* argv[]) {
+    size_t route_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    size_t lookups = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+    size_t threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 4;
+
+    std::vector<std::pair<HttpMethod, std::string>> targets;
+    auto radix_routes = make_routes(route_count, true, &targets);
+    auto linear_routes = make_routes(route_count, false, nullptr);
+
+    RequestHandler handler = [](const HttpRequest&, HttpResponse&) {};
+
+    HttpRouter router;
+    auto build_start = std::chrono::steady_clock::now();
+    for (const auto& route : radix_routes) {
+        router.add_route(route.first, route.second, handler);
+    }
+    double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build_start).count();
+
+    LinearRouter linear;
+    for (const auto& route : linear_routes) {
+        linear.add_route(route.first, route.second, handler);
+    }
+
+    std::cout << "路由数量: " << route_count << "，查找次数: " << lookups
+              << "，逐条添加路由并重新编译共用时 " << std::fixed << std::setprecision(1)
+              << build_ms << " ms" << std::endl;
+
+    for (size_t t : { static_cast<size_t>(1), threads }) {
+        double radix_ns = run(router, targets, lookups, t);
+        double linear_ns = run(linear, targets, lookups / 20 + 1, t);
+        std::cout << "线程数 " << t
+                  << "  基数树 " << std::setw(8) << radix_ns << " ns/次"
+                  << "  线性扫描 " << std::setw(8) << linear_ns << " ns/次"
+                  << "  加速 " << std::setw(6) << linear_ns / radix_ns << "x" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,199 @@
+/**
+ * @file router_test.cpp
+ * @brief HTTP路由测试程序
+ */
+
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include "http_server.h"
+
+using namespace stdhttps;
+
+/**
+ * @brief 路由一个请求，返回处理器写入的响应体，没有匹配返回"<none>"
+ */
+static std::string route(HttpRouter& router, HttpMethod method, const std::string& uri,
+                         HttpRequest* out_request = nullptr) {
+    HttpRequest request(method, uri);
+    HttpResponse response;
+    if (!router.route_request(request, response)) {
+        return "<none>";
+    }
+    if (out_request) {
+        out_request->set_path_params(request.get_path_params());
+    }
+    return response.get_body();
+}
+
+static RequestHandler reply(const std::string& body) {
+    return [body](const HttpRequest&, HttpResponse& response) {
+        response.set_body(body);
+    };
+}
+
+void test_static_routes() {
+    std::cout << "测试静态路由..." << std::endl;
+
+    HttpRouter router;
+    router.get("/", reply("root"));
+    router.get("/api/users", reply("users"));
+    router.get("/api/user", reply("user"));
+    router.get("/api/orders", reply("orders"));
+    router.post("/api/users", reply("create"));
+
+    assert(route(router, HttpMethod::GET, "/") == "root");
+    assert(route(router, HttpMethod::GET, "/api/users") == "users");
+    assert(route(router, HttpMethod::GET, "/api/user") == "user");
+    assert(route(router, HttpMethod::GET, "/api/orders") == "orders");
+    assert(route(router, HttpMethod::POST, "/api/users") == "create");
+    assert(route(router, HttpMethod::GET, "/api/users?page=2") == "users");
+    assert(route(router, HttpMethod::GET, "/api/use") == "<none>");
+    assert(route(router, HttpMethod::GET, "/api/users/") == "<none>");
+    assert(route(router, HttpMethod::PUT, "/api/users") == "<none>");
+    assert(router.route_count() == 5);
+
+    std::cout << "静态路由测试通过！" << std::endl;
+}
+
+void test_path_params() {
+    std::cout << "测试路径参数..." << std::endl;
+
+    HttpRouter router;
+    router.get("/users/:id", reply("user"));
+    router.get("/users/new", reply("new"));
+    router.get("/users/:id/posts/:post_id", reply("post"));
+    router.get("/users/:uid/friends", reply("friends"));
+
+    HttpRequest request;
+    assert(route(router, HttpMethod::GET, "/users/42", &request) == "user");
+    assert(request.get_path_param("id") == "42");
+
+    // 静态优先于参数
+    assert(route(router, HttpMethod::GET, "/users/new", &request) == "new");
+    assert(request.get_path_params().empty());
+
+    assert(route(router, HttpMethod::GET, "/users/7/posts/99", &request) == "post");
+    assert(request.get_path_param("id") == "7");
+    assert(request.get_path_param("post_id") == "99");
+
+    // 同一位置的参数名可以不同
+    assert(route(router, HttpMethod::GET, "/users/7/friends", &request) == "friends");
+    assert(request.get_path_param("uid") == "7");
+    assert(request.get_path_param("id").empty());
+
+    // 参数不能为空，也不能跨越'/'
+    assert(route(router, HttpMethod::GET, "/users/") == "<none>");
+    assert(route(router, HttpMethod::GET, "/users/7/8") == "<none>");
+
+    std::cout << "路径参数测试通过！" << std::endl;
+}
+
+void test_wildcards() {
+    std::cout << "测试通配符..." << std::endl;
+
+    HttpRouter router;
+    router.get("/static/*path", reply("static"));
+    router.get("/static/css/main.css", reply("main"));
+    router.get("/img/*.png", reply("png"));
+    router.get("/img/*", reply("img"));
+    router.get("/files/:bucket/*key", reply("file"));
+
+    HttpRequest request;
+    assert(route(router, HttpMethod::GET, "/static/js/app.js", &request) == "static");
+    assert(request.get_path_param("path") == "js/app.js");
+    assert(route(router, HttpMethod::GET, "/static/", &request) == "static");
+    assert(request.get_path_param("path").empty());
+
+    // 静态优先于通配符
+    assert(route(router, HttpMethod::GET, "/static/css/main.css") == "main");
+    assert(route(router, HttpMethod::GET, "/static/css/other.css") == "static");
+
+    // 带后缀的通配符优先
+    assert(route(router, HttpMethod::GET, "/img/a/b.png", &request) == "png");
+    assert(request.get_path_param("*") == "a/b");
+    assert(route(router, HttpMethod::GET, "/img/a/b.jpg") == "img");
+
+    assert(route(router, HttpMethod::GET, "/files/photos/2024/01/a.jpg", &request) == "file");
+    assert(request.get_path_param("bucket") == "photos");
+    assert(request.get_path_param("key") == "2024/01/a.jpg");
+
+    std::cout << "通配符测试通过！" << std::endl;
+}
+
+void test_default_and_duplicates() {
+    std::cout << "测试默认处理器和重复路由..." << std::endl;
+
+    HttpRouter router;
+    router.get("/a", reply("first"));
+    router.get("/a", reply("second"));
+    assert(route(router, HttpMethod::GET, "/a") == "first");
+    assert(route(router, HttpMethod::GET, "/b") == "<none>");
+
+    router.set_default_handler(reply("default"));
+    assert(route(router, HttpMethod::GET, "/b") == "default");
+    assert(route(router, HttpMethod::DELETE, "/a") == "default");
+
+    std::cout << "默认处理器和重复路由测试通过！" << std::endl;
+}
+
+void test_concurrent_updates() {
+    std::cout << "测试并发修改路由..." << std::endl;
+
+    HttpRouter router;
+    router.get("/stable/:id", reply("stable"));
+
+    // 读线程不停地查找，同时写线程不停地添加路由（包括在处理器中添加）
+    std::atomic<bool> stop(false);
+    std::atomic<long> lookups(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 3; ++i) {
+        readers.emplace_back([&]() {
+            while (!stop) {
+                assert(route(router, HttpMethod::GET, "/stable/1") == "stable");
+                ++lookups;
+            }
+        });
+    }
+
+    router.get("/nested", [&router](const HttpRequest&, HttpResponse& response) {
+        router.get("/added/in/handler", reply("added"));
+        response.set_body("nested");
+    });
+    for (int i = 0; i < 200; ++i) {
+        router.get("/dynamic/" + std::to_string(i) + "/:x", reply(std::to_string(i)));
+    }
+    assert(route(router, HttpMethod::GET, "/nested") == "nested");
+
+    stop = true;
+    for (auto& thread : readers) {
+        thread.join();
+    }
+
+    assert(lookups > 0);
+    assert(route(router, HttpMethod::GET, "/added/in/handler") == "added");
+    assert(route(router, HttpMethod::GET, "/dynamic/123/y") == "123");
+
+    std::cout << "并发修改路由测试通过！" << std::endl;
+}
+
+int main() {
+    std::cout << "运行HTTP路由测试..." << std::endl;
+
+    try {
+        test_static_routes();
+        test_path_params();
+        test_wildcards();
+        test_default_and_duplicates();
+        test_concurrent_updates();
+
+        std::cout << "所有测试通过！" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "测试失败: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,219 @@
+/**
+ * @file ssl_session_test.cpp
+ * @brief SSL会话复用测试程序
+ * @details 客户端通过连接池反复连接本进程内的HTTPS服务器，每个请求之后关闭连接，
+ *          检查除第一次之外的握手都复用了会话（session ticket和会话缓存两种方式，
+ *          TLS 1.2和TLS 1.3），以及ticket密钥轮换之后旧ticket仍然可以复用。
+ */
+
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <ctime>
+#include <unistd.h>
+#include <openssl/ssl.h>
+#include "http_server.h"
+#include "connection_pool.h"
+#include "ssl_handler.h"
+
+using namespace stdhttps;
+
+static const char* kCertFile = "ssl_session_test.crt";
+static const char* kKeyFile = "ssl_session_test.key";
+static const int kReconnects = 20;
+
+static int next_port() {
+    static int port = 10000 + getpid() % 20000;
+    return port++;
+}
+
+/**
+ * @brief 建立一个新连接完成一个请求，然后关闭连接
+ * @return 是否收到了响应
+ */
+static bool request_once(ConnectionPool& pool, int port) {
+    auto connection = pool.get_connection("127.0.0.1", port, true, std::chrono::seconds(5));
+    if (!connection) {
+        return false;
+    }
+    bool ok = connection->send("GET /ping HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n");
+
+    // 读到完整的响应体，TLS 1.3的session ticket在握手之后和响应一起收到
+    std::string response;
+    char buffer[4096];
+    while (ok && response.find("pong") == std::string::npos) {
+        int n = connection->receive(buffer, sizeof(buffer), std::chrono::seconds(5));
+        if (n < 0) {
+            ok = false;
+        } else {
+            response.append(buffer, n);
+        }
+    }
+    pool.return_connection(connection, false);
+    return ok;
+}
+
+static uint64_t average(uint64_t total_us, size_t count) {
+    return count ? total_us / count : 0;
+}
+
+/**
+ * @brief 反复重连，检查服务器和客户端看到的握手统计：只有第一次是完整握手
+ * @param name 输出的名字
+ * @param protocol 协议版本
+ * @param tickets 服务器是否签发session ticket
+ * @param rotate 是否每5次连接轮换一次ticket密钥
+ */
+static void check_reconnects(const std::string& name, const std::string& protocol, bool tickets, bool rotate) {
+    HttpServerConfig config;
+    config.bind_address = "127.0.0.1";
+    config.port = next_port();
+    config.worker_threads = 2;
+    config.enable_ssl = true;
+    config.ssl_config.cert_file = kCertFile;
+    config.ssl_config.key_file = kKeyFile;
+    config.ssl_config.verify_peer = false;
+    config.ssl_config.protocol_version = protocol;
+    config.ssl_config.enable_session_tickets = tickets;
+
+    HttpServer server(config);
+    server.get("/ping", [](const HttpRequest&, HttpResponse& response) {
+        response = HttpResponse::create_ok("pong", "text/plain");
+    });
+    bool started = server.start();
+    assert(started);
+    (void)started;
+
+    SSLConfig client_config;
+    client_config.verify_peer = false;
+    client_config.verify_hostname = false;
+    auto pool = ConnectionPoolFactory::create_https_pool(client_config);
+
+    for (int i = 0; i < kReconnects; ++i) {
+        bool responded = request_once(*pool, config.port);
+        assert(responded);
+        (void)responded;
+        if (rotate && i % 5 == 0) {
+            server.get_ssl_context()->rotate_ticket_keys();
+        }
+    }
+
+    SSLHandshakeStats server_stats = server.get_ssl_context()->get_handshake_stats();
+    ConnectionStats client_stats = pool->get_stats();
+    pool->stop();
+    server.stop();
+
+    std::cout << name << ": 客户端 " << client_stats.ssl_resumed_handshakes << "/"
+              << client_stats.ssl_handshakes << " 次复用，服务器完整握手平均 "
+              << average(server_stats.full_handshake_us, server_stats.full_handshakes)
+              << " us，复用握手平均 "
+              << average(server_stats.resumed_handshake_us, server_stats.resumed_handshakes)
+              << " us" << std::endl;
+
+    assert(client_stats.ssl_handshakes == static_cast<size_t>(kReconnects));
+    assert(server_stats.total_handshakes() == static_cast<size_t>(kReconnects));
+    assert(server_stats.failed_handshakes == 0);
+    assert(client_stats.ssl_resumed_handshakes == static_cast<size_t>(kReconnects - 1));
+    assert(server_stats.resumed_handshakes == static_cast<size_t>(kReconnects - 1));
+    assert(server_stats.resumption_rate() > 0.9);
+}
+
+void test_session_cache() {
+    std::cout << "测试会话缓存..." << std::endl;
+
+    SSLSessionCache cache(2);
+    SSL_SESSION* a = SSL_SESSION_new();
+    SSL_SESSION* b = SSL_SESSION_new();
+    SSL_SESSION* c = SSL_SESSION_new();
+    for (SSL_SESSION* session : { a, b, c }) {
+        SSL_SESSION_set_time(session, std::time(nullptr));
+        SSL_SESSION_set_timeout(session, 300);
+    }
+
+    cache.put("a", a);
+    cache.put("b", b);
+    SSL_SESSION* found = cache.get("a");
+    assert(found == a);
+    SSL_SESSION_free(found);
+
+    // 容量为2，淘汰最久未使用的b
+    cache.put("c", c);
+    assert(cache.size() == 2);
+    assert(cache.get("b") == nullptr);
+    found = cache.get("c");
+    assert(found == c);
+    SSL_SESSION_free(found);
+
+    // 同一个键替换
+    cache.put("a", b);
+    found = cache.get("a");
+    assert(found == b);
+    SSL_SESSION_free(found);
+
+    // 过期的会话在查找时丢弃
+    SSL_SESSION_set_time(c, std::time(nullptr) - 600);
+    assert(cache.get("c") == nullptr);
+    assert(cache.size() == 1);
+
+    cache.remove("a");
+    assert(cache.size() == 0);
+
+    SSL_SESSION_free(a);
+    SSL_SESSION_free(b);
+    SSL_SESSION_free(c);
+
+    std::cout << "会话缓存测试通过！" << std::endl;
+}
+
+void test_ticket_resumption() {
+    std::cout << "测试session ticket复用..." << std::endl;
+
+    check_reconnects("TLS 1.3 ticket", "TLSv1.3", true, false);
+    check_reconnects("TLS 1.2 ticket", "TLSv1.2", true, false);
+
+    std::cout << "session ticket复用测试通过！" << std::endl;
+}
+
+void test_ticket_key_rotation() {
+    std::cout << "测试ticket密钥轮换..." << std::endl;
+
+    // 每5次连接轮换一次密钥，旧密钥签发的ticket在有效期内仍然可以复用
+    check_reconnects("TLS 1.3 ticket（轮换密钥）", "TLSv1.3", true, true);
+    check_reconnects("TLS 1.2 ticket（轮换密钥）", "TLSv1.2", true, true);
+
+    std::cout << "ticket密钥轮换测试通过！" << std::endl;
+}
+
+void test_cache_resumption() {
+    std::cout << "测试服务器会话缓存复用..." << std::endl;
+
+    // 不签发ticket时，服务器按会话ID从共享缓存中查找会话
+    check_reconnects("TLS 1.3 会话缓存", "TLSv1.3", false, false);
+    check_reconnects("TLS 1.2 会话缓存", "TLSv1.2", false, false);
+    assert(SSLSessionCache::shared().size() > 0);
+
+    std::cout << "服务器会话缓存复用测试通过！" << std::endl;
+}
+
+int main() {
+    std::cout << "运行SSL会话复用测试..." << std::endl;
+
+    try {
+        bool generated = SSLUtils::generate_self_signed_cert(kCertFile, kKeyFile);
+        assert(generated);
+        (void)generated;
+
+        test_session_cache();
+        test_ticket_resumption();
+        test_ticket_key_rotation();
+        test_cache_resumption();
+
+        unlink(kCertFile);
+        unlink(kKeyFile);
+        std::cout << "所有测试通过！" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "测试失败: " << e.what() << std::endl;
+        return 1;
+    }
+}